@@ -0,0 +1,101 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmark for the octree ray integration backend in FCLFunctions.
+// Usage: octree_benchmark [num_points] [resolution] [repetitions] [world_model_mode]
+// Prints the median time to build a collision octree for 1 to N threads.
+// world_model_mode is one of ray_casting (default), occupied_only and occluded_occupied.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "emd/common/fcl_functions.hpp"
+
+namespace
+{
+/*! \brief Synthetic bin scene: a table plane with random boxes on top, seen from the origin */
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr generateScene(size_t num_points)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
+  std::mt19937 generator(42);
+  std::uniform_real_distribution<float> table_x(-0.4, 0.4);
+  std::uniform_real_distribution<float> table_y(-0.3, 0.3);
+  std::uniform_real_distribution<float> box_height(0.0, 0.15);
+  std::uniform_real_distribution<float> noise(-0.002, 0.002);
+  for (size_t i = 0; i < num_points; i++) {
+    pcl::PointXYZRGB point;
+    point.x = table_x(generator);
+    point.y = table_y(generator);
+    // Boxes on a 0.2 m grid cover a quarter of the table
+    bool on_box = std::fmod(std::abs(point.x), 0.2f) < 0.1f &&
+      std::fmod(std::abs(point.y), 0.2f) < 0.1f;
+    point.z = 0.7f - (on_box ? box_height(generator) : 0.0f) + noise(generator);
+    cloud->points.push_back(point);
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+  return cloud;
+}
+}  // namespace
+
+int main(int argc, char * argv[])
+{
+  const size_t num_points = argc > 1 ? std::stoul(argv[1]) : 300000;
+  const float resolution = argc > 2 ? std::stof(argv[2]) : 0.01;
+  const int repetitions = argc > 3 ? std::stoi(argv[3]) : 5;
+  const FCLFunctions::IntegrationMode mode = FCLFunctions::getIntegrationMode(
+    argc > 4 ? argv[4] : "ray_casting");
+  const unsigned int max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud = generateScene(num_points);
+  octomap::point3d sensor_origin(0, 0, 0);
+
+  std::cout << "Points: " << num_points << ", resolution: " << resolution <<
+    ", repetitions: " << repetitions <<
+    ", mode: " << (argc > 4 ? argv[4] : "ray_casting") << std::endl;
+  std::cout << std::setw(8) << "threads" << std::setw(14) << "median (ms)" <<
+    std::setw(10) << "speedup" << std::endl;
+
+  double single_thread_ms = 0;
+  for (unsigned int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+    std::vector<double> times;
+    for (int i = 0; i < repetitions; i++) {
+      auto start = std::chrono::steady_clock::now();
+      auto collision_object = FCLFunctions::createCollisionObjectFromPointCloudRGB(
+        cloud, sensor_origin, resolution, num_threads, mode, 0.05);
+      auto end = std::chrono::steady_clock::now();
+      times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    double median_ms = times[times.size() / 2];
+    if (num_threads == 1) {
+      single_thread_ms = median_ms;
+    }
+    std::cout << std::setw(8) << num_threads << std::setw(14) << std::fixed <<
+      std::setprecision(1) << median_ms << std::setw(10) << std::setprecision(2) <<
+      single_thread_ms / median_ms << std::endl;
+    if (num_threads < max_threads && num_threads * 2 > max_threads) {
+      num_threads = max_threads / 2;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__CONTACT_RASTER_HPP_
+#define EMD__GRASP_PLANNER__COMMON__CONTACT_RASTER_HPP_
+
+#include <Eigen/Core>
+
+// Other Libraries
+#include <cstddef>
+#include <vector>
+
+namespace grasp_planner
+{
+
+/*! \brief Raster of points projected on a plane, with summed area tables of the number of
+ * points and of their curvature in each cell. A disc filter over the tables, computed once
+ * for a fixed radius, gives the number of points and their curvature sum within that radius
+ * of any cell in a single lookup, so that suction cups can be evaluated at a constant cost
+ * each however many are placed on the same slice. Points and disc centers are taken at the
+ * centers of their cells. Queries are read only and may run from several threads. */
+class ContactRaster
+{
+public:
+  /*! \brief Constructor, the raster is empty until built */
+  ContactRaster();
+
+  /*! \brief Build the raster of a set of points and the disc filter for a radius */
+  bool build(
+    const std::vector<Eigen::Vector2f> & points,
+    const std::vector<float> & curvatures,
+    const float & resolution,
+    const float & radius,
+    const size_t & max_cells = 1u << 20);
+
+  /*! \brief Number of points and curvature sum of the cells with indexes in [min, max) */
+  int boxSum(
+    const Eigen::Vector2i & min, const Eigen::Vector2i & max,
+    float & curvature_sum) const;
+
+  /*! \brief Number of points and curvature sum within the radius of a disc center */
+  int discSum(const Eigen::Vector2f & center, float & curvature_sum) const;
+
+  /*! \brief Index of the cell containing a point, which may lie outside the raster */
+  Eigen::Vector2i getCell(const Eigen::Vector2f & point) const;
+
+  /*! \brief True if the raster holds no point */
+  bool empty() const;
+
+  /*! \brief Edge length of a cell */
+  float getResolution() const;
+
+  /*! \brief Radius of the disc filter */
+  float getRadius() const;
+
+  /*! \brief Number of cells along each axis */
+  Eigen::Vector2i getDims() const;
+
+private:
+  /*! \brief Compute the disc filter of the raster from the summed area tables */
+  void filterDisc();
+
+  /*! \brief Edge length of a cell */
+  float resolution;
+  /*! \brief Radius of the disc filter */
+  float radius;
+  /*! \brief Lower corner of cell (0, 0) */
+  Eigen::Vector2f origin;
+  /*! \brief Number of cells along each axis, the points are padded by the disc radius */
+  Eigen::Vector2i dims;
+  /*! \brief Number of points */
+  size_t point_count;
+  /*! \brief Summed area table of the number of points, with a leading row and column of
+   * zeros, x varies fastest */
+  std::vector<int> count_table;
+  /*! \brief Summed area table of the curvature of the points, laid out as count_table */
+  std::vector<double> curvature_table;
+  /*! \brief Number of points within the disc radius of each cell, x varies fastest */
+  std::vector<int> disc_counts;
+  /*! \brief Curvature sum of the points within the disc radius of each cell */
+  std::vector<float> disc_curvatures;
+};
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__CONTACT_RASTER_HPP_
@@ -0,0 +1,87 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__DEPTH_PROJECTION_HPP_
+#define EMD__GRASP_PLANNER__COMMON__DEPTH_PROJECTION_HPP_
+
+// Main PCL files
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+// ROS2 Libraries
+#include <sensor_msgs/msg/camera_info.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+// Other Libraries
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace grasp_planner
+{
+
+/*! \brief Back-projects depth images into point clouds using the intrinsics of a CameraInfo
+ * message. The ray of every pixel is precomputed once per camera model. */
+class DepthProjector
+{
+public:
+  /*! \brief Constructor */
+  DepthProjector();
+
+  /*! \brief Update the camera model, rebuilding the ray lookup table if it changed */
+  bool setCameraInfo(const sensor_msgs::msg::CameraInfo & camera_info);
+
+  /*! \brief Whether a camera model has been received */
+  bool hasCameraModel();
+
+  /*! \brief Back-project a depth image into a cropped point cloud */
+  bool projectDepthImage(
+    const sensor_msgs::msg::Image & depth_image,
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr output_cloud,
+    const float & ptFilter_Ulimit_x,
+    const float & ptFilter_Llimit_x,
+    const float & ptFilter_Ulimit_y,
+    const float & ptFilter_Llimit_y,
+    const float & ptFilter_Ulimit_z,
+    const float & ptFilter_Llimit_z,
+    const bool & organized);
+
+  /*! \brief Normalized image plane x coordinate of every pixel, row major */
+  std::vector<float> ray_x;
+  /*! \brief Normalized image plane y coordinate of every pixel, row major */
+  std::vector<float> ray_y;
+
+private:
+  /*! \brief Rebuild ray_x and ray_y from the current camera model */
+  void generateRayTable();
+
+  /*! \brief Guards the camera model against concurrent CameraInfo callbacks */
+  std::mutex model_mutex;
+  /*! \brief Image width of the current camera model */
+  uint32_t width;
+  /*! \brief Image height of the current camera model */
+  uint32_t height;
+  /*! \brief Intrinsic matrix of the current camera model */
+  std::array<double, 9> k;
+  /*! \brief Distortion coefficients of the current camera model */
+  std::vector<double> d;
+  /*! \brief Distortion model of the current camera model */
+  std::string distortion_model;
+};
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__DEPTH_PROJECTION_HPP_
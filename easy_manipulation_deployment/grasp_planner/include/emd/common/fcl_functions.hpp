@@ -32,7 +32,11 @@
 #include <math.h>
 #include <iostream>
 #include <cmath>
+#include <functional>
 #include <memory>
+#include <string>
+#include <thread>
+#include <vector>
 // #include "grasp_object.h"
 
 // FCL Libraries
@@ -41,15 +45,84 @@
 
 namespace FCLFunctions
 {
+/*! \brief How a point cloud is integrated into a collision octree */
+enum class IntegrationMode
+{
+  /*! \brief Cast rays from the sensor to mark free space as well as occupied cells */
+  RAY_CASTING,
+  /*! \brief Only insert the cells containing points */
+  OCCUPIED_ONLY,
+  /*! \brief Insert the cells containing points and the unknown space just behind them */
+  OCCLUDED_OCCUPIED
+};
+
+/*! \brief Axis aligned region that octree updates are restricted to */
+struct UpdateRegion
+{
+  /*! \brief Whether updates are restricted to the region */
+  bool enabled = false;
+  /*! \brief Lower corner of the region */
+  octomap::point3d min;
+  /*! \brief Upper corner of the region */
+  octomap::point3d max;
+
+  bool contains(const octomap::point3d & point) const
+  {
+    return !enabled ||
+           (point.x() >= min.x() && point.x() <= max.x() &&
+           point.y() >= min.y() && point.y() <= max.y() &&
+           point.z() >= min.z() && point.z() <= max.z());
+  }
+};
+
+/*! \brief Deduplicated cells to update in an octree, sorted in Morton order of their keys */
+struct IntegrationKeys
+{
+  /*! \brief Cells crossed by a sensor ray, not including any occupied cell */
+  std::vector<octomap::OcTreeKey> free_cells;
+  /*! \brief Cells containing a point */
+  std::vector<octomap::OcTreeKey> occupied_cells;
+};
+
+template<typename PointT>
+void computeIntegrationKeys(
+  const octomap::OcTree & octree,
+  const pcl::PointCloud<PointT> & cloud,
+  const octomap::point3d & sensor_origin,
+  const unsigned int & num_threads,
+  IntegrationKeys & keys,
+  const UpdateRegion & region = UpdateRegion(),
+  const std::function<bool(const octomap::OcTreeKey &)> & skip_ray = nullptr);
+
+template<typename PointT>
+void computeSurfaceKeys(
+  const octomap::OcTree & octree,
+  const pcl::PointCloud<PointT> & cloud,
+  const octomap::point3d & sensor_origin,
+  const unsigned int & num_threads,
+  const float & occlusion_depth,
+  IntegrationKeys & keys,
+  const UpdateRegion & region = UpdateRegion());
+
+IntegrationMode getIntegrationMode(const std::string & mode_name);
+
+void applyIntegrationKeys(octomap::OcTree & octree, const IntegrationKeys & keys);
+
 std::shared_ptr<grasp_planner::collision::CollisionObject> createCollisionObjectFromPointCloudRGB(
   const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_ptr,
   const octomap::point3d & sensor_origin_wrt_world,
-  float resolution);
+  float resolution,
+  unsigned int num_threads = std::thread::hardware_concurrency(),
+  IntegrationMode mode = IntegrationMode::RAY_CASTING,
+  float occlusion_depth = 0.0);
 
 std::shared_ptr<grasp_planner::collision::CollisionObject> createCollisionObjectFromPointCloud(
   const pcl::PointCloud<pcl::PointXYZ>::Ptr & pointcloud_ptr,
   const octomap::point3d & sensor_origin_wrt_world,
-  float resolution);
+  float resolution,
+  unsigned int num_threads = std::thread::hardware_concurrency(),
+  IntegrationMode mode = IntegrationMode::RAY_CASTING,
+  float occlusion_depth = 0.0);
 }  // namespace FCLFunctions
 
 #endif  // EMD__GRASP_PLANNER__COMMON__FCL_FUNCTIONS_HPP_
@@ -18,6 +18,8 @@
 
 // Other Libraries
 #include <Eigen/Core>
+#include <string>
+#include <vector>
 
 // For uuid
 #include "boost/uuid/uuid.hpp"
@@ -78,6 +80,10 @@ MathFunctions::Point getPointInfo(
 
 std::string generate_task_id();
 
+std::vector<size_t> getTopRankIndices(
+  const std::vector<float> & ranks,
+  const size_t & max_count);
+
 }  // namespace MathFunctions
 
 #endif  // EMD__GRASP_PLANNER__COMMON__MATH_FUNCTIONS_HPP_
@@ -0,0 +1,118 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__OCCUPANCY_GRID_HPP_
+#define EMD__GRASP_PLANNER__COMMON__OCCUPANCY_GRID_HPP_
+
+#include <Eigen/Core>
+
+// Other Libraries
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// FCL Libraries
+#include "emd/common/fcl_types.hpp"
+
+namespace grasp_planner
+{
+
+namespace collision
+{
+
+/*! \brief How finger collisions with the world are checked */
+enum class CollisionCheckMode
+{
+  /*! \brief Collide FCL spheres with the world collision object */
+  FCL,
+  /*! \brief Look spheres up in an occupancy grid of the world */
+  VOXEL,
+  /*! \brief Check with both, report disagreements and keep the FCL result */
+  VALIDATE
+};
+
+CollisionCheckMode getCollisionCheckMode(const std::string & mode_name);
+
+/*! \brief Dense bitmap of the occupied cells of a world octree at its finest resolution,
+ * built once per scene so that sphere queries are a handful of bit lookups instead of an
+ * FCL collision call. An optional Euclidean distance field over the same cells answers
+ * clearance queries and settles most sphere queries with a single lookup. Queries are read
+ * only and may run from several threads. */
+class OccupancyGrid
+{
+public:
+  /*! \brief Constructor, the grid is empty until built */
+  OccupancyGrid();
+
+  /*! \brief Build the grid from an octree collision object placed at the origin */
+  bool build(const CollisionObject & world, const size_t & max_cells = 1u << 28);
+
+  /*! \brief Compute the distance field of the grid */
+  bool computeDistanceField(const size_t & max_cells = 1u << 26);
+
+  /*! \brief True if the distance field has been computed */
+  bool hasDistanceField() const;
+
+  /*! \brief Approximate distance from a point to the nearest occupied cell */
+  float clearance(const Eigen::Vector3f & point) const;
+
+  /*! \brief Check if a sphere overlaps any occupied cell */
+  bool sphereCollides(const Eigen::Vector3f & center, const float & radius) const;
+
+  /*! \brief Check if any sphere of the same radius overlaps an occupied cell */
+  bool anySphereCollides(
+    const std::vector<Eigen::Vector3f> & centers,
+    const float & radius) const;
+
+  /*! \brief True if the grid holds no occupied cell */
+  bool empty() const;
+
+  /*! \brief Edge length of a cell */
+  float getResolution() const;
+
+  /*! \brief Number of occupied cells */
+  size_t getOccupiedCount() const;
+
+private:
+  /*! \brief Mark the cells with indexes in [min, max) as occupied */
+  void fillCells(const Eigen::Vector3i & min, const Eigen::Vector3i & max);
+
+  /*! \brief Check a sphere against every cell it reaches */
+  bool scanSphere(const Eigen::Vector3f & center, const float & radius) const;
+
+  /*! \brief Index of the cell containing a point, or -1 if it is outside the grid */
+  int64_t getCellIndex(const Eigen::Vector3f & point) const;
+
+  /*! \brief Edge length of a cell */
+  float resolution;
+  /*! \brief Lower corner of cell (0, 0, 0) */
+  Eigen::Vector3f origin;
+  /*! \brief Number of cells along each axis */
+  Eigen::Vector3i dims;
+  /*! \brief Occupancy bits, x varies fastest */
+  std::vector<uint64_t> bits;
+  /*! \brief Number of occupied cells */
+  size_t occupied_count;
+  /*! \brief Squared distance in cells from each cell center to the nearest occupied cell
+   * center, empty if the distance field was not computed */
+  std::vector<float> squared_distances;
+};
+
+}  // namespace collision
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__OCCUPANCY_GRID_HPP_
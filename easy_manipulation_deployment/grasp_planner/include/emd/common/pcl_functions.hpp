@@ -24,6 +24,7 @@
 #include <pcl/common/eigen.h>
 #include <pcl/common/common.h>
 #include <pcl/common/transforms.h>
+#include <pcl/common/io.h>
 
 // For Statistical outlier removal
 #include <pcl/filters/statistical_outlier_removal.h>
@@ -38,6 +39,7 @@
 
 // For Object Segmentation
 #include <pcl/segmentation/extract_clusters.h>
+#include <pcl/search/kdtree.h>
 
 // For Cloud Filtering
 #include <pcl/filters/passthrough.h>
@@ -59,11 +61,15 @@
 // Other Libraries
 #include <stdlib.h>
 #include <math.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <cmath>
 #include <memory>
 #include <future>
+#include <limits>
 #include <string>
+#include <thread>
 #include <vector>
 
 // EMD Libraries
@@ -82,14 +88,66 @@ bool passthroughFilter(
   const float & ptFilter_Ulimit_z,
   const float & ptFilter_Llimit_z);
 
+bool cropBoxFilter(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr output_cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const int & num_threads);
+
+bool preprocessCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const float & outlier_threshold,
+  const float & leaf_size,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr filtered_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr voxelized_cloud,
+  const int & num_threads);
+
+bool downsampleCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  const float & outlier_threshold,
+  const float & leaf_size,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr filtered_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr voxelized_cloud,
+  const int & num_threads);
+
 void SensorMsgtoPCLPointCloud2(
   const sensor_msgs::msg::PointCloud2 & pc2,
   pcl::PCLPointCloud2 & pcl_pc2);
 
+bool SensorMsgtoFilteredPointCloud(
+  const sensor_msgs::msg::PointCloud2 & pc2,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr organized_cloud = nullptr);
+
+bool planeSegmentation(
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table,
+  const int & segmentation_max_iterations,
+  const float & segmentation_distance_threshold);
+
 bool planeSegmentation(
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed,
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table,
+  pcl::ModelCoefficients & coefficients,
   const int & segmentation_max_iterations,
   const float & segmentation_distance_threshold);
 
@@ -104,11 +162,34 @@ void getClosestPointsByRadius(
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr & outputCloud,
   pcl::PointCloud<pcl::PointNormal>::Ptr & outputNormalCloud);
 
+void getClosestPointsByRadius(
+  const pcl::PointNormal & point,
+  const float & radius, pcl::PointCloud<pcl::PointXYZRGB>::Ptr & inputCloud,
+  pcl::PointCloud<pcl::PointNormal>::Ptr & inputNormalCloud,
+  const pcl::search::KdTree<pcl::PointNormal>::Ptr & normalCloudSearch,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr & outputCloud,
+  pcl::PointCloud<pcl::PointNormal>::Ptr & outputNormalCloud);
+
 void computeCloudNormal(
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
   pcl::PointCloud<pcl::PointNormal>::Ptr cloud_normal,
   const float & cloud_normal_radius);
 
+void computeCloudNormal(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud_normal,
+  const float & cloud_normal_radius,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & search,
+  const int & num_threads);
+
+void computeClusterNormal(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & search,
+  const pcl::PointIndices & cluster,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud_normal,
+  const float & cloud_normal_radius,
+  const int & num_threads);
+
 Eigen::Vector3f convertPCLNormaltoEigen(
   const pcl::PointNormal & pcl_point);
 
@@ -152,6 +233,31 @@ std::vector<pcl::PointIndices> extractPointCloudClusters(
   float cluster_tolerance,
   int min_cluster_size);
 
+std::vector<pcl::PointIndices> extractPointCloudClusters(
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  float cluster_tolerance,
+  int min_cluster_size,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & tree);
+
+std::vector<pcl::PointIndices> extractOrganizedClusters(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const std::vector<float> & plane_coefficients,
+  const float & plane_distance_threshold,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const float & cluster_tolerance,
+  const int & min_cluster_size,
+  const float & max_normal_angle);
+
+std::vector<std::vector<int>> selectWithinDistanceOfPlanes(
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud,
+  const std::vector<Eigen::Vector4f> & planes,
+  const float & threshold);
+
 
 }  // namespace PCLFunctions
 
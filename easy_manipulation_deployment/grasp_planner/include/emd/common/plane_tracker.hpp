@@ -0,0 +1,90 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__PLANE_TRACKER_HPP_
+#define EMD__GRASP_PLANNER__COMMON__PLANE_TRACKER_HPP_
+
+// Main PCL files
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/ModelCoefficients.h>
+#include <pcl/PointIndices.h>
+
+// Other Libraries
+#include <random>
+
+namespace grasp_planner
+{
+
+/*! \brief Tracks the support plane of the scene across point clouds. The plane of the previous
+ * cloud is validated on a random subsample of each new cloud, and RANSAC is only run when the
+ * validation fails, constrained to planes parallel to the previous one when there is one. */
+class PlaneTracker
+{
+public:
+  /*! \brief Constructor */
+  PlaneTracker();
+
+  /*! \brief Set the number of points sampled to validate the previous plane, and the share of
+   * the inlier ratio measured when the plane was fitted that the sample has to reach */
+  void setValidation(const int & sample_size, const float & min_inlier_ratio);
+
+  /*! \brief Split a cloud into the support plane and the rest, updating the tracked plane */
+  bool segment(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed,
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table,
+    pcl::ModelCoefficients & coefficients,
+    const int & segmentation_max_iterations,
+    const float & segmentation_distance_threshold);
+
+  /*! \brief Whether a plane is being tracked */
+  bool hasPlane() const;
+
+  /*! \brief Whether the plane of the last segmented cloud came from the previous plane */
+  bool lastPlaneTracked() const;
+
+  /*! \brief Forget the tracked plane */
+  void reset();
+
+private:
+  /*! \brief Fit a plane with RANSAC, optionally constrained to the orientation of the prior */
+  bool fitPlane(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+    const int & segmentation_max_iterations,
+    const float & segmentation_distance_threshold,
+    const bool & use_prior,
+    pcl::PointIndices & inliers,
+    pcl::ModelCoefficients & coefficients);
+
+  /*! \brief Plane coefficients ax + by + cz + d = 0 with a unit normal */
+  float plane[4];
+  /*! \brief Whether plane holds a tracked plane */
+  bool has_plane;
+  /*! \brief Whether the plane of the last segmented cloud came from the previous plane */
+  bool last_plane_tracked;
+  /*! \brief Inlier ratio of the cloud the plane was fitted to with RANSAC */
+  float fitted_inlier_ratio;
+  /*! \brief Number of points sampled to validate the previous plane */
+  int validation_sample_size;
+  /*! \brief Share of fitted_inlier_ratio a validation sample has to reach */
+  float validation_min_inlier_ratio;
+  /*! \brief Random generator for validation samples */
+  std::mt19937 generator;
+};
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__PLANE_TRACKER_HPP_
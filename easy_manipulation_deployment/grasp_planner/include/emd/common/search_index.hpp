@@ -0,0 +1,129 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__SEARCH_INDEX_HPP_
+#define EMD__GRASP_PLANNER__COMMON__SEARCH_INDEX_HPP_
+
+// Main PCL files
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+#include <pcl/search/kdtree.h>
+
+// Other Libraries
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace grasp_planner
+{
+
+/*! \brief KD-tree over a point cloud that is built on first use and reused by later queries.
+ * The tree is rebuilt when a different cloud is requested, or when the size of the indexed
+ * cloud has changed. Call reset() after changing points of the indexed cloud in place.
+ * Copies start out empty, since the tree is a cache and not part of the owner's value. */
+template<typename PointT>
+class SearchIndex
+{
+public:
+  SearchIndex() = default;
+  SearchIndex(const SearchIndex &) {}
+  SearchIndex & operator=(const SearchIndex &)
+  {
+    reset();
+    return *this;
+  }
+
+  /*! \brief Get the search tree for a cloud, building it if needed. Thread safe */
+  typename pcl::search::KdTree<PointT>::Ptr getSearch(
+    const typename pcl::PointCloud<PointT>::Ptr & cloud)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!search || indexed_cloud != cloud || indexed_size != cloud->size()) {
+      typename pcl::search::KdTree<PointT>::Ptr new_search(new pcl::search::KdTree<PointT>());
+      new_search->setInputCloud(cloud);
+      search = new_search;
+      indexed_cloud = cloud;
+      indexed_size = cloud->size();
+    }
+    return search;
+  }
+
+  /*! \brief Drop the search tree so that the next query rebuilds it */
+  void reset()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    search.reset();
+    indexed_cloud.reset();
+    indexed_size = 0;
+  }
+
+private:
+  /*! \brief Guards lazy construction of the tree */
+  std::mutex mutex;
+  /*! \brief Search tree, shared with callers so that a rebuild does not invalidate it */
+  typename pcl::search::KdTree<PointT>::Ptr search;
+  /*! \brief Cloud the tree was built on */
+  typename pcl::PointCloud<PointT>::ConstPtr indexed_cloud;
+  /*! \brief Size of the cloud when the tree was built */
+  size_t indexed_size = 0;
+};
+
+/*! \brief Set of lazily built KD-trees over a number of clouds, such as the sample clouds
+ * derived from one object. Each tree keeps its cloud alive until clear() is called. */
+template<typename PointT>
+class SearchIndexCache
+{
+public:
+  SearchIndexCache() = default;
+  SearchIndexCache(const SearchIndexCache &) {}
+  SearchIndexCache & operator=(const SearchIndexCache &)
+  {
+    clear();
+    return *this;
+  }
+
+  /*! \brief Get the search tree for a cloud, building it if needed. Thread safe */
+  typename pcl::search::KdTree<PointT>::Ptr getSearch(
+    const typename pcl::PointCloud<PointT>::Ptr & cloud)
+  {
+    std::shared_ptr<SearchIndex<PointT>> index;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      std::shared_ptr<SearchIndex<PointT>> & cached_index = indices[cloud.get()];
+      if (!cached_index) {
+        cached_index = std::make_shared<SearchIndex<PointT>>();
+      }
+      index = cached_index;
+    }
+    return index->getSearch(cloud);
+  }
+
+  /*! \brief Drop all search trees */
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    indices.clear();
+  }
+
+private:
+  /*! \brief Guards indices */
+  std::mutex mutex;
+  /*! \brief Search index of each cloud */
+  std::map<const pcl::PointCloud<PointT> *, std::shared_ptr<SearchIndex<PointT>>> indices;
+};
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__SEARCH_INDEX_HPP_
@@ -0,0 +1,105 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__THREAD_POOL_HPP_
+#define EMD__GRASP_PLANNER__COMMON__THREAD_POOL_HPP_
+
+// Other Libraries
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace grasp_planner
+{
+
+/*! \brief Fixed set of worker threads that run parallel loops. A thread waiting for a loop
+ * runs iterations of it as well, so loops can be nested inside loop bodies without
+ * deadlocking and without starting more threads than the pool holds. */
+class ThreadPool
+{
+public:
+  /*! \brief Constructor, 0 threads uses one per hardware thread */
+  explicit ThreadPool(const int & num_threads);
+
+  /*! \brief Destructor, joins the workers */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool & operator=(const ThreadPool &) = delete;
+
+  /*! \brief Number of threads that run loop iterations, including the calling thread */
+  std::size_t size() const;
+
+  /*! \brief Run task(i) for every i in [begin, end) and return once all have finished.
+   * The first exception thrown by a task is rethrown after the loop. */
+  void parallelFor(
+    const std::size_t & begin, const std::size_t & end,
+    const std::function<void(std::size_t)> & task);
+
+  /*! \brief Pool shared by the whole process */
+  static std::shared_ptr<ThreadPool> global();
+
+  /*! \brief Resize the pool shared by the whole process, 0 uses one per hardware thread.
+   * Loops already running keep the pool they started on. */
+  static void setGlobalThreads(const int & num_threads);
+
+private:
+  /*! \brief State of a single parallel loop */
+  struct Loop
+  {
+    /*! \brief Loop body */
+    const std::function<void(std::size_t)> * task;
+    /*! \brief Next iteration to be claimed */
+    std::atomic<std::size_t> next;
+    /*! \brief End of the iteration range */
+    std::size_t end;
+    /*! \brief Number of iterations left to finish */
+    std::atomic<std::size_t> remaining;
+    /*! \brief First exception thrown by an iteration */
+    std::exception_ptr error;
+    /*! \brief Guards error and signals completion */
+    std::mutex mutex;
+    /*! \brief Notified when the last iteration finishes */
+    std::condition_variable finished;
+  };
+
+  /*! \brief Claim and run one iteration of a loop, false if there are none left */
+  static bool runIteration(Loop & loop);
+
+  /*! \brief Worker thread body */
+  void workerLoop();
+
+  /*! \brief Worker threads, one less than size() */
+  std::vector<std::thread> workers;
+  /*! \brief Loops with iterations left to claim */
+  std::deque<std::shared_ptr<Loop>> loops;
+  /*! \brief Guards loops and stop */
+  std::mutex mutex;
+  /*! \brief Notified when a loop is queued or the pool stops */
+  std::condition_variable work_available;
+  /*! \brief Set when the pool is destroyed */
+  bool stop;
+};
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__THREAD_POOL_HPP_
@@ -0,0 +1,102 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef EMD__GRASP_PLANNER__COMMON__WORLD_MODEL_HPP_
+#define EMD__GRASP_PLANNER__COMMON__WORLD_MODEL_HPP_
+
+// Main PCL files
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+#include <octomap/octomap.h>
+
+// Other Libraries
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// FCL Libraries
+#include "emd/common/fcl_types.hpp"
+
+namespace grasp_planner
+{
+
+namespace collision
+{
+
+/*! \brief Long lived occupancy map of the scene that is updated incrementally with every new
+ * point cloud, and exposed as a single FCL collision object that is refreshed in place. */
+class WorldModel
+{
+public:
+  /*! \brief Constructor */
+  explicit WorldModel(const float & resolution);
+
+  /*! \brief Restrict map updates to an axis aligned region */
+  void setUpdateRegion(const octomap::point3d & region_min, const octomap::point3d & region_max);
+
+  /*! \brief Set the log odds that unobserved occupied cells in the update region decay by */
+  void setDecay(const float & decay);
+
+  /*! \brief Integrate a point cloud into the map */
+  size_t integratePointCloud(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+    const octomap::point3d & sensor_origin,
+    const unsigned int & num_threads = std::thread::hardware_concurrency());
+
+  /*! \brief Clear the map */
+  void reset();
+
+  /*! \brief Resolution of the map */
+  float getResolution() const;
+
+  /*! \brief Collision object of the map, the same object is returned after every update */
+  std::shared_ptr<CollisionObject> getCollisionObject() const;
+
+  /*! \brief Occupancy map */
+  std::shared_ptr<octomap::OcTree> octree;
+  /*! \brief Keys of the cells whose occupancy changed in the last update */
+  std::vector<octomap::OcTreeKey> changed_keys;
+
+private:
+  /*! \brief FCL wrapper around octree */
+  std::shared_ptr<OcTree> fcl_octree;
+  /*! \brief Collision object around fcl_octree */
+  std::shared_ptr<CollisionObject> collision_object;
+  /*! \brief Sensor origin of the last update, used to detect camera motion */
+  octomap::point3d last_sensor_origin;
+  /*! \brief Whether any cloud has been integrated since the last reset */
+  bool initialized;
+  /*! \brief Whether updates are restricted to the update region */
+  bool use_update_region;
+  /*! \brief Lower corner of the update region */
+  octomap::point3d update_region_min;
+  /*! \brief Upper corner of the update region */
+  octomap::point3d update_region_max;
+  /*! \brief Log odds decay applied to unobserved occupied cells every update */
+  float decay;
+  /*! \brief Consecutive updates a ray is cast for the same surface cell */
+  unsigned int rays_per_surface;
+  /*! \brief Number of consecutive updates each surface cell has been observed in */
+  std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash>
+  observation_counts;
+};
+
+}  // namespace collision
+
+}  // namespace grasp_planner
+
+#endif  // EMD__GRASP_PLANNER__COMMON__WORLD_MODEL_HPP_
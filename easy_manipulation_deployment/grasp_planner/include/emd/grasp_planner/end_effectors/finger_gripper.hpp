@@ -23,6 +23,7 @@
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
 #include <pcl/common/common.h>
+#include <pcl/common/io.h>
 #include <pcl/common/transforms.h>
 #include <pcl/sample_consensus/sac_model_plane.h>
 
@@ -41,9 +42,11 @@
 // Other Libraries
 #include <math.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <cmath>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -51,10 +54,13 @@
 
 // For Multithreading
 #include <future>
+#include "emd/common/thread_pool.hpp"
 
 // EMD libraries
 #include "emd/common/pcl_functions.hpp"
 #include "emd/common/fcl_functions.hpp"
+#include "emd/common/occupancy_grid.hpp"
+#include "emd/common/search_index.hpp"
 #include "emd/common/math_functions.hpp"
 #include "emd/common/pcl_visualizer.hpp"
 #include "emd/grasp_planner/end_effectors/end_effector.hpp"
@@ -122,9 +128,10 @@ struct multiFingerGripper
   float grasp_plane_angle_cos;
   /*! \brief Rank of current Gripper*/
   float rank;
-  /*! \brief Pose of gripper*/
+  /*! \brief Pose of gripper, only set for the best ranked grippers*/
   geometry_msgs::msg::PoseStamped pose;
-  /*! \brief Marker representing the grasp points of open configuration on both sides */
+  /*! \brief Marker representing the grasp points of open configuration on both sides, only set
+   * for the best ranked grippers */
   visualization_msgs::msg::Marker marker;
   /*! \brief Centerpoint of gripper */
   pcl::PointXYZ gripper_palm_center;
@@ -134,6 +141,8 @@ struct multiFingerGripper
   std::shared_ptr<singleFinger> base_point_2;
   /*! \brief True if colliding with world */
   bool collides_with_world;
+  /*! \brief Smallest distance between the open fingers and the world */
+  float clearance;
   /*! \brief Unit vector of grasping direction */
   Eigen::Vector3f grasping_direction;
   /*! \brief Unit vector perpendicular to grasping direction */
@@ -168,6 +177,7 @@ struct multiFingerGripper
       base_point_1_->finger_point,
       base_point_2_->finger_point);
     rank = 0;
+    clearance = std::numeric_limits<float>::max();
   }
 };
 
@@ -193,8 +203,17 @@ struct fingerCloudSample
   /*! \brief Maximum Curvature of point in cloud sample */
   float curvature_max;
   int start_index;
-  /*! \brief Finger Samples derived from current finger cloud */
+  /*! \brief Finger Samples derived from current finger cloud. They point into arrays of finger
+   * samples allocated together, which the samples keep alive */
   std::vector<std::shared_ptr<singleFinger>> finger_samples;
+  /*! \brief Coordinates of the finger samples, one column per sample */
+  Eigen::Matrix3Xf finger_positions;
+  /*! \brief Normals of the finger samples, one column per sample */
+  Eigen::Matrix3Xf finger_normals;
+  /*! \brief Normalized distances of the finger samples to the grasp plane */
+  Eigen::VectorXf finger_grasp_plane_dists;
+  /*! \brief Normalized curvatures of the finger samples */
+  Eigen::VectorXf finger_curvatures;
 
   /***************************************************************************//**
   * fingerCloudSample Constructor
@@ -246,7 +265,74 @@ struct graspPlaneSample
   }
 };
 
-/*! \brief General Struct for Finger gripper grasp planning  */
+/*! \brief Pair of center finger samples on opposite sides that passed the pair prefilter */
+struct fingerPair
+{
+  /*! \brief Index of the finger sample on side 1 */
+  int index_1;
+  /*! \brief Index of the finger sample on side 2 */
+  int index_2;
+  /*! \brief Upper bound of the rank of any gripper configuration built on the pair */
+  float rank_bound;
+};
+
+/*! \brief Intermediate state of a single finger gripper planning request  */
+struct FingerPlanningContext
+{
+  /*! \brief Coefficients of the cutting plane through the object */
+  Eigen::Vector4f center_cutting_plane;  // grasp Plane vector coeff: a, b, c ,d
+  /*! \brief Normal vector of the cutting plane */
+  Eigen::Vector3f center_cutting_plane_normal;
+  /*! \brief List of finger grasp samples */
+  std::vector<std::shared_ptr<graspPlaneSample>> grasp_samples;
+  /*! \brief Vector containing distance of each cutting plane to the center */
+  std::vector<float> cutting_plane_distances;
+  /*! \brief Vector containing the indexes of the cutting planes belonging to side 1 */
+  std::vector<int> plane_1_index;
+  /*! \brief Vector containing the indexes of the cutting planes belonging to side 2 */
+  std::vector<int> plane_2_index;
+  /*! \brief Finger samples of each finger of the gripper */
+  std::vector<std::vector<std::shared_ptr<singleFinger>>> gripper_clusters;
+  /*! \brief Vector containing grasp samples sorted by ranks */
+  std::vector<std::shared_ptr<multiFingerGripper>> sorted_gripper_configs;
+  /*! \brief Time after which planning is abandoned */
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  /*! \brief True if planning was abandoned at the deadline */
+  bool timed_out = false;
+  /*! \brief Keep the grasps found before the deadline, and stop early at max_grasps */
+  bool anytime = false;
+  /*! \brief Grasps with a rank of at least min_rank after which an anytime search stops,
+   * 0 searches all finger pairs */
+  size_t max_grasps = 0;
+  /*! \brief Minimum rank of the grasps counted towards max_grasps */
+  float min_rank = std::numeric_limits<float>::lowest();
+  /*! \brief False if an anytime search stopped before the best max_grasps grasps were found */
+  bool exhaustive = true;
+  /*! \brief Occupancy grid of the world, finger collisions are checked with FCL if not set */
+  std::shared_ptr<const grasp_planner::collision::OccupancyGrid> world_grid;
+  /*! \brief Check finger collisions with both world_grid and FCL, and keep the FCL result */
+  bool validate_collisions = false;
+  /*! \brief Occupancy grid of the world with a distance field, finger clearance is ranked
+   * if set, independently of the grid used for collisions */
+  std::shared_ptr<const grasp_planner::collision::OccupancyGrid> world_distance_field;
+  /*! \brief Voxel size of the object cloud being planned on, 0 for the full object cloud */
+  float cloud_resolution = 0;
+  /*! \brief Search trees over the finger clouds of this request, built on first use. Mutable
+   * as the trees are a thread safe cache filled while ranking with a const context */
+  mutable grasp_planner::SearchIndexCache<pcl::PointNormal> sample_cloud_indices;
+
+  /*! \brief Check the deadline, once it has passed the context stays timed out */
+  bool expired()
+  {
+    if (!timed_out && std::chrono::steady_clock::now() > deadline) {
+      timed_out = true;
+    }
+    return timed_out;
+  }
+};
+
+/*! \brief General Struct for Finger gripper grasp planning. The gripper only holds its
+ * description, all state of a planning request lives in a FingerPlanningContext. */
 class FingerGripper : public EndEffector
 {
 public:
@@ -268,38 +354,63 @@ public:
     const float & worldZAngleThreshold_,
     std::string grasp_stroke_direction_,
     std::string grasp_stroke_normal_direction_,
-    std::string grasp_approach_direction_);
+    std::string grasp_approach_direction_,
+    const float & grasp_clearance_weight_ = 0.0,
+    const float & friction_cone_angle_ = M_PI / 2,
+    const float & coarse_voxel_size_ = 0.0,
+    const int & coarse_candidates_ = 5);
 
   void generateGripperAttributes();
 
-  bool getInitialSamplePoints(const std::shared_ptr<GraspObject> & object);
+  bool getInitialSamplePoints(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
-  void getInitialSampleCloud(const std::shared_ptr<GraspObject> & object);
+  void getInitialSampleCloud(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
-  bool getGraspCloud(const std::shared_ptr<GraspObject> & object);
+  bool getRefinedSampleCloud(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object,
+    const std::shared_ptr<CollisionObject> & world_collision_object) const;
+
+  bool getGraspCloud(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
-  void getCenterCuttingPlane(const std::shared_ptr<GraspObject> & object);
+  void getCenterCuttingPlane(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
-  void getCuttingPlanes(const std::shared_ptr<GraspObject> & object);
+  void getCuttingPlanes(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
-  void voxelizeSampleCloud();
+  void voxelizeSampleCloud(FingerPlanningContext & context) const;
 
   void getBestGrasps(
     const std::shared_ptr<GraspObject> object,
     emd_msgs::msg::GraspMethod * grasp_method,
     const std::shared_ptr<CollisionObject> world_collision_object);
 
-  void getMaxMinValues(const std::shared_ptr<GraspObject> & object);
+  void getMaxMinValues(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
 
   void updateMaxMinAttributes(
     std::shared_ptr<fingerCloudSample> & sample,
     const float & centroid_distance,
     const float & grasp_plane_distance,
-    const float & curvature);
+    const float & curvature) const;
 
   void getGraspPose(
     std::shared_ptr<multiFingerGripper> gripper,
-    const std::shared_ptr<GraspObject> & object);
+    const std::shared_ptr<GraspObject> & object) const;
+
+  void getGraspMarker(
+    std::shared_ptr<multiFingerGripper> gripper,
+    const std::string & camera_frame) const;
 
   void planGrasps(
     std::shared_ptr<GraspObject> object,
@@ -307,107 +418,134 @@ public:
     std::shared_ptr<CollisionObject> world_collision_object,
     std::string camera_frame);
 
-  std::vector<std::shared_ptr<multiFingerGripper>>& planGraspsWithFingerResult(
+  std::vector<std::shared_ptr<multiFingerGripper>> planGraspsWithFingerResult(
+    FingerPlanningContext & context,
     std::shared_ptr<GraspObject> object,
     emd_msgs::msg::GraspMethod * grasp_method,
     std::shared_ptr<CollisionObject> world_collision_object,
-    std::string camera_frame);
-
-  void resetVariables();
+    std::string camera_frame) const;
 
   void addCuttingPlanesEqualAligned(
+    FingerPlanningContext & context,
     const Eigen::Vector4f & centerpoint,
     const Eigen::Vector4f & plane_vector,
-    const bool & both_sides_even);
+    const bool & both_sides_even) const;
 
   void addCuttingPlanes(
+    FingerPlanningContext & context,
     const Eigen::Vector4f & centerpoint,
     const Eigen::Vector4f & plane_vector,
     const int & num_itr_1,
     const int & num_itr_2,
     const float & initial_gap_1,
-    const float & initial_gap_2);
+    const float & initial_gap_2) const;
 
-  int checkPlaneExists(const float & dist);
+  int checkPlaneExists(const FingerPlanningContext & context, const float & dist) const;
 
   void addPlane(
+    FingerPlanningContext & context,
     const float & dist,
     const Eigen::Vector4f & centerpoint,
     const Eigen::Vector4f & plane_vector,
     const bool & inside_1,
-    const bool & inside_2);
+    const bool & inside_2) const;
 
-  void getGripperClusters();
+  void getGripperClusters(FingerPlanningContext & context) const;
 
   void getGripperSamplesFromClusters();
 
-  void getFingerSamples(const std::shared_ptr<GraspObject> & object);
+  void getFingerSamples(
+    FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object) const;
+
+  std::vector<fingerPair> getFingerPairs(const FingerPlanningContext & context) const;
+
   std::vector<std::shared_ptr<multiFingerGripper>> getAllGripperConfigs(
+    FingerPlanningContext & context,
     const std::shared_ptr<GraspObject> & object,
-    const std::shared_ptr<CollisionObject> & world_collision_object,
-    std::string camera_frame);
+    const std::shared_ptr<CollisionObject> & world_collision_object) const;
 
   std::shared_ptr<multiFingerGripper> generateGripperOpenConfig(
+    const FingerPlanningContext & context,
+    const std::shared_ptr<GraspObject> & object,
     const std::shared_ptr<CollisionObject> & world_collision_object,
     const std::shared_ptr<singleFinger> & closed_center_finger_1,
     const std::shared_ptr<singleFinger> & closed_center_finger_2,
     const Eigen::Vector3f & open_center_finger_1,
     const Eigen::Vector3f & open_center_finger_2,
     const Eigen::Vector3f & plane_normal_normalized,
-    const Eigen::Vector3f & grasp_direction,
-    std::string camera_frame);
+    const Eigen::Vector3f & grasp_direction) const;
 
   bool checkFingerCollision(
     const Eigen::Vector3f & finger_point,
-    const std::shared_ptr<CollisionObject> & world_collision_object);
+    const std::shared_ptr<CollisionObject> & world_collision_object) const;
 
-  void addPlane(float dist, Eigen::Vector4f centerpoint, Eigen::Vector4f plane_vector);
+  bool checkFingersCollision(
+    const FingerPlanningContext & context,
+    const std::vector<Eigen::Vector3f> & finger_points,
+    const std::shared_ptr<CollisionObject> & world_collision_object) const;
+
+  using EndEffector::visualizeGrasps;
 
   void visualizeGrasps(
     pcl::visualization::PCLVisualizer::Ptr viewer,
-    std::shared_ptr<GraspObject> object);
+    std::shared_ptr<GraspObject> object,
+    const FingerPlanningContext & context) const;
 
   Eigen::Vector3f getPerpendicularVectorInPlane(
     Eigen::Vector3f target_vector,
-    pcl::ModelCoefficients::Ptr plane);
+    pcl::ModelCoefficients::Ptr plane) const;
 
-  void getGripperRank(std::shared_ptr<multiFingerGripper> gripper);
+  void getGripperRank(std::shared_ptr<multiFingerGripper> gripper) const;
+
+  std::vector<std::shared_ptr<multiFingerGripper>> getBestRanks(
+    const std::vector<std::shared_ptr<multiFingerGripper>> & input_vector,
+    const size_t & max_grasps = 0) const;
+
+  void fillGraspMethod(
+    const std::vector<std::shared_ptr<multiFingerGripper>> & sorted_grippers,
+    emd_msgs::msg::GraspMethod * grasp_method) const;
 
   std::vector<std::shared_ptr<multiFingerGripper>> getAllRanks(
-    std::vector<std::shared_ptr<multiFingerGripper>> input_vector,
-    emd_msgs::msg::GraspMethod * grasp_method);
+    const std::vector<std::shared_ptr<multiFingerGripper>> & input_vector,
+    emd_msgs::msg::GraspMethod * grasp_method,
+    const size_t & max_grasps = 0) const;
 
   std::shared_ptr<graspPlaneSample> generateGraspSamples(
     Eigen::Vector4f plane_vector,
     Eigen::Vector3f point_on_plane,
     float dist_to_center_plane,
-    int plane_index);
+    int plane_index) const;
 
   std::vector<Eigen::Vector3f> getOpenFingerCoordinates(
     const Eigen::Vector3f & grasp_direction,
     const Eigen::Vector3f & finger_1,
-    const Eigen::Vector3f & finger_2);
+    const Eigen::Vector3f & finger_2) const;
 
-  int getNearestPlaneIndex(float target_distance);
+  int getNearestPlaneIndex(const FingerPlanningContext & context, float target_distance) const;
 
   int getNearestPointIndex(
     const pcl::PointNormal & target_point,
-    const pcl::PointCloud<pcl::PointNormal>::Ptr cloud);
+    const pcl::PointCloud<pcl::PointNormal>::Ptr cloud) const;
+
+  int getNearestPointIndex(
+    const pcl::PointNormal & target_point,
+    const pcl::search::KdTree<pcl::PointNormal>::Ptr & search) const;
 
   Eigen::Vector3f getGripperPlane(
-    std::shared_ptr<singleFinger> & finger_sample_1,
-    std::shared_ptr<singleFinger> & finger_sample_2,
+    const std::shared_ptr<singleFinger> & finger_sample_1,
+    const std::shared_ptr<singleFinger> & finger_sample_2,
     const Eigen::Vector3f & grasp_direction,
-    const std::shared_ptr<GraspObject> & object);
+    const std::shared_ptr<GraspObject> & object) const;
 
   std::string getID() {return id;}
 
   std::vector<double> getPlanarRPY(
     const Eigen::Vector3f & grasp_direction,
-    const Eigen::Vector3f & grasp_direction_normal);
+    const Eigen::Vector3f & grasp_direction_normal) const;
 
   emd_msgs::msg::Option addClosedGraspDistanceOption(
-    std::shared_ptr<multiFingerGripper> gripper);
+    std::shared_ptr<multiFingerGripper> gripper) const;
 
   /*! \brief Gripper ID*/
   std::string id;
@@ -447,23 +585,15 @@ public:
   const char grasp_stroke_normal_direction;
   /*! \brief Axis in which the gripper approaches the object */
   const char grasp_approach_direction;
+  /*! \brief Weight of the clearance of the open fingers in grasp ranking */
+  const float grasp_clearance_weight;
+  /*! \brief Largest angle between the surface normal at a finger and the grasp direction */
+  const float friction_cone_angle;
+  /*! \brief Voxel size of the coarse level of a coarse to fine search, 0 disables the search */
+  const float coarse_voxel_size;
+  /*! \brief Number of best coarse grasps the fine level searches around */
+  const int coarse_candidates;
 
-  /*! \brief Coefficients of the cutting plane through the object */
-  Eigen::Vector4f center_cutting_plane;  // grasp Plane vector coeff: a, b, c ,d
-  /*! \brief Normal vector of the cutting plane */
-  Eigen::Vector3f center_cutting_plane_normal;
-  /*! \brief List of finger grasp samples */
-  std::vector<std::shared_ptr<graspPlaneSample>> grasp_samples;
-  /*! \brief Vector containing distance of each cutting plane to the center */
-  std::vector<float> cutting_plane_distances;
-  /*! \brief Vector containing the indexes of the cutting planes belonging to side 1 */
-  std::vector<int> plane_1_index;
-  /*! \brief Vector containing the indexes of the cutting planes belonging to side 2 */
-  std::vector<int> plane_2_index;
-  /*! \brief  */
-  std::vector<std::vector<std::shared_ptr<singleFinger>>> gripper_clusters;
-  /*! \brief Vector containing grasp samples sorted by ranks */
-  std::vector<std::shared_ptr<multiFingerGripper>> sorted_gripper_configs;
   /*! \brief True if number of fingers in side 1 is even */
   bool is_even_1;
   /*! \brief True if number of fingers in side 2 is even */
@@ -23,6 +23,7 @@
 #include <pcl/common/centroid.h>
 #include <pcl/common/eigen.h>
 #include <pcl/common/common.h>
+#include <pcl/common/io.h>
 #include <pcl/common/transforms.h>
 #include <pcl/search/search.h>
 
@@ -56,16 +57,20 @@
 #include <cmath>
 #include <iostream>
 #include <chrono>
+#include <limits>
 #include <string>
 #include <memory>
 #include <vector>
 
 // For Multithreading
 #include <future>
+#include "emd/common/thread_pool.hpp"
 
 // EMD libraries
 #include "emd/common/pcl_functions.hpp"
 #include "emd/common/fcl_functions.hpp"
+#include "emd/common/occupancy_grid.hpp"
+#include "emd/common/contact_raster.hpp"
 #include "emd/common/math_functions.hpp"
 #include "emd/common/pcl_visualizer.hpp"
 #include "emd/grasp_planner/end_effectors/end_effector.hpp"
@@ -117,6 +122,9 @@ struct suctionCupArray
   float average_curvature;
   /*! \brief Angle of grasp sample */
   float grasp_angle;
+  /*! \brief Smallest distance between the world and the suction cups, taken a cup height
+  above their contact points */
+  float clearance;
   /*! \brief Vector representing the row direction */
   Eigen::Vector3f row_direction;
   /*! \brief Vector representing the col direction */
@@ -134,6 +142,41 @@ struct suctionCupArray
     gripper_center = gripper_center_;
     total_contact_points = 0;
     rank = 0;
+    clearance = std::numeric_limits<float>::max();
+  }
+};
+
+/*! \brief Grasp samples generated by a single worker, with the range of their ranking attributes.
+ * Buffers are merged into the gripper once all workers are done */
+struct suctionSampleBuffer
+{
+  /*! \brief Grasp samples generated by the worker */
+  std::vector<std::shared_ptr<suctionCupArray>> samples;
+  /*! \brief Maximum average curvature of the samples */
+  float max_curvature = std::numeric_limits<float>::min();
+  /*! \brief Minimum average curvature of the samples */
+  float min_curvature = std::numeric_limits<float>::max();
+  /*! \brief Maximum total contact points of the samples */
+  int max_contact_points = std::numeric_limits<int>::min();
+  /*! \brief Minimum total contact points of the samples */
+  int min_contact_points = std::numeric_limits<int>::max();
+  /*! \brief Maximum distance from the center of the samples to the object center */
+  float max_center_dist = std::numeric_limits<float>::min();
+  /*! \brief Minimum distance from the center of the samples to the object center */
+  float min_center_dist = std::numeric_limits<float>::max();
+  /*! \brief False if the worker stopped at the deadline */
+  bool exhaustive = true;
+
+  /*! \brief Add a grasp sample and update the range of the ranking attributes */
+  void add(const std::shared_ptr<suctionCupArray> & sample)
+  {
+    min_center_dist = std::min(min_center_dist, sample->center_dist);
+    max_center_dist = std::max(max_center_dist, sample->center_dist);
+    min_contact_points = std::min(min_contact_points, sample->total_contact_points);
+    max_contact_points = std::max(max_contact_points, sample->total_contact_points);
+    min_curvature = std::min(min_curvature, sample->average_curvature);
+    max_curvature = std::max(max_curvature, sample->average_curvature);
+    samples.push_back(sample);
   }
 };
 
@@ -158,7 +201,9 @@ public:
     const float & num_contact_points_weight_,
     std::string length_direction_,
     std::string breadth_direction_,
-    std::string grasp_approach_direction_);
+    std::string grasp_approach_direction_,
+    const float & clearance_weight_ = 0.0,
+    const float & contact_raster_resolution_ = 0.0);
 
   void generateGripperAttributes();
 
@@ -175,7 +220,8 @@ public:
     std::shared_ptr<GraspObject> object);
 
   int getCentroidIndex(
-    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud);
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+    const std::size_t & num_points = std::numeric_limits<std::size_t>::max());
 
   void getAllPossibleGrasps(
     const std::shared_ptr<GraspObject> & object,
@@ -209,7 +255,14 @@ public:
     const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
     const Eigen::Vector3f & suction_cup_center,
     const pcl::PointXYZ & object_center,
-    const float & object_max_dim);
+    const float & object_max_dim,
+    const std::shared_ptr<const grasp_planner::ContactRaster> & contact_raster = nullptr,
+    const std::size_t & num_points = std::numeric_limits<std::size_t>::max());
+
+  std::shared_ptr<const grasp_planner::ContactRaster> getContactRaster(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & projected_cloud,
+    const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
+    const std::size_t & num_points = std::numeric_limits<std::size_t>::max());
 
   void getSlicedCloud(
     const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
@@ -220,6 +273,14 @@ public:
     pcl::PointCloud<pcl::PointNormal>::Ptr sliced_cloud_normal,
     const char & height_axis);
 
+  std::vector<float> getHeightSortedCloud(
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+    const pcl::PointCloud<pcl::PointNormal>::Ptr & input_cloud_normal,
+    const float & bottom_limit,
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr sorted_cloud,
+    pcl::PointCloud<pcl::PointNormal>::Ptr sorted_cloud_normal,
+    const char & height_axis);
+
   void projectCloudToPlane(
     const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
     const pcl::ModelCoefficients::Ptr & plane_coefficients,
@@ -242,13 +303,16 @@ public:
     const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
     const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
     const pcl::PointXYZ & centerpoint,
-    float & curvature_sum);
+    float & curvature_sum,
+    const std::size_t & num_points = std::numeric_limits<std::size_t>::max());
 
   void updateMaxMinValues(
     const int & num_contact_points,
     const float & average_curvature,
     const float & center_dist);
 
+  void mergeSampleBuffers(std::vector<suctionSampleBuffer> & buffers);
+
   void getAllGraspRanks(
     emd_msgs::msg::GraspMethod * grasp_method,
     const std::shared_ptr<GraspObject> & object);
@@ -269,7 +333,9 @@ public:
     const Eigen::Vector3f & grasp_direction,
     const Eigen::Vector3f & object_direction,
     const float & object_max_dim,
-    std::string camera_frame);
+    std::string camera_frame,
+    const std::shared_ptr<const grasp_planner::ContactRaster> & contact_raster = nullptr,
+    const std::size_t & num_points = std::numeric_limits<std::size_t>::max());
 
   int generateWeightedContactPoints(
     const int & contact_points,
@@ -313,6 +379,12 @@ public:
   /*! \brief User Defined: Weights to determine importance of the number of
   contact points. Default is 1.0 */
   float num_contact_points_weight;
+  /*! \brief User Defined: Weights to determine importance of the clearance of the cups from
+  the world. Default is 0.0 */
+  float clearance_weight;
+  /*! \brief User Defined: Cell size of the raster on which cup contacts are counted, 0 counts
+  them on the points of the slice instead. Default is 0.0 */
+  const float contact_raster_resolution;
 
   /*! \brief Axis in the direction of the length vector */
   const char length_direction;
@@ -367,6 +439,18 @@ public:
   float min_center_dist;
   /*! \brief All sampled grasp array grasps */
   std::vector<std::shared_ptr<suctionCupArray>> cup_array_samples;
+  /*! \brief Occupancy grid of the world, clearance is ranked if it has a distance field */
+  std::shared_ptr<const grasp_planner::collision::OccupancyGrid> world_grid;
+  /* The planning limits below are set by callers planning with the suction gripper directly,
+   * GraspScene only loads finger grippers. Suction ranks are normalized over all samples, so
+   * unlike the finger gripper, the search cannot stop once max_grasps reach a rank threshold. */
+  /*! \brief Time after which no more grasp samples are generated, the samples generated until
+  then are ranked */
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  /*! \brief Number of best ranked grasps kept, 0 keeps all of them */
+  size_t max_grasps = 0;
+  /*! \brief False if grasp sample generation stopped at the deadline */
+  bool exhaustive = true;
 };
 
 #endif  // EMD__GRASP_PLANNER__END_EFFECTORS__SUCTION_GRIPPER_HPP_
@@ -52,6 +52,7 @@
 #include <cmath>
 #include <string>
 #include <algorithm>
+#include <memory>
 
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include "shape_msgs/msg/solid_primitive.hpp"
@@ -62,6 +63,7 @@
 
 // EMD Libraries
 #include "emd/common/pcl_functions.hpp"
+#include "emd/common/search_index.hpp"
 
 /*! \brief General Class for a grasp object*/
 class GraspObject
@@ -82,6 +84,8 @@ public:
   void getAxisAlignments();
   char getAxis(Eigen::Vector3f vector);
   geometry_msgs::msg::PoseStamped getObjectPose(std::string pose_frame);
+  pcl::search::KdTree<pcl::PointXYZRGB>::Ptr getCloudSearch();
+  pcl::search::KdTree<pcl::PointNormal>::Ptr getNormalCloudSearch();
 
   /*! \brief Message output to describe grasp decisions for this object */
   emd_msgs::msg::GraspTarget grasp_target;
@@ -131,6 +135,12 @@ public:
   int max_grasp_samples;
   /*! \brief  Dimensions of the object*/
   float dimensions[3];
+
+private:
+  /*! \brief Search tree over the object point cloud */
+  grasp_planner::SearchIndex<pcl::PointXYZRGB> cloud_index;
+  /*! \brief Search tree over the object normal point cloud */
+  grasp_planner::SearchIndex<pcl::PointNormal> cloud_normal_index;
 };
 
 #endif  // EMD__GRASP_PLANNER__GRASP_OBJECT_HPP_
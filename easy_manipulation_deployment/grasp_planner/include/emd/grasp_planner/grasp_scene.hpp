@@ -52,7 +52,11 @@
 #include <cv_bridge/cv_bridge.h>
 // EndTemp
 
+#include <algorithm>
 #include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
 #include <memory>
 #include <string>
 #include <vector>
@@ -67,6 +71,10 @@
 #include "emd/common/conversions.hpp"
 #include "emd/common/pcl_functions.hpp"
 #include "emd/common/fcl_functions.hpp"
+#include "emd/common/depth_projection.hpp"
+#include "emd/common/world_model.hpp"
+#include "emd/common/occupancy_grid.hpp"
+#include "emd/common/plane_tracker.hpp"
 #include <visualization_msgs/msg/marker_array.hpp>
 #include <visualization_msgs/msg/marker.hpp>
 
@@ -87,8 +95,15 @@ public:
   /*! \brief Method to process direct Point Clouds */
   void processPointCloud(const sensor_msgs::msg::PointCloud2::ConstSharedPtr & msg);
 
-  /*! \brief Method to create collision objects from Point Clouds */
-  void createWorldCollision(const typename T::ConstSharedPtr & msg);
+  /*! \brief Method to create collision objects from Point Clouds, false if the input is
+   * unusable */
+  bool createWorldCollision(const typename T::ConstSharedPtr & msg);
+
+  /*! \brief Method to update the world collision object from the downsampled scene cloud */
+  void updateWorldCollision(const octomap::point3d & sensor_origin);
+
+  /*! \brief Method to rebuild the occupancy grid of the world collision object */
+  void updateWorldGrid();
 
   /*! \brief General method to extract grasp objects from Point Clouds */
   void extractObjects(const typename T::ConstSharedPtr & msg);
@@ -96,9 +111,18 @@ public:
   /*! \brief Method to extract grasp objects from Point Clouds for Direct Camera workflow */
   void extractObjectsDirect();
 
-  /*! \brief Method to load existing end effectors */
+  /*! \brief Method to load existing end effectors, reusing the ones that did not change */
   void loadEndEffectors();
 
+  /*! \brief Method to build a finger gripper from the parameters in its namespace */
+  std::shared_ptr<FingerGripper> loadFingerGripper(
+    const std::string & end_effector,
+    const std::vector<rclcpp::Parameter> & overrides = std::vector<rclcpp::Parameter>());
+
+  /*! \brief Parameter callback marking accepted end effector changes to be reloaded */
+  rcl_interfaces::msg::SetParametersResult onParametersChanged(
+    const std::vector<rclcpp::Parameter> & parameters);
+
   /*! \brief Method to generate Grasp Task for Grasp Execution tasks */
   emd_msgs::msg::GraspTask generateGraspTask();
 
@@ -132,9 +156,9 @@ public:
   : cloud(new pcl::PointCloud<pcl::PointXYZRGB>()),
     cloud_plane_removed(new pcl::PointCloud<pcl::PointXYZRGB>()),
     org_cloud(new pcl::PointCloud<pcl::PointXYZRGB>()),
+    organized_cloud(new pcl::PointCloud<pcl::PointXYZRGB>()),
     cloud_table(new pcl::PointCloud<pcl::PointXYZRGB>()),
     table_coeff(new pcl::ModelCoefficients),
-    viewer(new pcl::visualization::PCLVisualizer("Cloud viewer")),
     node(node_)
   {
     rclcpp::Clock::SharedPtr clock = std::make_shared<rclcpp::Clock>(RCL_SYSTEM_TIME);
@@ -149,6 +173,9 @@ public:
       node->get_node_timers_interface());
 
     this->buffer_->setCreateTimerInterface(create_timer_interface);
+
+    this->parameter_callback_handle = node->add_on_set_parameters_callback(
+      std::bind(&GraspScene::onParametersChanged, this, std::placeholders::_1));
     // setup(topic_name);
   }
 
@@ -165,16 +192,26 @@ public:
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed;
   /*! \brief  */
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr org_cloud;
+  /*! \brief Unfiltered input cloud with its image layout, kept for organized clustering */
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr organized_cloud;
   /*! \brief Point cloud representing the surface on which the object is placed on */
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table;
   /*! \brief Coefficient of plane representing surface containing objects */
   pcl::ModelCoefficients::Ptr table_coeff;
   /*! \brief Collision object represented by the input cloud (all in scene) */
   std::shared_ptr<grasp_planner::collision::CollisionObject> world_collision_object;
-  /*! \brief PCL Visualizer  */
+  /*! \brief Persistent occupancy map of the scene, kept across planning cycles */
+  std::shared_ptr<grasp_planner::collision::WorldModel> world_model;
+  /*! \brief Occupancy grid of world_collision_object, used for finger collision checks */
+  std::shared_ptr<const grasp_planner::collision::OccupancyGrid> world_grid;
+  /*! \brief PCL Visualizer, opened on the first point cloud visualization */
   pcl::visualization::PCLVisualizer::Ptr viewer;
   /*! \brief Intermediate message type for conversion to PointCloud2 message */
   sensor_msgs::msg::PointCloud2 pointcloud2;
+  /*! \brief Back-projection of depth images using the latest camera intrinsics */
+  DepthProjector depth_projector;
+  /*! \brief Support plane tracked across point clouds, its coefficients are kept in table_coeff */
+  PlaneTracker plane_tracker;
 
   // For collision checking
   /*! \brief Pointer Buffer */
@@ -191,6 +228,8 @@ public:
   rclcpp::Client<epd_msgs::srv::Perception>::SharedPtr epd_client;
   /*! \brief Futures for EPD service request */
   std::shared_future<rclcpp::Client<epd_msgs::srv::Perception>::SharedResponse> epd_result_future;
+  /*! \brief Subscriber for the intrinsics of the EPD depth image */
+  rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_sub;
   /*! \brief Vector of objects in the scene to be picked */
   #endif
 
@@ -198,6 +237,14 @@ public:
   rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr grasps_rviz_pub_;
   /*! \brief Vector of End effectors available */
   std::vector<std::shared_ptr<FingerGripper>> end_effectors;
+  /*! \brief Names of end effectors whose parameters changed since they were loaded */
+  std::set<std::string> stale_end_effectors;
+  /*! \brief True if all end effectors have to be loaded again */
+  bool all_end_effectors_stale = true;
+  /*! \brief Guards the stale end effector state, which parameter callbacks update */
+  std::mutex end_effector_mutex;
+  /*! \brief Handle keeping the parameter callback registered */
+  rclcpp::node_interfaces::OnSetParametersCallbackHandle::SharedPtr parameter_callback_handle;
 
   rclcpp::Node::SharedPtr node;
 };
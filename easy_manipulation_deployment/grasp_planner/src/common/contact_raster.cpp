@@ -0,0 +1,267 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/contact_raster.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using grasp_planner::ContactRaster;
+
+ContactRaster::ContactRaster()
+: resolution(0),
+  radius(0),
+  origin(Eigen::Vector2f::Zero()),
+  dims(Eigen::Vector2i::Zero()),
+  point_count(0)
+{
+}
+
+/***************************************************************************************//**
+ * Function that rebuilds the raster from a set of points and computes its disc filter. The
+ * raster spans the cells of the bounding box of the points, padded by the disc radius so that
+ * every disc reaching a point is centered on a cell. Points that are not finite are skipped, and so is
+ * the curvature of points whose curvature is not finite. Returns false, leaving the raster
+ * empty, if the arguments are invalid or the raster would need more than max_cells cells.
+ * @param points Points, in the coordinates of the projection plane
+ * @param curvatures Curvature of each point
+ * @param resolution_ Edge length of a cell
+ * @param radius_ Radius of the disc filter
+ * @param max_cells Maximum number of cells of the raster
+ *******************************************************************************************/
+bool ContactRaster::build(
+  const std::vector<Eigen::Vector2f> & points,
+  const std::vector<float> & curvatures,
+  const float & resolution_,
+  const float & radius_,
+  const size_t & max_cells)
+{
+  resolution = 0;
+  radius = 0;
+  origin.setZero();
+  dims.setZero();
+  point_count = 0;
+  count_table.clear();
+  curvature_table.clear();
+  disc_counts.clear();
+  disc_curvatures.clear();
+
+  if (!(resolution_ > 0) || !(radius_ >= 0) || points.size() != curvatures.size()) {
+    return false;
+  }
+
+  Eigen::Vector2f lower = Eigen::Vector2f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector2f upper = Eigen::Vector2f::Constant(std::numeric_limits<float>::lowest());
+  size_t finite_count = 0;
+  for (const auto & point : points) {
+    if (point.allFinite()) {
+      lower = lower.cwiseMin(point);
+      upper = upper.cwiseMax(point);
+      finite_count++;
+    }
+  }
+  if (finite_count == 0) {
+    resolution = resolution_;
+    radius = radius_;
+    return true;
+  }
+
+  // Cells are aligned to multiples of the resolution, so rasters of the same points agree
+  const int padding = static_cast<int>(std::floor(radius_ / resolution_));
+  Eigen::Vector2i new_dims;
+  Eigen::Vector2f new_origin;
+  double num_cells = 1;
+  for (int axis = 0; axis < 2; axis++) {
+    const double lower_cell = std::floor(static_cast<double>(lower(axis)) / resolution_);
+    const double upper_cell = std::floor(static_cast<double>(upper(axis)) / resolution_);
+    const double cells = upper_cell - lower_cell + 1 + 2.0 * padding;
+    num_cells *= cells;
+    if (num_cells > static_cast<double>(max_cells)) {
+      return false;
+    }
+    new_dims(axis) = static_cast<int>(cells);
+    new_origin(axis) = static_cast<float>((lower_cell - padding) * resolution_);
+  }
+  resolution = resolution_;
+  radius = radius_;
+  dims = new_dims;
+  origin = new_origin;
+  point_count = finite_count;
+
+  // Count the points of each cell, shifted by the leading row and column of the tables
+  const size_t stride = static_cast<size_t>(dims(0)) + 1;
+  count_table.assign(stride * (static_cast<size_t>(dims(1)) + 1), 0);
+  curvature_table.assign(count_table.size(), 0.0);
+  for (size_t i = 0; i < points.size(); i++) {
+    if (!points[i].allFinite()) {
+      continue;
+    }
+    const Eigen::Vector2i cell = getCell(points[i]).cwiseMax(0).cwiseMin(
+      dims - Eigen::Vector2i::Ones());
+    const size_t index = (static_cast<size_t>(cell(1)) + 1) * stride + cell(0) + 1;
+    count_table[index]++;
+    if (std::isfinite(curvatures[i])) {
+      curvature_table[index] += curvatures[i];
+    }
+  }
+  for (size_t y = 1; y <= static_cast<size_t>(dims(1)); y++) {
+    for (size_t x = 1; x < stride; x++) {
+      const size_t index = y * stride + x;
+      count_table[index] +=
+        count_table[index - 1] + count_table[index - stride] - count_table[index - stride - 1];
+      curvature_table[index] += curvature_table[index - 1] + curvature_table[index - stride] -
+        curvature_table[index - stride - 1];
+    }
+  }
+  filterDisc();
+  return true;
+}
+
+/***************************************************************************************//**
+ * Function that computes, for every cell, the number of points and the curvature sum of
+ * the cells whose centers are within the disc radius of its center. Each row of the disc
+ * is a span of cells read from the summed area tables, so the filter costs one table lookup
+ * per cell and disc row.
+ *******************************************************************************************/
+void ContactRaster::filterDisc()
+{
+  const float radius_cells = radius / resolution;
+  const int padding = static_cast<int>(std::floor(radius_cells));
+  // Half width in cells of each row of the disc, from its top row
+  std::vector<int> half_widths(2 * padding + 1);
+  for (int dy = -padding; dy <= padding; dy++) {
+    half_widths[dy + padding] = static_cast<int>(
+      std::floor(std::sqrt(std::max(0.0f, radius_cells * radius_cells - dy * dy))));
+  }
+
+  const size_t stride = static_cast<size_t>(dims(0)) + 1;
+  disc_counts.assign(static_cast<size_t>(dims(0)) * dims(1), 0);
+  disc_curvatures.assign(disc_counts.size(), 0);
+  for (int y = 0; y < dims(1); y++) {
+    for (int x = 0; x < dims(0); x++) {
+      int count = 0;
+      double curvature_sum = 0;
+      for (int dy = -padding; dy <= padding; dy++) {
+        const int row = y + dy;
+        if (row < 0 || row >= dims(1)) {
+          continue;
+        }
+        const int half_width = half_widths[dy + padding];
+        const size_t begin = std::max(x - half_width, 0);
+        const size_t end = std::min(x + half_width + 1, dims(0));
+        const size_t top = static_cast<size_t>(row) * stride;
+        const size_t bottom = top + stride;
+        count += count_table[bottom + end] - count_table[bottom + begin] -
+          count_table[top + end] + count_table[top + begin];
+        curvature_sum += curvature_table[bottom + end] - curvature_table[bottom + begin] -
+          curvature_table[top + end] + curvature_table[top + begin];
+      }
+      const size_t index = static_cast<size_t>(y) * dims(0) + x;
+      disc_counts[index] = count;
+      disc_curvatures[index] = static_cast<float>(curvature_sum);
+    }
+  }
+}
+
+/***************************************************************************************//**
+ * Function that sums the points of a block of cells, clamped to the raster
+ * @param min Lowest cell index of the block
+ * @param max One past the highest cell index of the block
+ * @param curvature_sum Curvature sum of the points of the block
+ *******************************************************************************************/
+int ContactRaster::boxSum(
+  const Eigen::Vector2i & min, const Eigen::Vector2i & max,
+  float & curvature_sum) const
+{
+  curvature_sum = 0;
+  const Eigen::Vector2i begin = min.cwiseMax(0).cwiseMin(dims);
+  const Eigen::Vector2i end = max.cwiseMax(0).cwiseMin(dims);
+  if (point_count == 0 || (end.array() <= begin.array()).any()) {
+    return 0;
+  }
+  const size_t stride = static_cast<size_t>(dims(0)) + 1;
+  const size_t top = static_cast<size_t>(begin(1)) * stride;
+  const size_t bottom = static_cast<size_t>(end(1)) * stride;
+  curvature_sum = static_cast<float>(
+    curvature_table[bottom + end(0)] - curvature_table[bottom + begin(0)] -
+    curvature_table[top + end(0)] + curvature_table[top + begin(0)]);
+  return count_table[bottom + end(0)] - count_table[bottom + begin(0)] -
+         count_table[top + end(0)] + count_table[top + begin(0)];
+}
+
+/***************************************************************************************//**
+ * Function that looks up the number of points and their curvature sum within the disc
+ * radius of a center. Centers outside the raster are further than the radius from every
+ * point.
+ * @param center Center of the disc, in the coordinates of the projection plane
+ * @param curvature_sum Curvature sum of the points within the disc
+ *******************************************************************************************/
+int ContactRaster::discSum(const Eigen::Vector2f & center, float & curvature_sum) const
+{
+  curvature_sum = 0;
+  const Eigen::Vector2i cell = getCell(center);
+  if (point_count == 0 || (cell.array() < 0).any() || (cell.array() >= dims.array()).any()) {
+    return 0;
+  }
+  const size_t index = static_cast<size_t>(cell(1)) * dims(0) + cell(0);
+  curvature_sum = disc_curvatures[index];
+  return disc_counts[index];
+}
+
+/***************************************************************************************//**
+ * Function that returns the index of the cell containing a point. Indexes of points
+ * outside the raster are clamped to one cell beyond it, and so are points that are not
+ * finite.
+ * @param point Point, in the coordinates of the projection plane
+ *******************************************************************************************/
+Eigen::Vector2i ContactRaster::getCell(const Eigen::Vector2f & point) const
+{
+  Eigen::Vector2i cell(-1, -1);
+  if (resolution <= 0) {
+    return cell;
+  }
+  for (int axis = 0; axis < 2; axis++) {
+    const float index = std::floor((point(axis) - origin(axis)) / resolution);
+    if (!std::isfinite(index) || index < 0) {
+      cell(axis) = -1;
+    } else if (index >= dims(axis)) {
+      cell(axis) = dims(axis);
+    } else {
+      cell(axis) = static_cast<int>(index);
+    }
+  }
+  return cell;
+}
+
+bool ContactRaster::empty() const
+{
+  return point_count == 0;
+}
+
+float ContactRaster::getResolution() const
+{
+  return resolution;
+}
+
+float ContactRaster::getRadius() const
+{
+  return radius;
+}
+
+Eigen::Vector2i ContactRaster::getDims() const
+{
+  return dims;
+}
@@ -0,0 +1,223 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/depth_projection.hpp"
+
+#include <sensor_msgs/image_encodings.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+/*! \brief Number of pixels evaluated together when building the crop mask */
+constexpr size_t kPixelBlockSize = 256;
+/*! \brief Fixed point iterations used to invert the lens distortion */
+constexpr int kUndistortIterations = 10;
+/*! \brief Scale of 16 bit depth images, which are in millimetres */
+constexpr float kDepthScale16U = 0.001f;
+}  // namespace
+
+grasp_planner::DepthProjector::DepthProjector()
+: width(0), height(0), k{}
+{
+}
+
+/***************************************************************************************//**
+ * Function that updates the camera model. The ray lookup table is only rebuilt if the image
+ * size, intrinsics or distortion changed.
+ * @param camera_info CameraInfo message of the depth image
+ * @return true if the lookup table was rebuilt
+ *******************************************************************************************/
+bool grasp_planner::DepthProjector::setCameraInfo(
+  const sensor_msgs::msg::CameraInfo & camera_info)
+{
+  std::lock_guard<std::mutex> lock(model_mutex);
+  if (camera_info.width == width && camera_info.height == height &&
+    std::equal(k.begin(), k.end(), camera_info.k.begin()) &&
+    camera_info.d == d && camera_info.distortion_model == distortion_model)
+  {
+    return false;
+  }
+  if (camera_info.k[0] == 0 || camera_info.k[4] == 0) {
+    return false;
+  }
+  width = camera_info.width;
+  height = camera_info.height;
+  std::copy(camera_info.k.begin(), camera_info.k.end(), k.begin());
+  d = camera_info.d;
+  distortion_model = camera_info.distortion_model;
+  generateRayTable();
+  return true;
+}
+
+bool grasp_planner::DepthProjector::hasCameraModel()
+{
+  std::lock_guard<std::mutex> lock(model_mutex);
+  return !ray_x.empty();
+}
+
+/***************************************************************************************//**
+ * Function that computes the normalized image plane coordinates of every pixel. Plumb bob
+ * and rational polynomial distortion is removed here, so projection is a multiply per pixel.
+ *******************************************************************************************/
+void grasp_planner::DepthProjector::generateRayTable()
+{
+  const double fx = k[0], skew = k[1], cx = k[2];
+  const double fy = k[4], cy = k[5];
+
+  std::vector<double> coeffs(8, 0.0);
+  const bool distorted =
+    (distortion_model == "plumb_bob" || distortion_model == "rational_polynomial") &&
+    std::any_of(d.begin(), d.end(), [](double c) {return c != 0.0;});
+  if (distorted) {
+    std::copy(d.begin(), d.begin() + std::min<size_t>(d.size(), coeffs.size()), coeffs.begin());
+  }
+  const double k1 = coeffs[0], k2 = coeffs[1], p1 = coeffs[2], p2 = coeffs[3];
+  const double k3 = coeffs[4], k4 = coeffs[5], k5 = coeffs[6], k6 = coeffs[7];
+
+  ray_x.resize(static_cast<size_t>(width) * height);
+  ray_y.resize(static_cast<size_t>(width) * height);
+  for (uint32_t v = 0; v < height; v++) {
+    for (uint32_t u = 0; u < width; u++) {
+      const double y0 = (v - cy) / fy;
+      const double x0 = (u - cx - skew * y0) / fx;
+      double x = x0, y = y0;
+      if (distorted) {
+        for (int itr = 0; itr < kUndistortIterations; itr++) {
+          const double r2 = x * x + y * y;
+          const double radial = (1 + ((k3 * r2 + k2) * r2 + k1) * r2) /
+            (1 + ((k6 * r2 + k5) * r2 + k4) * r2);
+          const double delta_x = 2 * p1 * x * y + p2 * (r2 + 2 * x * x);
+          const double delta_y = p1 * (r2 + 2 * y * y) + 2 * p2 * x * y;
+          x = (x0 - delta_x) / radial;
+          y = (y0 - delta_y) / radial;
+        }
+      }
+      ray_x[static_cast<size_t>(v) * width + u] = static_cast<float>(x);
+      ray_y[static_cast<size_t>(v) * width + u] = static_cast<float>(y);
+    }
+  }
+}
+
+/***************************************************************************************//**
+ * Function that back-projects a depth image. Rows are processed contiguously in small blocks
+ * so that projection and the crop test vectorize. Pixels without depth or outside the crop
+ * limits are skipped before they are written out, unless an organized cloud is requested in
+ * which case they are set to NaN to keep the image layout.
+ * @param depth_image 16UC1 (millimetres) or 32FC1 (metres) depth image
+ * @param output_cloud Output cloud
+ * @param ptFilter_Ulimit_x Upper limit in x direction (Same for y and z)
+ * @param ptFilter_Llimit_x Lower limit in x direction (Same for y and z)
+ * @param organized Whether to output a width x height organized cloud
+ * @return false if there is no camera model, or the image does not match it
+ *******************************************************************************************/
+bool grasp_planner::DepthProjector::projectDepthImage(
+  const sensor_msgs::msg::Image & depth_image,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr output_cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const bool & organized)
+{
+  std::lock_guard<std::mutex> lock(model_mutex);
+  if (ray_x.empty() || depth_image.width != width || depth_image.height != height) {
+    return false;
+  }
+  const bool is_16u = depth_image.encoding == sensor_msgs::image_encodings::TYPE_16UC1 ||
+    depth_image.encoding == sensor_msgs::image_encodings::MONO16;
+  const bool is_32f = depth_image.encoding == sensor_msgs::image_encodings::TYPE_32FC1;
+  const uint32_t host_is_little_endian = 1;
+  const size_t pixel_size = is_16u ? sizeof(uint16_t) : sizeof(float);
+  if ((!is_16u && !is_32f) ||
+    static_cast<bool>(depth_image.is_bigendian) ==
+    static_cast<bool>(*reinterpret_cast<const uint8_t *>(&host_is_little_endian)) ||
+    depth_image.step < width * pixel_size ||
+    depth_image.data.size() < static_cast<size_t>(depth_image.step) * height)
+  {
+    return false;
+  }
+
+  output_cloud->points.clear();
+  if (organized) {
+    pcl::PointXYZRGB invalid_point;
+    invalid_point.x = invalid_point.y = invalid_point.z = std::numeric_limits<float>::quiet_NaN();
+    output_cloud->points.resize(static_cast<size_t>(width) * height, invalid_point);
+  }
+
+  float x[kPixelBlockSize], y[kPixelBlockSize], z[kPixelBlockSize];
+  uint16_t raw_16u[kPixelBlockSize];
+  uint8_t keep[kPixelBlockSize];
+  for (uint32_t v = 0; v < height; v++) {
+    const uint8_t * row = depth_image.data.data() + static_cast<size_t>(v) * depth_image.step;
+    const float * row_ray_x = ray_x.data() + static_cast<size_t>(v) * width;
+    const float * row_ray_y = ray_y.data() + static_cast<size_t>(v) * width;
+    for (uint32_t block = 0; block < width; block += kPixelBlockSize) {
+      const size_t block_size = std::min<size_t>(kPixelBlockSize, width - block);
+      if (is_16u) {
+        std::memcpy(raw_16u, row + block * pixel_size, block_size * pixel_size);
+        for (size_t i = 0; i < block_size; i++) {
+          z[i] = raw_16u[i] * kDepthScale16U;
+        }
+      } else {
+        std::memcpy(z, row + block * pixel_size, block_size * pixel_size);
+      }
+      for (size_t i = 0; i < block_size; i++) {
+        x[i] = row_ray_x[block + i] * z[i];
+        y[i] = row_ray_y[block + i] * z[i];
+      }
+      // Zero and NaN depth fail the comparisons below
+      for (size_t i = 0; i < block_size; i++) {
+        keep[i] = (z[i] > 0) &
+          (x[i] >= ptFilter_Llimit_x) & (x[i] <= ptFilter_Ulimit_x) &
+          (y[i] >= ptFilter_Llimit_y) & (y[i] <= ptFilter_Ulimit_y) &
+          (z[i] >= ptFilter_Llimit_z) & (z[i] <= ptFilter_Ulimit_z);
+      }
+      for (size_t i = 0; i < block_size; i++) {
+        if (!keep[i]) {
+          continue;
+        }
+        pcl::PointXYZRGB point;
+        point.x = x[i];
+        point.y = y[i];
+        point.z = z[i];
+        if (organized) {
+          output_cloud->points[static_cast<size_t>(v) * width + block + i] = point;
+        } else {
+          output_cloud->points.push_back(point);
+        }
+      }
+    }
+  }
+
+  output_cloud->header.frame_id = depth_image.header.frame_id;
+  output_cloud->header.stamp = depth_image.header.stamp.sec * 1000000ull +
+    depth_image.header.stamp.nanosec / 1000ull;
+  if (organized) {
+    output_cloud->width = width;
+    output_cloud->height = height;
+    output_cloud->is_dense = false;
+  } else {
+    output_cloud->width = static_cast<uint32_t>(output_cloud->points.size());
+    output_cloud->height = 1;
+    output_cloud->is_dense = true;
+  }
+  return true;
+}
@@ -15,178 +15,395 @@
 
 #include "emd/common/fcl_functions.hpp"
 
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
 using namespace grasp_planner::collision;
 
-std::shared_ptr<CollisionObject> FCLFunctions::createCollisionObjectFromPointCloudRGB(
-  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_ptr,
-  const octomap::point3d & sensor_origin_wrt_world,
-  float resolution)
-// std::shared_ptr<octomap::OcTree> createOctomapFromPointCloud(
-//  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_ptr,
-//  const octomap::point3d& sensor_origin_wrt_world, float resolution)
-{
-  // octomap octree settings
-  // const double resolution = 0.01;
-  const double prob_hit = 0.9;
-  const double prob_miss = 0.1;
-  const double clamping_thres_min = 0.12;
-  const double clamping_thres_max = 0.98;
+namespace
+{
+// octomap octree settings
+const double prob_hit = 0.9;
+const double prob_miss = 0.1;
+const double clamping_thres_min = 0.12;
+const double clamping_thres_max = 0.98;
 
-  std::shared_ptr<octomap::OcTree> octomap_octree = std::make_shared<octomap::OcTree>(resolution);
-  octomap_octree->setProbHit(prob_hit);
-  octomap_octree->setProbMiss(prob_miss);
-  octomap_octree->setClampingThresMin(clamping_thres_min);
-  octomap_octree->setClampingThresMax(clamping_thres_max);
+/*! \brief Unsorted keys a thread may buffer before compacting its buffer */
+constexpr size_t kMaxUnsortedKeys = size_t(1) << 22;
+
+/*! \brief Spread the lower 21 bits of a value so that there are two zero bits between each */
+uint64_t spreadBits(uint64_t value)
+{
+  value &= 0x1fffff;
+  value = (value | value << 32) & 0x1f00000000ffff;
+  value = (value | value << 16) & 0x1f0000ff0000ff;
+  value = (value | value << 8) & 0x100f00f00f00f00f;
+  value = (value | value << 4) & 0x10c30c30c30c30c3;
+  value = (value | value << 2) & 0x1249249249249249;
+  return value;
+}
 
-  octomap::KeySet free_cells;
-  octomap::KeySet occupied_cells;
-
-#if defined(_OPENMP)
-#pragma omp parallel
-#endif
-  {
-#if defined(_OPENMP)
-    auto thread_id = omp_get_thread_num();
-    auto thread_num = omp_get_num_threads();
-#else
-    int thread_id = 0;
-    int thread_num = 1;
-#endif
-    int start_idx = static_cast<int>(pointcloud_ptr->size() / thread_num) * thread_id;
-    int end_idx = static_cast<int>(pointcloud_ptr->size() / thread_num) * (thread_id + 1);
-    if (thread_id == thread_num - 1) {
-      end_idx = pointcloud_ptr->size();
+/*! \brief Inverse of spreadBits */
+uint64_t compactBits(uint64_t value)
+{
+  value &= 0x1249249249249249;
+  value = (value ^ (value >> 2)) & 0x10c30c30c30c30c3;
+  value = (value ^ (value >> 4)) & 0x100f00f00f00f00f;
+  value = (value ^ (value >> 8)) & 0x1f0000ff0000ff;
+  value = (value ^ (value >> 16)) & 0x1f00000000ffff;
+  value = (value ^ (value >> 32)) & 0x1fffff;
+  return value;
+}
+
+/*! \brief Morton code of an octree key. Cells close in the tree are close in Morton order */
+uint64_t encodeKey(const octomap::OcTreeKey & key)
+{
+  return spreadBits(key[0]) | (spreadBits(key[1]) << 1) | (spreadBits(key[2]) << 2);
+}
+
+octomap::OcTreeKey decodeKey(uint64_t code)
+{
+  return octomap::OcTreeKey(
+    static_cast<octomap::key_type>(compactBits(code)),
+    static_cast<octomap::key_type>(compactBits(code >> 1)),
+    static_cast<octomap::key_type>(compactBits(code >> 2)));
+}
+
+/***************************************************************************************//**
+ * Sorts and removes duplicates from the unsorted tail of a key buffer whose first
+ * sorted_size entries are already sorted and unique, and merges it into the sorted part.
+ * @param codes Key buffer
+ * @param sorted_size Number of sorted entries at the start of the buffer, updated on return
+ *******************************************************************************************/
+void compactKeys(std::vector<uint64_t> & codes, size_t & sorted_size)
+{
+  std::sort(codes.begin() + sorted_size, codes.end());
+  codes.erase(std::unique(codes.begin() + sorted_size, codes.end()), codes.end());
+  std::inplace_merge(codes.begin(), codes.begin() + sorted_size, codes.end());
+  codes.erase(std::unique(codes.begin(), codes.end()), codes.end());
+  sorted_size = codes.size();
+}
+
+/***************************************************************************************//**
+ * Merges sorted, unique per thread key buffers into one sorted, unique buffer. Buffers are
+ * merged pairwise, with the merges of each round running in parallel.
+ * @param buffers Per thread key buffers, consumed by the merge
+ * @return Merged buffer
+ *******************************************************************************************/
+std::vector<uint64_t> mergeKeys(std::vector<std::vector<uint64_t>> & buffers)
+{
+  if (buffers.empty()) {
+    return {};
+  }
+  while (buffers.size() > 1) {
+    std::vector<std::vector<uint64_t>> merged(buffers.size() / 2);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < merged.size(); i++) {
+      futures.push_back(
+        std::async(
+          std::launch::async, [&buffers, &merged, i]() {
+            const auto & first = buffers[2 * i];
+            const auto & second = buffers[2 * i + 1];
+            merged[i].reserve(first.size() + second.size());
+            std::set_union(
+              first.begin(), first.end(), second.begin(), second.end(),
+              std::back_inserter(merged[i]));
+          }));
+    }
+    for (auto & future : futures) {
+      future.get();
     }
-    octomap::KeySet local_free_cells;
-    octomap::KeySet local_occupied_cells;
+    if (buffers.size() % 2 == 1) {
+      merged.push_back(std::move(buffers.back()));
+    }
+    buffers.swap(merged);
+  }
+  return std::move(buffers.front());
+}
+}  // namespace
 
-    for (auto i = start_idx; i < end_idx; i++) {
-      octomap::point3d point(
-        (*pointcloud_ptr)[i].x, (*pointcloud_ptr)[i].y,
-        (*pointcloud_ptr)[i].z);
+namespace
+{
+/***************************************************************************************//**
+ * Collects the keys of a point cloud on up to num_threads threads. Each thread visits a
+ * contiguous range of points and appends Morton codes to flat buffers, which are sorted and
+ * deduplicated in place. The thread buffers are then merged in parallel, and the occupied
+ * cells are removed from the free cells in one pass.
+ * @param num_points Number of points in the cloud
+ * @param num_threads Number of threads to use
+ * @param visit_point Function appending the codes of a point to the free and occupied buffers
+ * @param keys Output keys
+ *******************************************************************************************/
+template<typename VisitFunction>
+void collectKeys(
+  size_t num_points,
+  unsigned int num_threads,
+  const VisitFunction & visit_point,
+  FCLFunctions::IntegrationKeys & keys)
+{
+  const size_t thread_num = std::max(
+    size_t(1), std::min(static_cast<size_t>(num_threads), num_points));
+  std::vector<std::vector<uint64_t>> free_buffers(thread_num);
+  std::vector<std::vector<uint64_t>> occupied_buffers(thread_num);
+
+  auto collect_range = [&](size_t thread_id) {
+      size_t start_idx = num_points / thread_num * thread_id;
+      size_t end_idx = (thread_id == thread_num - 1) ?
+        num_points : num_points / thread_num * (thread_id + 1);
+      std::vector<uint64_t> & free_codes = free_buffers[thread_id];
+      std::vector<uint64_t> & occupied_codes = occupied_buffers[thread_id];
+      size_t free_sorted = 0;
+      size_t occupied_sorted = 0;
       octomap::KeyRay key_ray;
-      if (octomap_octree->computeRayKeys(sensor_origin_wrt_world, point, key_ray)) {
-        local_free_cells.insert(key_ray.begin(), key_ray.end());
-      }
 
-      octomap::OcTreeKey tree_key;
-      if (octomap_octree->coordToKeyChecked(point, tree_key)) {
-        local_occupied_cells.insert(tree_key);
+      for (size_t i = start_idx; i < end_idx; i++) {
+        visit_point(i, key_ray, free_codes, occupied_codes);
+        if (free_codes.size() - free_sorted > kMaxUnsortedKeys) {
+          compactKeys(free_codes, free_sorted);
+        }
+        if (occupied_codes.size() - occupied_sorted > kMaxUnsortedKeys) {
+          compactKeys(occupied_codes, occupied_sorted);
+        }
       }
-    }
+      compactKeys(free_codes, free_sorted);
+      compactKeys(occupied_codes, occupied_sorted);
+    };
 
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
-    {
-      free_cells.insert(local_free_cells.begin(), local_free_cells.end());
-      occupied_cells.insert(local_occupied_cells.begin(), local_occupied_cells.end());
-    }
+  std::vector<std::future<void>> futures;
+  for (size_t thread_id = 1; thread_id < thread_num; thread_id++) {
+    futures.push_back(std::async(std::launch::async, collect_range, thread_id));
   }
-
-  // free cells only if not occupied in this cloud
-  for (auto it = free_cells.begin(); it != free_cells.end(); ++it) {
-    if (occupied_cells.find(*it) == occupied_cells.end()) {
-      octomap_octree->updateNode(*it, false);
-    }
+  collect_range(0);
+  for (auto & future : futures) {
+    future.get();
   }
 
-  // occupied cells
-  for (auto it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-    octomap_octree->updateNode(*it, true);
-  }
+  std::vector<uint64_t> free_codes = mergeKeys(free_buffers);
+  std::vector<uint64_t> occupied_codes = mergeKeys(occupied_buffers);
 
-  // return octomap_octree;
+  // free cells only if not occupied in this cloud
+  std::vector<uint64_t> free_only_codes;
+  free_only_codes.reserve(free_codes.size());
+  std::set_difference(
+    free_codes.begin(), free_codes.end(), occupied_codes.begin(), occupied_codes.end(),
+    std::back_inserter(free_only_codes));
 
-  auto fcl_octree = std::make_shared<OcTree>(octomap_octree);
-  std::shared_ptr<CollisionGeometry> fcl_geometry = fcl_octree;
-  std::make_shared<CollisionObject>(fcl_geometry);
-  return std::make_shared<CollisionObject>(fcl_geometry);
+  keys.free_cells.resize(free_only_codes.size());
+  std::transform(
+    free_only_codes.begin(), free_only_codes.end(), keys.free_cells.begin(), decodeKey);
+  keys.occupied_cells.resize(occupied_codes.size());
+  std::transform(
+    occupied_codes.begin(), occupied_codes.end(), keys.occupied_cells.begin(), decodeKey);
 }
+}  // namespace
 
-std::shared_ptr<CollisionObject> FCLFunctions::createCollisionObjectFromPointCloud(
-  const pcl::PointCloud<pcl::PointXYZ>::Ptr & pointcloud_ptr,
-  const octomap::point3d & sensor_origin_wrt_world,
-  float resolution)
-// std::shared_ptr<octomap::OcTree> createOctomapFromPointCloud(
-// const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_ptr,
-// const octomap::point3d& sensor_origin_wrt_world, float resolution)
-{
-  // octomap octree settings
-  // const double resolution = 0.01;
-  const double prob_hit = 0.9;
-  const double prob_miss = 0.1;
-  const double clamping_thres_min = 0.12;
-  const double clamping_thres_max = 0.98;
-
-  std::shared_ptr<octomap::OcTree> octomap_octree = std::make_shared<octomap::OcTree>(resolution);
-  octomap_octree->setProbHit(prob_hit);
-  octomap_octree->setProbMiss(prob_miss);
-  octomap_octree->setClampingThresMin(clamping_thres_min);
-  octomap_octree->setClampingThresMax(clamping_thres_max);
-
-  octomap::KeySet free_cells;
-  octomap::KeySet occupied_cells;
-
-#if defined(_OPENMP)
-#pragma omp parallel
-#endif
-  {
-#if defined(_OPENMP)
-    auto thread_id = omp_get_thread_num();
-    auto thread_num = omp_get_num_threads();
-#else
-    int thread_id = 0;
-    int thread_num = 1;
-#endif
-    int start_idx = static_cast<int>(pointcloud_ptr->size() / thread_num) * thread_id;
-    int end_idx = static_cast<int>(pointcloud_ptr->size() / thread_num) * (thread_id + 1);
-    if (thread_id == thread_num - 1) {
-      end_idx = pointcloud_ptr->size();
-    }
-    octomap::KeySet local_free_cells;
-    octomap::KeySet local_occupied_cells;
+/***************************************************************************************//**
+ * Function that computes the cells of an octree that a point cloud marks as free and as
+ * occupied, by casting a ray from the sensor origin to every point.
+ * @param octree Octree that the keys are computed for
+ * @param cloud Input cloud
+ * @param sensor_origin Origin of the sensor rays
+ * @param num_threads Number of threads to use
+ * @param keys Output keys
+ * @param region Region that updates are restricted to
+ * @param skip_ray Optional function returning true for occupied cells whose ray is not needed
+ *******************************************************************************************/
+template<typename PointT>
+void FCLFunctions::computeIntegrationKeys(
+  const octomap::OcTree & octree,
+  const pcl::PointCloud<PointT> & cloud,
+  const octomap::point3d & sensor_origin,
+  const unsigned int & num_threads,
+  IntegrationKeys & keys,
+  const UpdateRegion & region,
+  const std::function<bool(const octomap::OcTreeKey &)> & skip_ray)
+{
+  auto visit_point = [&](
+    size_t i, octomap::KeyRay & key_ray,
+    std::vector<uint64_t> & free_codes, std::vector<uint64_t> & occupied_codes) {
+      octomap::point3d point(cloud[i].x, cloud[i].y, cloud[i].z);
+      octomap::OcTreeKey tree_key;
+      if (!region.contains(point) || !octree.coordToKeyChecked(point, tree_key)) {
+        return;
+      }
+      occupied_codes.push_back(encodeKey(tree_key));
 
-    for (auto i = start_idx; i < end_idx; i++) {
-      octomap::point3d point(
-        (*pointcloud_ptr)[i].x, (*pointcloud_ptr)[i].y,
-        (*pointcloud_ptr)[i].z);
-      octomap::KeyRay key_ray;
-      if (octomap_octree->computeRayKeys(sensor_origin_wrt_world, point, key_ray)) {
-        local_free_cells.insert(key_ray.begin(), key_ray.end());
+      if (skip_ray && skip_ray(tree_key)) {
+        return;
       }
+      if (octree.computeRayKeys(sensor_origin, point, key_ray)) {
+        for (const auto & ray_key : key_ray) {
+          if (region.contains(octree.keyToCoord(ray_key))) {
+            free_codes.push_back(encodeKey(ray_key));
+          }
+        }
+      }
+    };
+  collectKeys(cloud.size(), num_threads, visit_point, keys);
+}
 
+/***************************************************************************************//**
+ * Function that computes the cells of an octree occupied by a point cloud without casting
+ * rays, so no cell is marked as free. With a positive occlusion depth, the cells up to that
+ * distance behind each point, as seen from the sensor, are treated as occupied too. These
+ * cells are hidden by the surface and are unknown to the sensor.
+ * @param octree Octree that the keys are computed for
+ * @param cloud Input cloud
+ * @param sensor_origin Origin of the sensor
+ * @param num_threads Number of threads to use
+ * @param occlusion_depth Depth of unknown space behind surfaces treated as occupied
+ * @param keys Output keys
+ * @param region Region that updates are restricted to
+ *******************************************************************************************/
+template<typename PointT>
+void FCLFunctions::computeSurfaceKeys(
+  const octomap::OcTree & octree,
+  const pcl::PointCloud<PointT> & cloud,
+  const octomap::point3d & sensor_origin,
+  const unsigned int & num_threads,
+  const float & occlusion_depth,
+  IntegrationKeys & keys,
+  const UpdateRegion & region)
+{
+  auto visit_point = [&](
+    size_t i, octomap::KeyRay & key_ray,
+    std::vector<uint64_t> &, std::vector<uint64_t> & occupied_codes) {
+      octomap::point3d point(cloud[i].x, cloud[i].y, cloud[i].z);
       octomap::OcTreeKey tree_key;
-      if (octomap_octree->coordToKeyChecked(point, tree_key)) {
-        local_occupied_cells.insert(tree_key);
+      if (!region.contains(point) || !octree.coordToKeyChecked(point, tree_key)) {
+        return;
       }
-    }
+      occupied_codes.push_back(encodeKey(tree_key));
 
-#if defined(_OPENMP)
-#pragma omp critical
-#endif
-    {
-      free_cells.insert(local_free_cells.begin(), local_free_cells.end());
-      occupied_cells.insert(local_occupied_cells.begin(), local_occupied_cells.end());
-    }
-  }
+      if (occlusion_depth <= 0) {
+        return;
+      }
+      octomap::point3d direction = point - sensor_origin;
+      if (direction.norm() <= 0) {
+        return;
+      }
+      octomap::point3d occlusion_end = point + direction.normalized() * occlusion_depth;
+      if (octree.computeRayKeys(point, occlusion_end, key_ray)) {
+        for (const auto & ray_key : key_ray) {
+          if (region.contains(octree.keyToCoord(ray_key))) {
+            occupied_codes.push_back(encodeKey(ray_key));
+          }
+        }
+      }
+      octomap::OcTreeKey end_key;
+      if (region.contains(occlusion_end) && octree.coordToKeyChecked(occlusion_end, end_key)) {
+        occupied_codes.push_back(encodeKey(end_key));
+      }
+    };
+  collectKeys(cloud.size(), num_threads, visit_point, keys);
+}
 
-  // free cells only if not occupied in this cloud
-  for (auto it = free_cells.begin(); it != free_cells.end(); ++it) {
-    if (occupied_cells.find(*it) == occupied_cells.end()) {
-      octomap_octree->updateNode(*it, false);
-    }
+/***************************************************************************************//**
+ * Function that returns the octree integration mode with the given parameter name.
+ * @param mode_name One of "ray_casting", "occupied_only" and "occluded_occupied"
+ *******************************************************************************************/
+FCLFunctions::IntegrationMode FCLFunctions::getIntegrationMode(const std::string & mode_name)
+{
+  if (mode_name.compare("ray_casting") == 0) {
+    return IntegrationMode::RAY_CASTING;
+  } else if (mode_name.compare("occupied_only") == 0) {
+    return IntegrationMode::OCCUPIED_ONLY;
+  } else if (mode_name.compare("occluded_occupied") == 0) {
+    return IntegrationMode::OCCLUDED_OCCUPIED;
   }
+  throw std::invalid_argument("Invalid world model mode: " + mode_name);
+}
 
-  // occupied cells
-  for (auto it = occupied_cells.begin(); it != occupied_cells.end(); ++it) {
-    octomap_octree->updateNode(*it, true);
+/***************************************************************************************//**
+ * Function that applies free and occupied cells to an octree. Cells are updated in Morton
+ * order with lazy evaluation, and inner nodes are updated once at the end.
+ * @param octree Octree to update
+ * @param keys Cells to update
+ *******************************************************************************************/
+void FCLFunctions::applyIntegrationKeys(octomap::OcTree & octree, const IntegrationKeys & keys)
+{
+  for (const auto & key : keys.free_cells) {
+    octree.updateNode(key, false, true);
   }
+  for (const auto & key : keys.occupied_cells) {
+    octree.updateNode(key, true, true);
+  }
+  octree.updateInnerOccupancy();
+  octree.prune();
+}
 
-  // return octomap_octree;
+namespace
+{
+template<typename PointT>
+std::shared_ptr<CollisionObject> createCollisionObject(
+  const pcl::PointCloud<PointT> & cloud,
+  const octomap::point3d & sensor_origin_wrt_world,
+  float resolution,
+  unsigned int num_threads,
+  FCLFunctions::IntegrationMode mode,
+  float occlusion_depth)
+{
+  std::shared_ptr<octomap::OcTree> octomap_octree = std::make_shared<octomap::OcTree>(resolution);
+  octomap_octree->setProbHit(prob_hit);
+  octomap_octree->setProbMiss(prob_miss);
+  octomap_octree->setClampingThresMin(clamping_thres_min);
+  octomap_octree->setClampingThresMax(clamping_thres_max);
+
+  FCLFunctions::IntegrationKeys keys;
+  if (mode == FCLFunctions::IntegrationMode::RAY_CASTING) {
+    FCLFunctions::computeIntegrationKeys(
+      *octomap_octree, cloud, sensor_origin_wrt_world, num_threads, keys);
+  } else {
+    FCLFunctions::computeSurfaceKeys(
+      *octomap_octree, cloud, sensor_origin_wrt_world, num_threads,
+      mode == FCLFunctions::IntegrationMode::OCCLUDED_OCCUPIED ? occlusion_depth : 0.0f, keys);
+  }
+  FCLFunctions::applyIntegrationKeys(*octomap_octree, keys);
 
   auto fcl_octree = std::make_shared<OcTree>(octomap_octree);
   std::shared_ptr<CollisionGeometry> fcl_geometry = fcl_octree;
-  std::make_shared<CollisionObject>(fcl_geometry);
   return std::make_shared<CollisionObject>(fcl_geometry);
 }
+}  // namespace
+
+std::shared_ptr<CollisionObject> FCLFunctions::createCollisionObjectFromPointCloudRGB(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_ptr,
+  const octomap::point3d & sensor_origin_wrt_world,
+  float resolution,
+  unsigned int num_threads,
+  IntegrationMode mode,
+  float occlusion_depth)
+{
+  return createCollisionObject(
+    *pointcloud_ptr, sensor_origin_wrt_world, resolution, num_threads, mode, occlusion_depth);
+}
+
+std::shared_ptr<CollisionObject> FCLFunctions::createCollisionObjectFromPointCloud(
+  const pcl::PointCloud<pcl::PointXYZ>::Ptr & pointcloud_ptr,
+  const octomap::point3d & sensor_origin_wrt_world,
+  float resolution,
+  unsigned int num_threads,
+  IntegrationMode mode,
+  float occlusion_depth)
+{
+  return createCollisionObject(
+    *pointcloud_ptr, sensor_origin_wrt_world, resolution, num_threads, mode, occlusion_depth);
+}
+
+template void FCLFunctions::computeIntegrationKeys<pcl::PointXYZ>(
+  const octomap::OcTree &, const pcl::PointCloud<pcl::PointXYZ> &, const octomap::point3d &,
+  const unsigned int &, IntegrationKeys &, const UpdateRegion &,
+  const std::function<bool(const octomap::OcTreeKey &)> &);
+template void FCLFunctions::computeIntegrationKeys<pcl::PointXYZRGB>(
+  const octomap::OcTree &, const pcl::PointCloud<pcl::PointXYZRGB> &, const octomap::point3d &,
+  const unsigned int &, IntegrationKeys &, const UpdateRegion &,
+  const std::function<bool(const octomap::OcTreeKey &)> &);
+template void FCLFunctions::computeSurfaceKeys<pcl::PointXYZ>(
+  const octomap::OcTree &, const pcl::PointCloud<pcl::PointXYZ> &, const octomap::point3d &,
+  const unsigned int &, const float &, IntegrationKeys &, const UpdateRegion &);
+template void FCLFunctions::computeSurfaceKeys<pcl::PointXYZRGB>(
+  const octomap::OcTree &, const pcl::PointCloud<pcl::PointXYZRGB> &, const octomap::point3d &,
+  const unsigned int &, const float &, IntegrationKeys &, const UpdateRegion &);
@@ -14,6 +14,9 @@
 // limitations under the License.
 // Main PCL files
 
+#include <algorithm>
+#include <cmath>
+
 #include "emd/common/math_functions.hpp"
 #include "rclcpp/rclcpp.hpp"
 
@@ -122,3 +125,31 @@ std::string MathFunctions::generate_task_id()
   boost::uuids::uuid uuid = boost::uuids::random_generator()();
   return boost::uuids::to_string(uuid);
 }
+
+/****************************************************************************************//**
+ * Function that returns the indexes of the highest ranks, in decreasing order of rank. Equal
+ * ranks keep their order and ranks that are not a number are left out.
+ * @param ranks Ranks to select from
+ * @param max_count Maximum number of indexes returned, 0 returns all of them
+ *******************************************************************************************/
+std::vector<size_t> MathFunctions::getTopRankIndices(
+  const std::vector<float> & ranks,
+  const size_t & max_count)
+{
+  std::vector<size_t> indices;
+  indices.reserve(ranks.size());
+  for (size_t index = 0; index < ranks.size(); index++) {
+    if (!std::isnan(ranks[index])) {
+      indices.push_back(index);
+    }
+  }
+  const size_t count = max_count > 0 ? std::min(max_count, indices.size()) : indices.size();
+  std::partial_sort(
+    indices.begin(), indices.begin() + count, indices.end(),
+    [&ranks](const size_t & index_1, const size_t & index_2) {
+      return ranks[index_1] > ranks[index_2] ||
+      (ranks[index_1] == ranks[index_2] && index_1 < index_2);
+    });
+  indices.resize(count);
+  return indices;
+}
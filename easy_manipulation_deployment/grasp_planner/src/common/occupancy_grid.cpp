@@ -0,0 +1,383 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/occupancy_grid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+using namespace grasp_planner::collision;
+
+namespace
+{
+// Squared distance of cells with no occupied cell in reach yet, finite so that it can be
+// subtracted from itself
+const float far_distance = 1e20f;
+
+/* Lower envelope of the parabolas rooted at each cell of a line, which gives the squared
+   distance to the nearest root along the line (Felzenszwalb and Huttenlocher) */
+void distanceTransform(
+  const std::vector<float> & f, const int & n,
+  std::vector<float> & d, std::vector<int> & v, std::vector<float> & z)
+{
+  auto intersection = [&f](int q, int p) {
+      return ((f[q] + q * q) - (f[p] + p * p)) / (2 * q - 2 * p);
+    };
+  int k = 0;
+  v[0] = 0;
+  z[0] = -std::numeric_limits<float>::infinity();
+  z[1] = std::numeric_limits<float>::infinity();
+  for (int q = 1; q < n; q++) {
+    float s = intersection(q, v[k]);
+    while (s <= z[k]) {
+      k--;
+      s = intersection(q, v[k]);
+    }
+    k++;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = std::numeric_limits<float>::infinity();
+  }
+  k = 0;
+  for (int q = 0; q < n; q++) {
+    while (z[k + 1] < q) {
+      k++;
+    }
+    d[q] = static_cast<float>((q - v[k]) * (q - v[k])) + f[v[k]];
+  }
+}
+}  // namespace
+
+/***************************************************************************************//**
+ * Function that returns the collision check mode with the given name
+ * @param mode_name Name of the mode, one of "fcl", "voxel" or "validate"
+ *******************************************************************************************/
+CollisionCheckMode grasp_planner::collision::getCollisionCheckMode(const std::string & mode_name)
+{
+  if (mode_name.compare("fcl") == 0) {
+    return CollisionCheckMode::FCL;
+  } else if (mode_name.compare("voxel") == 0) {
+    return CollisionCheckMode::VOXEL;
+  } else if (mode_name.compare("validate") == 0) {
+    return CollisionCheckMode::VALIDATE;
+  }
+  throw std::invalid_argument("Invalid collision check mode: " + mode_name);
+}
+
+OccupancyGrid::OccupancyGrid()
+: resolution(0),
+  origin(Eigen::Vector3f::Zero()),
+  dims(Eigen::Vector3i::Zero()),
+  occupied_count(0)
+{
+}
+
+/***************************************************************************************//**
+ * Function that rebuilds the grid from the occupied cells of an octree collision object.
+ * The grid spans the bounding box of the occupied cells, with the size of the smallest
+ * occupied cell as resolution. Octree nodes are aligned to multiples of their size, so every
+ * larger occupied node covers whole cells. Returns false, leaving the grid empty, if the
+ * object is not an octree or the grid would need more than max_cells cells.
+ * @param world Octree collision object, its transform is assumed to be the identity
+ * @param max_cells Maximum number of cells of the grid
+ *******************************************************************************************/
+bool OccupancyGrid::build(const CollisionObject & world, const size_t & max_cells)
+{
+  resolution = 0;
+  origin.setZero();
+  dims.setZero();
+  bits.clear();
+  occupied_count = 0;
+  squared_distances.clear();
+
+  std::shared_ptr<const OcTree> octree =
+    std::dynamic_pointer_cast<const OcTree>(world.collisionGeometry());
+  if (!octree) {
+    return false;
+  }
+  // x, y, z of the center, size, occupancy and occupancy threshold of each occupied node
+  const auto boxes = octree->toBoxes();
+  if (boxes.empty()) {
+    return true;
+  }
+
+  float min_size = std::numeric_limits<float>::max();
+  Eigen::Vector3f lower = Eigen::Vector3f::Constant(std::numeric_limits<float>::max());
+  Eigen::Vector3f upper = Eigen::Vector3f::Constant(std::numeric_limits<float>::lowest());
+  for (const auto & box : boxes) {
+    const float half_size = static_cast<float>(box[3]) / 2;
+    min_size = std::min(min_size, static_cast<float>(box[3]));
+    for (int axis = 0; axis < 3; axis++) {
+      lower(axis) = std::min(lower(axis), static_cast<float>(box[axis]) - half_size);
+      upper(axis) = std::max(upper(axis), static_cast<float>(box[axis]) + half_size);
+    }
+  }
+
+  size_t num_cells = 1;
+  for (int axis = 0; axis < 3; axis++) {
+    dims(axis) = std::max(1, static_cast<int>(std::lround((upper(axis) - lower(axis)) / min_size)));
+    num_cells *= static_cast<size_t>(dims(axis));
+  }
+  if (num_cells > max_cells) {
+    dims.setZero();
+    return false;
+  }
+  resolution = min_size;
+  origin = lower;
+  bits.assign((num_cells + 63) / 64, 0);
+
+  for (const auto & box : boxes) {
+    const float half_size = static_cast<float>(box[3]) / 2;
+    const int cells_per_edge = static_cast<int>(std::lround(box[3] / resolution));
+    Eigen::Vector3i min_index;
+    for (int axis = 0; axis < 3; axis++) {
+      min_index(axis) = static_cast<int>(
+        std::lround((static_cast<float>(box[axis]) - half_size - origin(axis)) / resolution));
+    }
+    fillCells(min_index, min_index + Eigen::Vector3i::Constant(cells_per_edge));
+  }
+  return true;
+}
+
+/***************************************************************************************//**
+ * Function that marks a block of cells as occupied, clamped to the grid
+ * @param min Lowest cell index of the block
+ * @param max One past the highest cell index of the block
+ *******************************************************************************************/
+void OccupancyGrid::fillCells(const Eigen::Vector3i & min, const Eigen::Vector3i & max)
+{
+  const Eigen::Vector3i begin = min.cwiseMax(0);
+  const Eigen::Vector3i end = max.cwiseMin(dims);
+  for (int z = begin(2); z < end(2); z++) {
+    for (int y = begin(1); y < end(1); y++) {
+      for (int x = begin(0); x < end(0); x++) {
+        const size_t index = (static_cast<size_t>(z) * dims(1) + y) * dims(0) + x;
+        const uint64_t mask = uint64_t(1) << (index & 63);
+        if (!(bits[index >> 6] & mask)) {
+          bits[index >> 6] |= mask;
+          occupied_count++;
+        }
+      }
+    }
+  }
+}
+
+/***************************************************************************************//**
+ * Function that checks if a sphere overlaps any occupied cell. With a distance field, the
+ * distance of the cell containing the center settles spheres that are clearly clear of or
+ * inside the occupied cells. Any point of a cell is within half a cell diagonal of its
+ * center, so the distance from the center of the sphere to the occupied cells is within one
+ * cell diagonal below and half a cell diagonal above the distance of its cell.
+ * @param center Center of the sphere
+ * @param radius Radius of the sphere
+ *******************************************************************************************/
+bool OccupancyGrid::sphereCollides(const Eigen::Vector3f & center, const float & radius) const
+{
+  if (occupied_count == 0) {
+    return false;
+  }
+  if (!squared_distances.empty()) {
+    const int64_t index = getCellIndex(center);
+    if (index >= 0) {
+      const float cell_distance = std::sqrt(squared_distances[index]) * resolution;
+      const float half_diagonal = std::sqrt(3.0f) / 2 * resolution;
+      if (cell_distance - 2 * half_diagonal > radius) {
+        return false;
+      }
+      if (cell_distance + half_diagonal <= radius) {
+        return true;
+      }
+    }
+  }
+  return scanSphere(center, radius);
+}
+
+/***************************************************************************************//**
+ * Function that checks a sphere against the cells it reaches. Only the cells within the
+ * bounding box of the sphere are visited, and a cell is looked up only if the sphere reaches
+ * into it.
+ * @param center Center of the sphere
+ * @param radius Radius of the sphere
+ *******************************************************************************************/
+bool OccupancyGrid::scanSphere(const Eigen::Vector3f & center, const float & radius) const
+{
+  int begin[3];
+  int end[3];
+  for (int axis = 0; axis < 3; axis++) {
+    const float low = std::floor((center(axis) - radius - origin(axis)) / resolution);
+    const float high = std::floor((center(axis) + radius - origin(axis)) / resolution);
+    if (high < 0 || low >= static_cast<float>(dims(axis))) {
+      return false;
+    }
+    begin[axis] = static_cast<int>(std::max(low, 0.0f));
+    end[axis] = static_cast<int>(std::min(high, static_cast<float>(dims(axis) - 1))) + 1;
+  }
+
+  // Squared distance along an axis from the center to a cell
+  auto axisDistance = [&](int axis, int cell) {
+      const float cell_min = origin(axis) + cell * resolution;
+      const float distance = std::max(
+        {cell_min - center(axis), center(axis) - cell_min - resolution, 0.0f});
+      return distance * distance;
+    };
+
+  const float squared_radius = radius * radius;
+  for (int z = begin[2]; z < end[2]; z++) {
+    const float distance_z = axisDistance(2, z);
+    if (distance_z > squared_radius) {
+      continue;
+    }
+    for (int y = begin[1]; y < end[1]; y++) {
+      const float distance_yz = distance_z + axisDistance(1, y);
+      if (distance_yz > squared_radius) {
+        continue;
+      }
+      const size_t row = (static_cast<size_t>(z) * dims(1) + y) * dims(0);
+      for (int x = begin[0]; x < end[0]; x++) {
+        const size_t index = row + x;
+        if (((bits[index >> 6] >> (index & 63)) & 1) &&
+          distance_yz + axisDistance(0, x) <= squared_radius)
+        {
+          return true;
+        }
+      }
+    }
+  }
+  return false;
+}
+
+/***************************************************************************************//**
+ * Function that checks a batch of spheres, such as the fingers of one gripper configuration
+ * @param centers Centers of the spheres
+ * @param radius Radius of the spheres
+ *******************************************************************************************/
+bool OccupancyGrid::anySphereCollides(
+  const std::vector<Eigen::Vector3f> & centers,
+  const float & radius) const
+{
+  for (const auto & center : centers) {
+    if (sphereCollides(center, radius)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/***************************************************************************************//**
+ * Function that computes the Euclidean distance field of the grid with three separable
+ * linear time passes, one along each axis. Returns false, without a distance field, if the
+ * grid is empty or has more than max_cells cells.
+ * @param max_cells Maximum number of cells of the grid
+ *******************************************************************************************/
+bool OccupancyGrid::computeDistanceField(const size_t & max_cells)
+{
+  squared_distances.clear();
+  const size_t num_cells = static_cast<size_t>(dims(0)) * dims(1) * dims(2);
+  if (occupied_count == 0 || num_cells > max_cells) {
+    return false;
+  }
+  squared_distances.resize(num_cells);
+  for (size_t index = 0; index < num_cells; index++) {
+    squared_distances[index] = ((bits[index >> 6] >> (index & 63)) & 1) ? 0 : far_distance;
+  }
+
+  const int max_dim = dims.maxCoeff();
+  std::vector<float> line(max_dim);
+  std::vector<float> transformed(max_dim);
+  std::vector<int> roots(max_dim);
+  std::vector<float> boundaries(max_dim + 1);
+  const size_t strides[3] = {1, static_cast<size_t>(dims(0)),
+    static_cast<size_t>(dims(0)) * dims(1)};
+  for (int axis = 0; axis < 3; axis++) {
+    // Every line along the axis starts at a cell whose index along the axis is 0
+    const int n = dims(axis);
+    const int other_1 = (axis + 1) % 3;
+    const int other_2 = (axis + 2) % 3;
+    for (int i = 0; i < dims(other_2); i++) {
+      for (int j = 0; j < dims(other_1); j++) {
+        const size_t start = i * strides[other_2] + j * strides[other_1];
+        for (int q = 0; q < n; q++) {
+          line[q] = squared_distances[start + q * strides[axis]];
+        }
+        distanceTransform(line, n, transformed, roots, boundaries);
+        for (int q = 0; q < n; q++) {
+          squared_distances[start + q * strides[axis]] = transformed[q];
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool OccupancyGrid::hasDistanceField() const
+{
+  return !squared_distances.empty();
+}
+
+/***************************************************************************************//**
+ * Function that returns the distance from a point to the nearest occupied cell, to within a
+ * cell diagonal. Outside the grid the distance to the grid is returned, a lower bound. Without
+ * a distance field the largest float is returned.
+ * @param point Query point
+ *******************************************************************************************/
+float OccupancyGrid::clearance(const Eigen::Vector3f & point) const
+{
+  if (squared_distances.empty()) {
+    return std::numeric_limits<float>::max();
+  }
+  const Eigen::Vector3f upper = origin + dims.cast<float>() * resolution;
+  const float outside_distance =
+    (origin - point).cwiseMax(point - upper).cwiseMax(0.0f).norm();
+  const int64_t index = getCellIndex(point);
+  if (index < 0) {
+    return outside_distance;
+  }
+  return std::max(0.0f, std::sqrt(squared_distances[index]) * resolution - resolution / 2);
+}
+
+/***************************************************************************************//**
+ * Function that returns the index of the cell containing a point
+ * @param point Query point
+ *******************************************************************************************/
+int64_t OccupancyGrid::getCellIndex(const Eigen::Vector3f & point) const
+{
+  int64_t cell[3];
+  for (int axis = 0; axis < 3; axis++) {
+    const float position = std::floor((point(axis) - origin(axis)) / resolution);
+    if (!(position >= 0 && position < static_cast<float>(dims(axis)))) {
+      return -1;
+    }
+    cell[axis] = static_cast<int64_t>(position);
+  }
+  return (cell[2] * dims(1) + cell[1]) * dims(0) + cell[0];
+}
+
+bool OccupancyGrid::empty() const
+{
+  return occupied_count == 0;
+}
+
+float OccupancyGrid::getResolution() const
+{
+  return resolution;
+}
+
+size_t OccupancyGrid::getOccupiedCount() const
+{
+  return occupied_count;
+}
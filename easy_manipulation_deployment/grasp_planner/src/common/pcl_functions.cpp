@@ -16,6 +16,388 @@
 
 #include "emd/common/pcl_functions.hpp"
 
+namespace
+{
+/*! \brief Number of points evaluated together when building the crop mask */
+constexpr size_t kCropBlockSize = 256;
+/*! \brief Minimum number of points for a worker thread to be worth starting */
+constexpr size_t kMinPointsPerThread = 16384;
+/*! \brief Bits used for each voxel coordinate in a packed voxel key */
+constexpr int kVoxelKeyBits = 21;
+constexpr int64_t kVoxelKeyOffset = int64_t(1) << (kVoxelKeyBits - 1);
+/*! \brief Largest finite float, used to reject infinite coordinates */
+constexpr float kMaxFinite = std::numeric_limits<float>::max();
+
+/*! \brief Axis aligned crop limits, lower and upper bound per axis */
+struct CropLimits
+{
+  float min_x, max_x, min_y, max_y, min_z, max_z;
+};
+
+/***************************************************************************************//**
+ * Computes the packed voxel key of a point, with the same voxel coordinates as pcl::VoxelGrid
+ * and a z major ordering, which is the order pcl::VoxelGrid outputs its voxels in.
+ * @param x X coordinate of the point (Same for y and z)
+ * @param inverse_leaf Inverse of the voxel leaf size
+ * @param key_valid Cleared if a voxel coordinate does not fit in a packed voxel key
+ *******************************************************************************************/
+inline int64_t getVoxelKey(
+  const float x, const float y, const float z, const float inverse_leaf, bool & key_valid)
+{
+  const int64_t voxel_x = static_cast<int64_t>(std::floor(x * inverse_leaf));
+  const int64_t voxel_y = static_cast<int64_t>(std::floor(y * inverse_leaf));
+  const int64_t voxel_z = static_cast<int64_t>(std::floor(z * inverse_leaf));
+  if (std::abs(voxel_x) >= kVoxelKeyOffset || std::abs(voxel_y) >= kVoxelKeyOffset ||
+    std::abs(voxel_z) >= kVoxelKeyOffset)
+  {
+    key_valid = false;
+  }
+  return ((voxel_z + kVoxelKeyOffset) << (2 * kVoxelKeyBits)) |
+         ((voxel_y + kVoxelKeyOffset) << kVoxelKeyBits) |
+         (voxel_x + kVoxelKeyOffset);
+}
+
+/***************************************************************************************//**
+ * Crops a contiguous range of points. Coordinates are gathered into small structure-of-arrays
+ * blocks so that the NaN and limit checks can be evaluated branch free, after which the
+ * surviving points are compacted in their original order. If inverse_leaf is positive the
+ * packed voxel key of each surviving point is written out in the same pass.
+ * @param begin Start of the point range
+ * @param end End of the point range
+ * @param limits Crop limits
+ * @param inverse_leaf Inverse of the voxel leaf size, or 0 if no keys are required
+ * @param output_points Surviving points
+ * @param output_keys Voxel keys of the surviving points
+ * @return false if a voxel coordinate does not fit in a packed voxel key
+ *******************************************************************************************/
+bool cropRange(
+  const pcl::PointXYZRGB * begin,
+  const pcl::PointXYZRGB * end,
+  const CropLimits & limits,
+  const float inverse_leaf,
+  std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> & output_points,
+  std::vector<int64_t> & output_keys)
+{
+  float x[kCropBlockSize], y[kCropBlockSize], z[kCropBlockSize];
+  uint8_t keep[kCropBlockSize];
+  bool keys_valid = true;
+  for (const pcl::PointXYZRGB * block = begin; block < end; block += kCropBlockSize) {
+    const size_t block_size = std::min(kCropBlockSize, static_cast<size_t>(end - block));
+    for (size_t i = 0; i < block_size; i++) {
+      x[i] = block[i].x;
+      y[i] = block[i].y;
+      z[i] = block[i].z;
+    }
+    // NaN values fail every comparison, so they are rejected together with the crop
+    for (size_t i = 0; i < block_size; i++) {
+      keep[i] = (std::abs(x[i]) <= kMaxFinite) & (std::abs(y[i]) <= kMaxFinite) &
+        (std::abs(z[i]) <= kMaxFinite) &
+        (x[i] >= limits.min_x) & (x[i] <= limits.max_x) &
+        (y[i] >= limits.min_y) & (y[i] <= limits.max_y) &
+        (z[i] >= limits.min_z) & (z[i] <= limits.max_z);
+    }
+    for (size_t i = 0; i < block_size; i++) {
+      if (!keep[i]) {
+        continue;
+      }
+      output_points.push_back(block[i]);
+      if (inverse_leaf > 0) {
+        output_keys.push_back(getVoxelKey(x[i], y[i], z[i], inverse_leaf, keys_valid));
+      }
+    }
+  }
+  return keys_valid;
+}
+
+/***************************************************************************************//**
+ * Crops a cloud, splitting the work into contiguous chunks over up to num_threads threads.
+ * The chunks are concatenated in order, so the output is independent of the thread count.
+ * @param input_cloud Input cloud
+ * @param limits Crop limits
+ * @param inverse_leaf Inverse of the voxel leaf size, or 0 if no keys are required
+ * @param num_threads Maximum number of threads to use
+ * @param output_points Surviving points
+ * @param output_keys Voxel keys of the surviving points
+ * @return false if a voxel coordinate does not fit in a packed voxel key
+ *******************************************************************************************/
+bool cropCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB> & input_cloud,
+  const CropLimits & limits,
+  const float inverse_leaf,
+  const int num_threads,
+  std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> & output_points,
+  std::vector<int64_t> & output_keys)
+{
+  const size_t num_points = input_cloud.points.size();
+  const pcl::PointXYZRGB * data = input_cloud.points.data();
+  const size_t num_chunks = std::max<size_t>(
+    1, std::min<size_t>(std::max(num_threads, 1), num_points / kMinPointsPerThread));
+
+  output_points.clear();
+  output_keys.clear();
+  if (num_chunks == 1) {
+    output_points.reserve(num_points);
+    output_keys.reserve(inverse_leaf > 0 ? num_points : 0);
+    return cropRange(data, data + num_points, limits, inverse_leaf, output_points, output_keys);
+  }
+
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  std::vector<std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>>>
+  chunk_points(num_chunks);
+  std::vector<std::vector<int64_t>> chunk_keys(num_chunks);
+  std::vector<std::future<bool>> futures;
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    const size_t chunk_begin = chunk * chunk_size;
+    const size_t chunk_end = std::min(num_points, chunk_begin + chunk_size);
+    futures.push_back(
+      std::async(
+        std::launch::async, [&, chunk, chunk_begin, chunk_end]() {
+          chunk_points[chunk].reserve(chunk_end - chunk_begin);
+          return cropRange(
+            data + chunk_begin, data + chunk_end, limits, inverse_leaf,
+            chunk_points[chunk], chunk_keys[chunk]);
+        }));
+  }
+  bool keys_valid = true;
+  size_t total_points = 0;
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    keys_valid &= futures[chunk].get();
+    total_points += chunk_points[chunk].size();
+  }
+  output_points.reserve(total_points);
+  output_keys.reserve(inverse_leaf > 0 ? total_points : 0);
+  for (size_t chunk = 0; chunk < num_chunks; chunk++) {
+    output_points.insert(
+      output_points.end(), chunk_points[chunk].begin(), chunk_points[chunk].end());
+    output_keys.insert(output_keys.end(), chunk_keys[chunk].begin(), chunk_keys[chunk].end());
+  }
+  return keys_valid;
+}
+
+/***************************************************************************************//**
+ * Computes the centroid of every occupied voxel from precomputed voxel keys. Averages
+ * coordinates and colour the same way as pcl::VoxelGrid and outputs voxels in the same order.
+ * @param cloud Input cloud
+ * @param keys Voxel key of every point in the input cloud
+ * @param voxelized_cloud Output cloud of voxel centroids
+ *******************************************************************************************/
+void voxelizeFromKeys(
+  const pcl::PointCloud<pcl::PointXYZRGB> & cloud,
+  const std::vector<int64_t> & keys,
+  pcl::PointCloud<pcl::PointXYZRGB> & voxelized_cloud)
+{
+  std::vector<std::pair<int64_t, uint32_t>> key_index(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    key_index[i] = {keys[i], static_cast<uint32_t>(i)};
+  }
+  std::sort(key_index.begin(), key_index.end());
+
+  voxelized_cloud.points.clear();
+  for (size_t first = 0; first < key_index.size(); ) {
+    size_t last = first;
+    float sum_x = 0, sum_y = 0, sum_z = 0, sum_r = 0, sum_g = 0, sum_b = 0, sum_a = 0;
+    for (; last < key_index.size() && key_index[last].first == key_index[first].first; last++) {
+      const pcl::PointXYZRGB & point = cloud.points[key_index[last].second];
+      sum_x += point.x;
+      sum_y += point.y;
+      sum_z += point.z;
+      sum_r += point.r;
+      sum_g += point.g;
+      sum_b += point.b;
+      sum_a += point.a;
+    }
+    const float num_points = static_cast<float>(last - first);
+    pcl::PointXYZRGB centroid;
+    centroid.x = sum_x / num_points;
+    centroid.y = sum_y / num_points;
+    centroid.z = sum_z / num_points;
+    centroid.rgba = (static_cast<uint32_t>(sum_a / num_points) << 24) |
+      (static_cast<uint32_t>(sum_r / num_points) << 16) |
+      (static_cast<uint32_t>(sum_g / num_points) << 8) |
+      static_cast<uint32_t>(sum_b / num_points);
+    voxelized_cloud.points.push_back(centroid);
+    first = last;
+  }
+  voxelized_cloud.header = cloud.header;
+  voxelized_cloud.width = static_cast<uint32_t>(voxelized_cloud.points.size());
+  voxelized_cloud.height = 1;
+  voxelized_cloud.is_dense = true;
+}
+
+/***************************************************************************************//**
+ * Computes the voxel keys of a cloud whose points are all finite, splitting the work into
+ * contiguous chunks over up to num_threads threads.
+ * @param cloud Input cloud
+ * @param inverse_leaf Inverse of the voxel leaf size
+ * @param num_threads Maximum number of threads to use
+ * @param keys Voxel key of every point in the input cloud
+ * @return false if a voxel coordinate does not fit in a packed voxel key
+ *******************************************************************************************/
+bool computeVoxelKeys(
+  const pcl::PointCloud<pcl::PointXYZRGB> & cloud,
+  const float inverse_leaf,
+  const int num_threads,
+  std::vector<int64_t> & keys)
+{
+  const size_t num_points = cloud.points.size();
+  const size_t num_chunks = std::max<size_t>(
+    1, std::min<size_t>(std::max(num_threads, 1), num_points / kMinPointsPerThread));
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  keys.resize(num_points);
+
+  auto compute_range = [&cloud, &keys, inverse_leaf](size_t range_begin, size_t range_end) {
+      bool keys_valid = true;
+      for (size_t i = range_begin; i < range_end; i++) {
+        const pcl::PointXYZRGB & point = cloud.points[i];
+        keys[i] = getVoxelKey(point.x, point.y, point.z, inverse_leaf, keys_valid);
+      }
+      return keys_valid;
+    };
+  std::vector<std::future<bool>> futures;
+  for (size_t chunk = 1; chunk < num_chunks; chunk++) {
+    futures.push_back(
+      std::async(
+        std::launch::async, compute_range,
+        std::min(num_points, chunk * chunk_size),
+        std::min(num_points, (chunk + 1) * chunk_size)));
+  }
+  bool keys_valid = compute_range(0, std::min(num_points, chunk_size));
+  for (auto & future : futures) {
+    keys_valid &= future.get();
+  }
+  return keys_valid;
+}
+
+/***************************************************************************************//**
+ * Removes statistical outliers from a cropped cloud, keeping its voxel keys aligned with the
+ * remaining points, and downsamples it from the keys. Falls back to pcl::VoxelGrid if a voxel
+ * coordinate did not fit in a packed voxel key.
+ * @param filtered_cloud Cropped cloud, outliers are removed in place
+ * @param keys Voxel key of every point in the cropped cloud
+ * @param keys_valid False if a voxel coordinate did not fit in a packed voxel key
+ * @param outlier_threshold Statistical outlier threshold, outlier removal is skipped if <= 0
+ * @param leaf_size Voxel size of the downsampled cloud
+ * @param voxelized_cloud Downsampled cloud
+ *******************************************************************************************/
+void removeOutliersAndVoxelize(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & filtered_cloud,
+  std::vector<int64_t> & keys,
+  const bool keys_valid,
+  const float outlier_threshold,
+  const float leaf_size,
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & voxelized_cloud)
+{
+  if (outlier_threshold > 0 && !filtered_cloud->points.empty()) {
+    std::vector<int> inlier_indices;
+    pcl::StatisticalOutlierRemoval<pcl::PointXYZRGB> sor;
+    sor.setInputCloud(filtered_cloud);
+    sor.setMeanK(10);
+    sor.setStddevMulThresh(outlier_threshold);
+    sor.filter(inlier_indices);
+
+    // Keep the voxel keys aligned with the remaining points
+    for (size_t i = 0; i < inlier_indices.size(); i++) {
+      filtered_cloud->points[i] = filtered_cloud->points[inlier_indices[i]];
+      keys[i] = keys[inlier_indices[i]];
+    }
+    filtered_cloud->points.resize(inlier_indices.size());
+    keys.resize(inlier_indices.size());
+    filtered_cloud->width = static_cast<uint32_t>(filtered_cloud->points.size());
+  }
+
+  if (keys_valid) {
+    voxelizeFromKeys(*filtered_cloud, keys, *voxelized_cloud);
+  } else {
+    PCLFunctions::voxelizeCloud<pcl::PointCloud<pcl::PointXYZRGB>::Ptr,
+      pcl::VoxelGrid<pcl::PointXYZRGB>>(filtered_cloud, leaf_size, voxelized_cloud);
+  }
+}
+
+/***************************************************************************************//**
+ * Estimates the normal of a set of points of a surface cloud from their neighbours within a
+ * radius, the same way as pcl::NormalEstimationOMP, writing the position and the normal of
+ * each point to the output in one pass. Points are split into contiguous chunks over up to
+ * num_threads threads that share the search tree.
+ * @param surface Cloud the points and their neighbours are taken from
+ * @param search Search tree built on the surface cloud
+ * @param indices Indices of the points to estimate normals for, or nullptr for all points
+ * @param radius Neighbour search radius
+ * @param num_threads Maximum number of threads to use
+ * @param cloud_normal Output cloud with one point per index
+ *******************************************************************************************/
+void estimateNormals(
+  const pcl::PointCloud<pcl::PointXYZRGB> & surface,
+  const pcl::search::KdTree<pcl::PointXYZRGB> & search,
+  const std::vector<int> * indices,
+  const float radius,
+  const int num_threads,
+  pcl::PointCloud<pcl::PointNormal> & cloud_normal)
+{
+  const size_t num_points = indices ? indices->size() : surface.points.size();
+  cloud_normal.points.resize(num_points);
+
+  auto estimate_range = [&](size_t range_begin, size_t range_end) {
+      std::vector<int> nn_indices;
+      std::vector<float> nn_sq_distances;
+      std::vector<int> member_indices;
+      Eigen::Vector4f plane_parameters;
+      float curvature;
+      for (size_t i = range_begin; i < range_end; i++) {
+        const int index = indices ? (*indices)[i] : static_cast<int>(i);
+        const pcl::PointXYZRGB & point = surface.points[index];
+        pcl::PointNormal & output_point = cloud_normal.points[i];
+        output_point.x = point.x;
+        output_point.y = point.y;
+        output_point.z = point.z;
+
+        bool valid = pcl::isFinite(point) &&
+          search.radiusSearch(point, radius, nn_indices, nn_sq_distances) > 0;
+        if (valid && indices) {
+          // Only neighbours that belong to the same set of points
+          member_indices.clear();
+          for (const int nn_index : nn_indices) {
+            if (std::binary_search(indices->begin(), indices->end(), nn_index)) {
+              member_indices.push_back(nn_index);
+            }
+          }
+          nn_indices.swap(member_indices);
+        }
+        if (valid && pcl::computePointNormal(surface, nn_indices, plane_parameters, curvature)) {
+          pcl::flipNormalTowardsViewpoint(point, 0.0f, 0.0f, 0.0f, plane_parameters);
+          output_point.normal_x = plane_parameters[0];
+          output_point.normal_y = plane_parameters[1];
+          output_point.normal_z = plane_parameters[2];
+          output_point.curvature = curvature;
+        } else {
+          output_point.normal_x = output_point.normal_y = output_point.normal_z =
+            output_point.curvature = std::numeric_limits<float>::quiet_NaN();
+        }
+      }
+    };
+
+  const size_t num_chunks = std::max<size_t>(
+    1, std::min<size_t>(std::max(num_threads, 1), num_points));
+  const size_t chunk_size = (num_points + num_chunks - 1) / num_chunks;
+  std::vector<std::future<void>> futures;
+  for (size_t chunk = 1; chunk < num_chunks; chunk++) {
+    futures.push_back(
+      std::async(
+        std::launch::async, estimate_range,
+        std::min(num_points, chunk * chunk_size),
+        std::min(num_points, (chunk + 1) * chunk_size)));
+  }
+  estimate_range(0, std::min(num_points, chunk_size));
+  for (auto & future : futures) {
+    future.get();
+  }
+
+  cloud_normal.header = surface.header;
+  cloud_normal.width = static_cast<uint32_t>(num_points);
+  cloud_normal.height = 1;
+  cloud_normal.is_dense = false;
+}
+}  // namespace
+
 bool PCLFunctions::passthroughFilter(
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
   const float & ptFilter_Ulimit_x,
@@ -25,59 +407,250 @@ bool PCLFunctions::passthroughFilter(
   const float & ptFilter_Ulimit_z,
   const float & ptFilter_Llimit_z)
 {
-  // Remove NaN values
-  std::vector<int> nanIndices;
+  return cropBoxFilter(
+    cloud, cloud,
+    ptFilter_Ulimit_x, ptFilter_Llimit_x,
+    ptFilter_Ulimit_y, ptFilter_Llimit_y,
+    ptFilter_Ulimit_z, ptFilter_Llimit_z, 1);
+}
+
+/***************************************************************************************//**
+ * Function that removes NaN points and points outside an axis aligned box in a single pass.
+ * Produces the same cloud as removing NaN points followed by a pcl::PassThrough filter on
+ * each axis. Input and output may be the same cloud.
+ * @param input_cloud Input cloud
+ * @param output_cloud Output cloud
+ * @param ptFilter_Ulimit_x Upper limit in x direction (Same for y and z)
+ * @param ptFilter_Llimit_x Lower limit in x direction (Same for y and z)
+ * @param num_threads Maximum number of threads used to crop the cloud
+ *******************************************************************************************/
+bool PCLFunctions::cropBoxFilter(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr output_cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const int & num_threads)
+{
+  const CropLimits limits{ptFilter_Llimit_x, ptFilter_Ulimit_x,
+    ptFilter_Llimit_y, ptFilter_Ulimit_y,
+    ptFilter_Llimit_z, ptFilter_Ulimit_z};
+  std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> points;
+  std::vector<int64_t> keys;
+  cropCloud(*input_cloud, limits, 0, num_threads, points, keys);
+
+  output_cloud->header = input_cloud->header;
+  output_cloud->points.swap(points);
+  output_cloud->width = static_cast<uint32_t>(output_cloud->points.size());
+  output_cloud->height = 1;
+  output_cloud->is_dense = true;
+  return true;
+}
+
+/***************************************************************************************//**
+ * Function that performs the scene cloud preprocessing chain of NaN removal, box cropping,
+ * statistical outlier removal and voxel downsampling. NaN rejection, cropping and voxel
+ * hashing are done in one pass over the input, so the output matches passthroughFilter,
+ * removeStatisticalOutlier and a pcl::VoxelGrid run one after another.
+ * @param input_cloud Input cloud
+ * @param ptFilter_Ulimit_x Upper limit in x direction (Same for y and z)
+ * @param ptFilter_Llimit_x Lower limit in x direction (Same for y and z)
+ * @param outlier_threshold Statistical outlier threshold, outlier removal is skipped if <= 0
+ * @param leaf_size Voxel size of the downsampled cloud
+ * @param filtered_cloud Cropped cloud without outliers. May be the same as input_cloud
+ * @param voxelized_cloud Downsampled cloud
+ * @param num_threads Maximum number of threads used to crop the cloud
+ *******************************************************************************************/
+bool PCLFunctions::preprocessCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const float & outlier_threshold,
+  const float & leaf_size,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr filtered_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr voxelized_cloud,
+  const int & num_threads)
+{
+  if (leaf_size <= 0) {
+    return false;
+  }
+  const CropLimits limits{ptFilter_Llimit_x, ptFilter_Ulimit_x,
+    ptFilter_Llimit_y, ptFilter_Ulimit_y,
+    ptFilter_Llimit_z, ptFilter_Ulimit_z};
+  std::vector<pcl::PointXYZRGB, Eigen::aligned_allocator<pcl::PointXYZRGB>> points;
+  std::vector<int64_t> keys;
+  const bool keys_valid = cropCloud(
+    *input_cloud, limits, 1.0f / leaf_size, num_threads, points, keys);
 
-  pcl::removeNaNFromPointCloud(*cloud, *cloud, nanIndices);
+  filtered_cloud->header = input_cloud->header;
+  filtered_cloud->points.swap(points);
+  filtered_cloud->width = static_cast<uint32_t>(filtered_cloud->points.size());
+  filtered_cloud->height = 1;
+  filtered_cloud->is_dense = true;
 
-  // Remove background points
-  pcl::PassThrough<pcl::PointXYZRGB> ptFilter;
-  ptFilter.setInputCloud(cloud);
-  ptFilter.setFilterFieldName("z");
-  ptFilter.setFilterLimits(ptFilter_Llimit_z, ptFilter_Ulimit_z);
-  ptFilter.filter(*cloud);
+  removeOutliersAndVoxelize(
+    filtered_cloud, keys, keys_valid, outlier_threshold, leaf_size, voxelized_cloud);
+  return true;
+}
 
-  ptFilter.setInputCloud(cloud);
-  ptFilter.setFilterFieldName("y");
-  ptFilter.setFilterLimits(ptFilter_Llimit_y, ptFilter_Ulimit_y);
-  ptFilter.filter(*cloud);
+/***************************************************************************************//**
+ * Function that performs the preprocessing chain of preprocessCloud on a cloud that has
+ * already been cropped to the passthrough limits and is free of NaN points, such as the
+ * output of SensorMsgtoFilteredPointCloud, so that the crop is not checked a second time.
+ * @param input_cloud Cropped input cloud without NaN points
+ * @param outlier_threshold Statistical outlier threshold, outlier removal is skipped if <= 0
+ * @param leaf_size Voxel size of the downsampled cloud
+ * @param filtered_cloud Input cloud without outliers. May be the same as input_cloud
+ * @param voxelized_cloud Downsampled cloud
+ * @param num_threads Maximum number of threads used to hash the points into voxels
+ *******************************************************************************************/
+bool PCLFunctions::downsampleCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  const float & outlier_threshold,
+  const float & leaf_size,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr filtered_cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr voxelized_cloud,
+  const int & num_threads)
+{
+  if (leaf_size <= 0) {
+    return false;
+  }
+  if (filtered_cloud != input_cloud) {
+    *filtered_cloud = *input_cloud;
+  }
+  filtered_cloud->width = static_cast<uint32_t>(filtered_cloud->points.size());
+  filtered_cloud->height = 1;
+  filtered_cloud->is_dense = true;
 
-  ptFilter.setInputCloud(cloud);
-  ptFilter.setFilterFieldName("x");
-  ptFilter.setFilterLimits(ptFilter_Llimit_x, ptFilter_Ulimit_x);
-  ptFilter.filter(*cloud);
+  std::vector<int64_t> keys;
+  const bool keys_valid = computeVoxelKeys(*filtered_cloud, 1.0f / leaf_size, num_threads, keys);
+  removeOutliersAndVoxelize(
+    filtered_cloud, keys, keys_valid, outlier_threshold, leaf_size, voxelized_cloud);
   return true;
 }
 
-void PCLFunctions::SensorMsgtoPCLPointCloud2(
+/***************************************************************************************//**
+ * Function that reads XYZ(RGB) points directly out of a PointCloud2 message buffer by field
+ * offset, dropping NaN points and points outside the passthrough limits while reading.
+ * Produces the same cloud as SensorMsgtoPCLPointCloud2 + pcl::fromPCLPointCloud2 +
+ * passthroughFilter without the two intermediate copies of the message data. An organized
+ * copy of the message can be written in the same pass, with the dropped points set to NaN.
+ * @param pc2 Input PointCloud2 message
+ * @param cloud Output cloud
+ * @param ptFilter_Ulimit_x Upper limit in x direction (Same for y and z)
+ * @param ptFilter_Llimit_x Lower limit in x direction (Same for y and z)
+ * @param organized_cloud Optional output cloud with the width and height of the message
+ * @return false if the field layout is not supported, in which case the caller should fall
+ * back to SensorMsgtoPCLPointCloud2
+ *******************************************************************************************/
+bool PCLFunctions::SensorMsgtoFilteredPointCloud(
   const sensor_msgs::msg::PointCloud2 & pc2,
-  pcl::PCLPointCloud2 & pcl_pc2)
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr organized_cloud)
 {
-  try {
-    pcl_pc2.header.stamp = pc2.header.stamp.nanosec / 1000ull;
-    pcl_pc2.header.seq = 0;
-    pcl_pc2.header.frame_id = pc2.header.frame_id;
-    pcl_pc2.height = pc2.height;
-    pcl_pc2.width = pc2.width;
-    pcl_pc2.fields.clear();
+  const uint32_t host_is_little_endian = 1;
+  if (static_cast<bool>(pc2.is_bigendian) ==
+    static_cast<bool>(*reinterpret_cast<const uint8_t *>(&host_is_little_endian)))
+  {
+    return false;
+  }
 
-    for (int i = 0; i < static_cast<int>(pc2.fields.size()); i++) {
-      pcl::PCLPointField pcl_pf;
-      pcl_pf.name = pc2.fields[i].name;
-      pcl_pf.offset = pc2.fields[i].offset;
-      pcl_pf.datatype = pc2.fields[i].datatype;
-      pcl_pf.count = pc2.fields[i].count;
-      pcl_pc2.fields.push_back(pcl_pf);
+  int x_offset = -1, y_offset = -1, z_offset = -1, rgb_offset = -1;
+  for (const auto & field : pc2.fields) {
+    if (field.count != 1) {
+      continue;
     }
-    pcl_pc2.is_bigendian = pc2.is_bigendian;
-    pcl_pc2.point_step = pc2.point_step;
-    pcl_pc2.row_step = pc2.row_step;
-    pcl_pc2.is_dense = pc2.is_dense;
+    if (field.datatype == sensor_msgs::msg::PointField::FLOAT32) {
+      if (field.name == "x") {
+        x_offset = field.offset;
+      } else if (field.name == "y") {
+        y_offset = field.offset;
+      } else if (field.name == "z") {
+        z_offset = field.offset;
+      }
+    }
+    if ((field.name == "rgb" || field.name == "rgba") &&
+      (field.datatype == sensor_msgs::msg::PointField::FLOAT32 ||
+      field.datatype == sensor_msgs::msg::PointField::UINT32))
+    {
+      rgb_offset = field.offset;
+    }
+  }
+  if (x_offset < 0 || y_offset < 0 || z_offset < 0) {
+    return false;
+  }
+  const int max_offset = std::max({x_offset, y_offset, z_offset, rgb_offset});
+  if (pc2.point_step < static_cast<uint32_t>(max_offset) + 4 ||
+    pc2.row_step < pc2.width * pc2.point_step ||
+    pc2.data.size() < static_cast<size_t>(pc2.row_step) * pc2.height)
+  {
+    return false;
+  }
 
-    pcl_pc2.data = pc2.data;
-  } catch (...) {
-    std::cout << "ERROR" << std::endl;
+  cloud->points.clear();
+  cloud->points.reserve(static_cast<size_t>(pc2.width) * pc2.height);
+  pcl::PointXYZRGB nan_point;
+  nan_point.x = nan_point.y = nan_point.z = std::numeric_limits<float>::quiet_NaN();
+  if (organized_cloud) {
+    organized_cloud->points.resize(static_cast<size_t>(pc2.width) * pc2.height);
+  }
+  pcl::PointXYZRGB * organized_point = organized_cloud ? organized_cloud->points.data() : nullptr;
+  for (uint32_t row = 0; row < pc2.height; row++) {
+    const uint8_t * point_data = pc2.data.data() + static_cast<size_t>(row) * pc2.row_step;
+    for (uint32_t col = 0; col < pc2.width; col++, point_data += pc2.point_step) {
+      float x, y, z;
+      std::memcpy(&x, point_data + x_offset, sizeof(float));
+      std::memcpy(&y, point_data + y_offset, sizeof(float));
+      std::memcpy(&z, point_data + z_offset, sizeof(float));
+      // NaN values fail every comparison and are dropped here as well
+      if (!(z >= ptFilter_Llimit_z && z <= ptFilter_Ulimit_z &&
+        y >= ptFilter_Llimit_y && y <= ptFilter_Ulimit_y &&
+        x >= ptFilter_Llimit_x && x <= ptFilter_Ulimit_x))
+      {
+        if (organized_point) {
+          *organized_point++ = nan_point;
+        }
+        continue;
+      }
+      pcl::PointXYZRGB point;
+      point.x = x;
+      point.y = y;
+      point.z = z;
+      if (rgb_offset >= 0) {
+        std::memcpy(&point.rgba, point_data + rgb_offset, sizeof(uint32_t));
+      }
+      cloud->points.push_back(point);
+      if (organized_point) {
+        *organized_point++ = point;
+      }
+    }
+  }
+  if (organized_cloud) {
+    organized_cloud->header.frame_id = pc2.header.frame_id;
+    organized_cloud->header.stamp = pc2.header.stamp.nanosec / 1000ull;
+    organized_cloud->width = pc2.width;
+    organized_cloud->height = pc2.height;
+    organized_cloud->is_dense = false;
   }
+  cloud->header.frame_id = pc2.header.frame_id;
+  cloud->header.stamp = pc2.header.stamp.nanosec / 1000ull;
+  cloud->width = static_cast<uint32_t>(cloud->points.size());
+  cloud->height = 1;
+  cloud->is_dense = true;
+  return true;
 }
 
 bool PCLFunctions::planeSegmentation(
@@ -87,7 +660,30 @@ bool PCLFunctions::planeSegmentation(
   const int & segmentation_max_iterations,
   const float & segmentation_distance_threshold)
 {
-  pcl::ModelCoefficients::Ptr coefficients(new pcl::ModelCoefficients);
+  pcl::ModelCoefficients coefficients;
+  return planeSegmentation(
+    cloud, cloud_plane_removed, cloud_table, coefficients,
+    segmentation_max_iterations, segmentation_distance_threshold);
+}
+
+/***************************************************************************************//**
+ * Function that splits a cloud into the points on the largest plane and the rest, and
+ * outputs the coefficients of the plane.
+ * @param cloud Input cloud
+ * @param cloud_plane_removed Points not on the plane
+ * @param cloud_table Points on the plane
+ * @param coefficients Output plane coefficients
+ * @param segmentation_max_iterations Maximum RANSAC iterations
+ * @param segmentation_distance_threshold Maximum distance of an inlier to the plane
+ *******************************************************************************************/
+bool PCLFunctions::planeSegmentation(
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table,
+  pcl::ModelCoefficients & coefficients,
+  const int & segmentation_max_iterations,
+  const float & segmentation_distance_threshold)
+{
   pcl::PointIndices::Ptr inliers(new pcl::PointIndices);
 
   // Create the segmentation object
@@ -100,7 +696,7 @@ bool PCLFunctions::planeSegmentation(
   seg.setMaxIterations(segmentation_max_iterations);
   seg.setDistanceThreshold(segmentation_distance_threshold);
   seg.setInputCloud(cloud);
-  seg.segment(*inliers, *coefficients);    // used to be table coeff
+  seg.segment(*inliers, coefficients);    // used to be table coeff
 
   if (inliers->indices.size() == 0) {
     PCL_ERROR("Could not estimate a planar model for the given dataset.");
@@ -149,11 +745,37 @@ void PCLFunctions::getClosestPointsByRadius(
 {
   pcl::search::KdTree<pcl::PointNormal>::Ptr treeSearch(
     new pcl::search::KdTree<pcl::PointNormal>());
+  treeSearch->setInputCloud(inputNormalCloud);
+  getClosestPointsByRadius(
+    point, radius, inputCloud, inputNormalCloud, treeSearch, outputCloud, outputNormalCloud);
+}
+
+/***************************************************************************************//**
+ * Function that extracts the points of a cloud and its normal cloud within a radius
+ * of a point, using an existing search tree built on the normal cloud.
+ * @param point Query point
+ * @param radius Search radius
+ * @param inputCloud Input cloud
+ * @param inputNormalCloud Normal cloud of the input cloud
+ * @param normalCloudSearch Search tree built on inputNormalCloud
+ * @param outputCloud Points of inputCloud within the radius
+ * @param outputNormalCloud Points of inputNormalCloud within the radius
+ *******************************************************************************************/
+void PCLFunctions::getClosestPointsByRadius(
+  const pcl::PointNormal & point,
+  const float & radius,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr & inputCloud,
+  pcl::PointCloud<pcl::PointNormal>::Ptr & inputNormalCloud,
+  const pcl::search::KdTree<pcl::PointNormal>::Ptr & normalCloudSearch,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr & outputCloud,
+  pcl::PointCloud<pcl::PointNormal>::Ptr & outputNormalCloud)
+{
   pcl::PointIndices::Ptr pointsIndex(new pcl::PointIndices);
   std::vector<float> pointsSquaredDistance;
-  treeSearch->setInputCloud(inputNormalCloud);
 
-  if (treeSearch->radiusSearch(point, radius, pointsIndex->indices, pointsSquaredDistance)) {
+  if (normalCloudSearch->radiusSearch(
+      point, radius, pointsIndex->indices, pointsSquaredDistance))
+  {
     extractInliersCloud<pcl::PointCloud<pcl::PointXYZRGB>::Ptr,
       pcl::ExtractIndices<pcl::PointXYZRGB>>(
       inputCloud,
@@ -172,18 +794,71 @@ void PCLFunctions::computeCloudNormal(
 {
   pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(
     new pcl::search::KdTree<pcl::PointXYZRGB>());
-  pcl::NormalEstimationOMP<pcl::PointXYZRGB, pcl::PointNormal> normal_estimation;
-  normal_estimation.setNumberOfThreads(4);
-  normal_estimation.setInputCloud(cloud);
-  normal_estimation.setSearchMethod(tree);
-  normal_estimation.setRadiusSearch(cloud_normal_radius);
-  normal_estimation.compute(*cloud_normal);
+  tree->setInputCloud(cloud);
+  computeCloudNormal(
+    cloud, cloud_normal, cloud_normal_radius, tree, std::thread::hardware_concurrency());
+}
 
-  for (size_t i = 0; i < cloud_normal->points.size(); ++i) {
-    cloud_normal->points[i].x = cloud->points[i].x;
-    cloud_normal->points[i].y = cloud->points[i].y;
-    cloud_normal->points[i].z = cloud->points[i].z;
+/***************************************************************************************//**
+ * Function that estimates the normals of a cloud, writing positions and normals to the
+ * normal cloud in one pass. The given search tree is used, such as the shared tree of a
+ * GraspObject, so that the tree can be reused by later queries.
+ * @param cloud Input cloud
+ * @param cloud_normal Output normal cloud
+ * @param cloud_normal_radius Neighbour search radius
+ * @param search Search tree built on the input cloud
+ * @param num_threads Maximum number of threads to use
+ *******************************************************************************************/
+void PCLFunctions::computeCloudNormal(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud_normal,
+  const float & cloud_normal_radius,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & search,
+  const int & num_threads)
+{
+  estimateNormals(*cloud, *search, nullptr, cloud_normal_radius, num_threads, *cloud_normal);
+}
+
+/***************************************************************************************//**
+ * Function that estimates the normals of one cluster of a cloud, reusing the search tree
+ * that was built on the whole cloud for clustering. Only neighbours inside the cluster are
+ * used, so the normals are the same as those computed on the cluster cloud alone.
+ * @param cloud Cloud the cluster was extracted from
+ * @param search Search tree built on cloud
+ * @param cluster Indices of the cluster points in cloud
+ * @param cloud_normal Output normal cloud, in the order of the cluster indices
+ * @param cloud_normal_radius Neighbour search radius
+ * @param num_threads Maximum number of threads to use
+ *******************************************************************************************/
+void PCLFunctions::computeClusterNormal(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & search,
+  const pcl::PointIndices & cluster,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud_normal,
+  const float & cloud_normal_radius,
+  const int & num_threads)
+{
+  if (std::is_sorted(cluster.indices.begin(), cluster.indices.end())) {
+    estimateNormals(
+      *cloud, *search, &cluster.indices, cloud_normal_radius, num_threads, *cloud_normal);
+    return;
+  }
+  // Membership of neighbours is checked by binary search, so sort a copy of the indices
+  std::vector<int> sorted_indices(cluster.indices);
+  std::sort(sorted_indices.begin(), sorted_indices.end());
+  pcl::PointCloud<pcl::PointNormal> sorted_normal;
+  estimateNormals(
+    *cloud, *search, &sorted_indices, cloud_normal_radius, num_threads, sorted_normal);
+  cloud_normal->points.resize(cluster.indices.size());
+  for (size_t i = 0; i < cluster.indices.size(); i++) {
+    size_t sorted_position = std::lower_bound(
+      sorted_indices.begin(), sorted_indices.end(), cluster.indices[i]) - sorted_indices.begin();
+    cloud_normal->points[i] = sorted_normal.points[sorted_position];
   }
+  cloud_normal->header = sorted_normal.header;
+  cloud_normal->width = sorted_normal.width;
+  cloud_normal->height = 1;
+  cloud_normal->is_dense = false;
 }
 
 Eigen::Vector3f PCLFunctions::convertPCLNormaltoEigen(
@@ -198,10 +873,27 @@ std::vector<pcl::PointIndices> PCLFunctions::extractPointCloudClusters(
   int min_cluster_size)
 {
   pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>);
+  tree->setInputCloud(cloud);
+  return extractPointCloudClusters(cloud, cluster_tolerance, min_cluster_size, tree);
+}
+
+/***************************************************************************************//**
+ * Function that extracts euclidean clusters using a search tree built by the caller, so
+ * that the tree can be reused after clustering.
+ * @param cloud Input cloud
+ * @param cluster_tolerance Maximum distance between neighbouring points of a cluster
+ * @param min_cluster_size Minimum number of points in a cluster
+ * @param tree Search tree built on cloud
+ *******************************************************************************************/
+std::vector<pcl::PointIndices> PCLFunctions::extractPointCloudClusters(
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
+  float cluster_tolerance,
+  int min_cluster_size,
+  const pcl::search::KdTree<pcl::PointXYZRGB>::Ptr & tree)
+{
   std::vector<pcl::PointIndices> clusterIndices;
   pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> ecExtractor;
 
-  tree->setInputCloud(cloud);
   ecExtractor.setClusterTolerance(cluster_tolerance);
   ecExtractor.setMinClusterSize(min_cluster_size);
   ecExtractor.setSearchMethod(tree);
@@ -210,6 +902,166 @@ std::vector<pcl::PointIndices> PCLFunctions::extractPointCloudClusters(
   return clusterIndices;
 }
 
+namespace
+{
+/*! \brief Root of a union-find element, halving the path on the way */
+int findRoot(std::vector<int> & parent, int element)
+{
+  while (parent[element] != element) {
+    parent[element] = parent[parent[element]];
+    element = parent[element];
+  }
+  return element;
+}
+
+/*! \brief Merge the sets of two union-find elements, the smaller root becomes the root */
+void uniteRoots(std::vector<int> & parent, int first, int second)
+{
+  first = findRoot(parent, first);
+  second = findRoot(parent, second);
+  if (first < second) {
+    parent[second] = first;
+  } else if (second < first) {
+    parent[first] = second;
+  }
+}
+}  // namespace
+
+/***************************************************************************************//**
+ * Function that extracts clusters from an organized cloud in image space. Pixels that are
+ * invalid, outside the crop limits or on the support plane are skipped, and the remaining
+ * pixels are joined to their right and lower neighbours with a union-find if the points
+ * are within the cluster tolerance. If max_normal_angle is positive, neighbours are also
+ * only joined if the surface normals estimated from their pixel neighbourhoods are within
+ * that angle. Clusters are returned largest first, with indices into the organized cloud,
+ * like pcl::EuclideanClusterExtraction.
+ * @param cloud Organized input cloud
+ * @param plane_coefficients Support plane ax + by + cz + d = 0, or empty for no plane
+ * @param plane_distance_threshold Maximum distance of a point on the support plane
+ * @param ptFilter_Ulimit_x Upper crop limit in x, and so on for the other limits
+ * @param cluster_tolerance Maximum distance between neighbouring points of a cluster
+ * @param min_cluster_size Minimum number of points in a cluster
+ * @param max_normal_angle Maximum angle between neighbouring normals in radians, 0 to disable
+ *******************************************************************************************/
+std::vector<pcl::PointIndices> PCLFunctions::extractOrganizedClusters(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const std::vector<float> & plane_coefficients,
+  const float & plane_distance_threshold,
+  const float & ptFilter_Ulimit_x,
+  const float & ptFilter_Llimit_x,
+  const float & ptFilter_Ulimit_y,
+  const float & ptFilter_Llimit_y,
+  const float & ptFilter_Ulimit_z,
+  const float & ptFilter_Llimit_z,
+  const float & cluster_tolerance,
+  const int & min_cluster_size,
+  const float & max_normal_angle)
+{
+  std::vector<pcl::PointIndices> clusters;
+  if (!cloud->isOrganized()) {
+    return clusters;
+  }
+  const int width = static_cast<int>(cloud->width);
+  const int height = static_cast<int>(cloud->height);
+  const int num_pixels = width * height;
+  const bool use_plane = plane_coefficients.size() == 4;
+  const float sq_tolerance = cluster_tolerance * cluster_tolerance;
+
+  // Pixels that can be part of an object
+  std::vector<uint8_t> valid(num_pixels, 0);
+  for (int i = 0; i < num_pixels; i++) {
+    const pcl::PointXYZRGB & point = cloud->points[i];
+    bool inside = std::isfinite(point.x) && std::isfinite(point.y) && std::isfinite(point.z) &&
+      point.x >= ptFilter_Llimit_x && point.x <= ptFilter_Ulimit_x &&
+      point.y >= ptFilter_Llimit_y && point.y <= ptFilter_Ulimit_y &&
+      point.z >= ptFilter_Llimit_z && point.z <= ptFilter_Ulimit_z;
+    if (inside && use_plane) {
+      inside = std::abs(
+        plane_coefficients[0] * point.x + plane_coefficients[1] * point.y +
+        plane_coefficients[2] * point.z + plane_coefficients[3]) > plane_distance_threshold;
+    }
+    valid[i] = inside;
+  }
+
+  // Normals from the right and lower neighbours, zero where they cannot be estimated
+  std::vector<Eigen::Vector3f, Eigen::aligned_allocator<Eigen::Vector3f>> normals;
+  const float min_normal_cos = std::cos(max_normal_angle);
+  if (max_normal_angle > 0) {
+    normals.assign(num_pixels, Eigen::Vector3f::Zero());
+    for (int row = 0; row + 1 < height; row++) {
+      for (int col = 0; col + 1 < width; col++) {
+        const int i = row * width + col;
+        if (valid[i] && valid[i + 1] && valid[i + width]) {
+          Eigen::Vector3f point = cloud->points[i].getVector3fMap();
+          Eigen::Vector3f normal = (cloud->points[i + 1].getVector3fMap() - point).cross(
+            cloud->points[i + width].getVector3fMap() - point);
+          if (normal.squaredNorm() > 0) {
+            normals[i] = normal.normalized();
+          }
+        }
+      }
+    }
+  }
+  auto joinable = [&](int first, int second) {
+      if (!valid[second] ||
+        (cloud->points[first].getVector3fMap() -
+        cloud->points[second].getVector3fMap()).squaredNorm() > sq_tolerance)
+      {
+        return false;
+      }
+      if (normals.empty() || normals[first].isZero() || normals[second].isZero()) {
+        return true;
+      }
+      return std::abs(normals[first].dot(normals[second])) >= min_normal_cos;
+    };
+
+  std::vector<int> parent(num_pixels);
+  for (int i = 0; i < num_pixels; i++) {
+    parent[i] = i;
+  }
+  for (int row = 0; row < height; row++) {
+    for (int col = 0; col < width; col++) {
+      const int i = row * width + col;
+      if (!valid[i]) {
+        continue;
+      }
+      if (col + 1 < width && joinable(i, i + 1)) {
+        uniteRoots(parent, i, i + 1);
+      }
+      if (row + 1 < height && joinable(i, i + width)) {
+        uniteRoots(parent, i, i + width);
+      }
+    }
+  }
+
+  // Gather the members of each root in pixel order
+  std::vector<int> component(num_pixels, -1);
+  std::vector<pcl::PointIndices> components;
+  for (int i = 0; i < num_pixels; i++) {
+    if (!valid[i]) {
+      continue;
+    }
+    int root = findRoot(parent, i);
+    if (component[root] < 0) {
+      component[root] = static_cast<int>(components.size());
+      components.emplace_back();
+    }
+    components[component[root]].indices.push_back(i);
+  }
+  for (auto & candidate : components) {
+    if (static_cast<int>(candidate.indices.size()) >= min_cluster_size) {
+      candidate.header = cloud->header;
+      clusters.push_back(std::move(candidate));
+    }
+  }
+  std::stable_sort(
+    clusters.begin(), clusters.end(),
+    [](const pcl::PointIndices & a, const pcl::PointIndices & b) {
+      return a.indices.size() > b.indices.size();
+    });
+  return clusters;
+}
+
 // float PCLFunctions::pointToPlane(Eigen::Vector4f & plane, pcl::PointXYZRGB const & point)
 // {
 //   return std::abs(plane(0) * point.x + plane(1) * point.y + plane(2) * point.z + plane(3)) /
@@ -227,3 +1079,75 @@ std::vector<pcl::PointIndices> PCLFunctions::extractPointCloudClusters(
 //   return std::abs(plane(0) * point.x + plane(1) * point.y + plane(2) * point.z + plane(3)) /
 //          std::sqrt(std::pow(plane(0), 2) + std::pow(plane(1), 2) + std::pow(plane(2), 2));
 // }
+
+/***************************************************************************************//**
+ * Function that selects the points of a cloud within a distance of each of a set of planes,
+ * with the same inliers as SampleConsensusModelPlane::selectWithinDistance. Planes sharing
+ * the normal of the first plane are handled together: every point is projected onto the
+ * normal once, and only the planes whose offset is near the projection are tested. Other
+ * planes are tested against every point. Returns the ascending inlier indexes of each plane.
+ * @param cloud Input cloud
+ * @param planes Coefficients of the planes
+ * @param threshold Distance threshold, in units of the plane coefficients
+ *******************************************************************************************/
+std::vector<std::vector<int>> PCLFunctions::selectWithinDistanceOfPlanes(
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & cloud,
+  const std::vector<Eigen::Vector4f> & planes,
+  const float & threshold)
+{
+  std::vector<std::vector<int>> plane_indices(planes.size());
+  if (planes.empty()) {
+    return plane_indices;
+  }
+  // Same distance as the plane model, which takes its coefficients as a dynamic vector
+  std::vector<Eigen::VectorXf> coefficients(planes.size());
+  for (size_t k = 0; k < planes.size(); k++) {
+    coefficients[k] = planes[k];
+  }
+  auto isInlier = [&](const size_t & plane, const pcl::PointNormal & point) -> bool
+    {
+      const Eigen::Vector4f point_vector(point.x, point.y, point.z, 1);
+      return std::abs(coefficients[plane].dot(point_vector)) < threshold;
+    };
+
+  // Planes sharing a normal, sorted by the projection of the points on them onto the normal
+  const Eigen::Vector3f normal = planes[0].head<3>();
+  std::vector<std::pair<float, size_t>> plane_offsets;
+  std::vector<size_t> other_planes;
+  float max_offset = 0;
+  for (size_t k = 0; k < planes.size(); k++) {
+    if (planes[k].head<3>() == normal) {
+      plane_offsets.emplace_back(-planes[k](3), k);
+      max_offset = std::max(max_offset, std::abs(planes[k](3)));
+    } else {
+      other_planes.push_back(k);
+    }
+  }
+  std::sort(plane_offsets.begin(), plane_offsets.end());
+  const Eigen::Vector3f abs_normal = normal.cwiseAbs();
+
+  for (size_t i = 0; i < cloud->points.size(); i++) {
+    const pcl::PointNormal & point = cloud->points[i];
+    const Eigen::Vector3f position(point.x, point.y, point.z);
+    const float projection = normal.dot(position);
+    if (std::isfinite(projection)) {
+      // Bound on the rounding difference between the projection and the distances of the model
+      const float margin = 16 * std::numeric_limits<float>::epsilon() *
+        (abs_normal.dot(position.cwiseAbs()) + max_offset);
+      auto it = std::lower_bound(
+        plane_offsets.begin(), plane_offsets.end(),
+        std::make_pair(projection - threshold - margin, size_t(0)));
+      for (; it != plane_offsets.end() && it->first <= projection + threshold + margin; ++it) {
+        if (isInlier(it->second, point)) {
+          plane_indices[it->second].push_back(static_cast<int>(i));
+        }
+      }
+    }
+    for (const size_t & k : other_planes) {
+      if (isInlier(k, point)) {
+        plane_indices[k].push_back(static_cast<int>(i));
+      }
+    }
+  }
+  return plane_indices;
+}
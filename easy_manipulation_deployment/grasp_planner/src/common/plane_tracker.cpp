@@ -0,0 +1,208 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/plane_tracker.hpp"
+
+#include <pcl/common/angles.h>
+#include <pcl/filters/extract_indices.h>
+#include <pcl/sample_consensus/method_types.h>
+#include <pcl/sample_consensus/model_types.h>
+#include <pcl/sample_consensus/sac_model_plane.h>
+#include <pcl/segmentation/sac_segmentation.h>
+
+#include <algorithm>
+#include <cmath>
+
+using grasp_planner::PlaneTracker;
+
+namespace
+{
+/*! \brief Maximum angle between the previous plane and a plane fitted with it as prior */
+const float kPriorEpsAngle = pcl::deg2rad(10.0f);
+}  // namespace
+
+PlaneTracker::PlaneTracker()
+: plane{0, 0, 0, 0},
+  has_plane(false),
+  last_plane_tracked(false),
+  fitted_inlier_ratio(0),
+  validation_sample_size(500),
+  validation_min_inlier_ratio(0.8),
+  generator(0)
+{
+}
+
+void PlaneTracker::setValidation(const int & sample_size, const float & min_inlier_ratio)
+{
+  validation_sample_size = std::max(1, sample_size);
+  validation_min_inlier_ratio = min_inlier_ratio;
+}
+
+bool PlaneTracker::hasPlane() const
+{
+  return has_plane;
+}
+
+bool PlaneTracker::lastPlaneTracked() const
+{
+  return last_plane_tracked;
+}
+
+void PlaneTracker::reset()
+{
+  has_plane = false;
+  last_plane_tracked = false;
+  fitted_inlier_ratio = 0;
+}
+
+/***************************************************************************************//**
+ * Function that splits a cloud into the points on the support plane and the rest. If a plane
+ * is tracked, the share of inliers in a random subsample of the cloud is compared to the
+ * share of inliers when the plane was fitted. If it is close enough, the plane is kept and
+ * refined with a least squares fit to its inliers. Otherwise a plane is fitted with RANSAC,
+ * first restricted to planes parallel to the tracked plane, then unrestricted.
+ * @param cloud Input cloud
+ * @param cloud_plane_removed Points not on the plane
+ * @param cloud_table Points on the plane
+ * @param coefficients Output plane coefficients
+ * @param segmentation_max_iterations Maximum RANSAC iterations
+ * @param segmentation_distance_threshold Maximum distance of an inlier to the plane
+ * @return false if no plane could be found
+ *******************************************************************************************/
+bool PlaneTracker::segment(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table,
+  pcl::ModelCoefficients & coefficients,
+  const int & segmentation_max_iterations,
+  const float & segmentation_distance_threshold)
+{
+  pcl::PointIndices::Ptr inliers(new pcl::PointIndices);
+  last_plane_tracked = false;
+  if (cloud->points.empty()) {
+    return false;
+  }
+
+  auto distance_to_plane = [this](const pcl::PointXYZRGB & point) {
+      return std::abs(plane[0] * point.x + plane[1] * point.y + plane[2] * point.z + plane[3]);
+    };
+
+  if (has_plane) {
+    std::uniform_int_distribution<size_t> distribution(0, cloud->points.size() - 1);
+    int sample_inliers = 0;
+    for (int i = 0; i < validation_sample_size; i++) {
+      if (distance_to_plane(cloud->points[distribution(generator)]) <=
+        segmentation_distance_threshold)
+      {
+        sample_inliers++;
+      }
+    }
+    float sample_inlier_ratio = static_cast<float>(sample_inliers) / validation_sample_size;
+    if (sample_inlier_ratio >= validation_min_inlier_ratio * fitted_inlier_ratio) {
+      for (size_t i = 0; i < cloud->points.size(); i++) {
+        if (distance_to_plane(cloud->points[i]) <= segmentation_distance_threshold) {
+          inliers->indices.push_back(static_cast<int>(i));
+        }
+      }
+      last_plane_tracked = inliers->indices.size() >= 3;
+    }
+  }
+
+  if (last_plane_tracked) {
+    // Follow small drifts of the plane
+    pcl::SampleConsensusModelPlane<pcl::PointXYZRGB> model(cloud);
+    Eigen::VectorXf previous_plane(4);
+    previous_plane << plane[0], plane[1], plane[2], plane[3];
+    Eigen::VectorXf refined_plane;
+    model.optimizeModelCoefficients(inliers->indices, previous_plane, refined_plane);
+    if (refined_plane.size() == 4 && refined_plane.allFinite()) {
+      for (int i = 0; i < 4; i++) {
+        plane[i] = refined_plane[i];
+      }
+    }
+  } else {
+    inliers->indices.clear();
+    pcl::ModelCoefficients fitted_coefficients;
+    bool found = has_plane && fitPlane(
+      cloud, segmentation_max_iterations, segmentation_distance_threshold, true,
+      *inliers, fitted_coefficients);
+    if (!found) {
+      found = fitPlane(
+        cloud, segmentation_max_iterations, segmentation_distance_threshold, false,
+        *inliers, fitted_coefficients);
+    }
+    if (!found) {
+      PCL_ERROR("Could not estimate a planar model for the given dataset.");
+      reset();
+      return false;
+    }
+    float normal_norm = std::sqrt(
+      fitted_coefficients.values[0] * fitted_coefficients.values[0] +
+      fitted_coefficients.values[1] * fitted_coefficients.values[1] +
+      fitted_coefficients.values[2] * fitted_coefficients.values[2]);
+    for (int i = 0; i < 4; i++) {
+      plane[i] = fitted_coefficients.values[i] / normal_norm;
+    }
+    has_plane = true;
+    fitted_inlier_ratio = static_cast<float>(inliers->indices.size()) / cloud->points.size();
+  }
+  coefficients.header = cloud->header;
+  coefficients.values.assign(plane, plane + 4);
+
+  pcl::ExtractIndices<pcl::PointXYZRGB> indExtractor;
+  indExtractor.setInputCloud(cloud);
+  indExtractor.setIndices(inliers);
+  indExtractor.setNegative(false);
+  indExtractor.filter(*cloud_table);
+  indExtractor.setNegative(true);
+  indExtractor.filter(*cloud_plane_removed);
+  return true;
+}
+
+/***************************************************************************************//**
+ * Function that fits a plane to a cloud with RANSAC. With use_prior, only planes within
+ * a small angle of being parallel to the tracked plane are considered.
+ * @param cloud Input cloud
+ * @param segmentation_max_iterations Maximum RANSAC iterations
+ * @param segmentation_distance_threshold Maximum distance of an inlier to the plane
+ * @param use_prior Whether to restrict the orientation to that of the tracked plane
+ * @param inliers Output inliers
+ * @param coefficients Output plane coefficients
+ * @return false if no plane was found
+ *******************************************************************************************/
+bool PlaneTracker::fitPlane(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const int & segmentation_max_iterations,
+  const float & segmentation_distance_threshold,
+  const bool & use_prior,
+  pcl::PointIndices & inliers,
+  pcl::ModelCoefficients & coefficients)
+{
+  pcl::SACSegmentation<pcl::PointXYZRGB> seg;
+  seg.setOptimizeCoefficients(true);
+  if (use_prior) {
+    seg.setModelType(pcl::SACMODEL_PERPENDICULAR_PLANE);
+    seg.setAxis(Eigen::Vector3f(plane[0], plane[1], plane[2]));
+    seg.setEpsAngle(kPriorEpsAngle);
+  } else {
+    seg.setModelType(pcl::SACMODEL_PLANE);
+  }
+  seg.setMethodType(pcl::SAC_RANSAC);
+  seg.setMaxIterations(segmentation_max_iterations);
+  seg.setDistanceThreshold(segmentation_distance_threshold);
+  seg.setInputCloud(cloud);
+  seg.segment(inliers, coefficients);
+  return !inliers.indices.empty() && coefficients.values.size() == 4;
+}
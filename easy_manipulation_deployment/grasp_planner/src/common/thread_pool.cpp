@@ -0,0 +1,190 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/thread_pool.hpp"
+
+#include <utility>
+
+using grasp_planner::ThreadPool;
+
+namespace
+{
+/*! \brief Guards the process wide pool */
+std::mutex global_mutex;
+/*! \brief Process wide pool, created on first use */
+std::shared_ptr<ThreadPool> global_pool;
+/*! \brief Thread count the process wide pool is created with */
+int global_threads = 0;
+
+/*! \brief Thread count with 0 resolved to the hardware concurrency */
+std::size_t resolveThreads(const int & num_threads)
+{
+  if (num_threads > 0) {
+    return static_cast<std::size_t>(num_threads);
+  }
+  unsigned int hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 0 ? hardware_threads : 1;
+}
+}  // namespace
+
+/***************************************************************************//**
+ * ThreadPool constructor that starts all but one of the threads, the calling
+ * thread of each loop being the last one.
+ * @param num_threads Number of threads, 0 for one per hardware thread
+ ******************************************************************************/
+ThreadPool::ThreadPool(const int & num_threads)
+: stop(false)
+{
+  const std::size_t total_threads = resolveThreads(num_threads);
+  for (std::size_t i = 1; i < total_threads; i++) {
+    this->workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stop = true;
+  }
+  this->work_available.notify_all();
+  for (auto & worker : this->workers) {
+    worker.join();
+  }
+}
+
+std::size_t ThreadPool::size() const
+{
+  return this->workers.size() + 1;
+}
+
+/***************************************************************************//**
+ * Method that runs a loop on the pool. Iterations are claimed one at a time by
+ * the workers and the calling thread, so the caller never waits on an iteration
+ * that nobody is running.
+ * @param begin First iteration
+ * @param end One past the last iteration
+ * @param task Loop body, called with the iteration index
+ ******************************************************************************/
+void ThreadPool::parallelFor(
+  const std::size_t & begin, const std::size_t & end,
+  const std::function<void(std::size_t)> & task)
+{
+  if (begin >= end) {
+    return;
+  }
+  if (this->workers.empty() || end - begin == 1) {
+    for (std::size_t i = begin; i < end; i++) {
+      task(i);
+    }
+    return;
+  }
+
+  auto loop = std::make_shared<Loop>();
+  loop->task = &task;
+  loop->next = begin;
+  loop->end = end;
+  loop->remaining = end - begin;
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->loops.push_back(loop);
+  }
+  this->work_available.notify_all();
+
+  while (runIteration(*loop)) {
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (auto it = this->loops.begin(); it != this->loops.end(); ++it) {
+      if (*it == loop) {
+        this->loops.erase(it);
+        break;
+      }
+    }
+  }
+  std::unique_lock<std::mutex> lock(loop->mutex);
+  loop->finished.wait(lock, [&loop] {return loop->remaining == 0;});
+  if (loop->error) {
+    std::rethrow_exception(loop->error);
+  }
+}
+
+bool ThreadPool::runIteration(Loop & loop)
+{
+  const std::size_t i = loop.next.fetch_add(1);
+  if (i >= loop.end) {
+    return false;
+  }
+  try {
+    (*loop.task)(i);
+  } catch (...) {
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    if (!loop.error) {
+      loop.error = std::current_exception();
+    }
+  }
+  if (loop.remaining.fetch_sub(1) == 1) {
+    std::lock_guard<std::mutex> lock(loop.mutex);
+    loop.finished.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::workerLoop()
+{
+  while (true) {
+    std::shared_ptr<Loop> loop;
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->work_available.wait(lock, [this] {return this->stop || !this->loops.empty();});
+      if (this->stop) {
+        return;
+      }
+      // Newest loops first, so nested loops finish before their parents take more work
+      loop = this->loops.back();
+    }
+    if (!runIteration(*loop)) {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      if (!this->loops.empty() && this->loops.back() == loop) {
+        this->loops.pop_back();
+      }
+    }
+  }
+}
+
+std::shared_ptr<ThreadPool> ThreadPool::global()
+{
+  std::lock_guard<std::mutex> lock(global_mutex);
+  if (!global_pool) {
+    global_pool = std::make_shared<ThreadPool>(global_threads);
+  }
+  return global_pool;
+}
+
+void ThreadPool::setGlobalThreads(const int & num_threads)
+{
+  std::shared_ptr<ThreadPool> previous;
+  {
+    std::lock_guard<std::mutex> lock(global_mutex);
+    if (global_pool && global_pool->size() == resolveThreads(num_threads)) {
+      global_threads = num_threads;
+      return;
+    }
+    global_threads = num_threads;
+    previous = std::move(global_pool);
+  }
+  // Joined here unless a running loop still holds it
+  previous.reset();
+}
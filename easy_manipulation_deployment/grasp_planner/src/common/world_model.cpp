@@ -0,0 +1,178 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "emd/common/world_model.hpp"
+#include "emd/common/fcl_functions.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace grasp_planner::collision;
+
+namespace
+{
+// Same octree settings as FCLFunctions::createCollisionObjectFromPointCloudRGB
+const double prob_hit = 0.9;
+const double prob_miss = 0.1;
+const double clamping_thres_min = 0.12;
+const double clamping_thres_max = 0.98;
+}  // namespace
+
+WorldModel::WorldModel(const float & resolution)
+: octree(std::make_shared<octomap::OcTree>(resolution)),
+  initialized(false),
+  use_update_region(false),
+  decay(0)
+{
+  octree->setProbHit(prob_hit);
+  octree->setProbMiss(prob_miss);
+  octree->setClampingThresMin(clamping_thres_min);
+  octree->setClampingThresMax(clamping_thres_max);
+  octree->enableChangeDetection(true);
+
+  // Number of misses needed to clear a cell that is saturated as occupied
+  rays_per_surface = static_cast<unsigned int>(
+    std::floor(
+      (octree->getClampingThresMaxLog() - octree->getOccupancyThresLog()) /
+      -octree->getProbMissLog())) + 1;
+
+  // The FCL octree keeps a pointer to octree, so updates to octree are seen by collision checks
+  fcl_octree = std::make_shared<OcTree>(octree);
+  std::shared_ptr<CollisionGeometry> fcl_geometry = fcl_octree;
+  collision_object = std::make_shared<CollisionObject>(fcl_geometry);
+}
+
+void WorldModel::setUpdateRegion(
+  const octomap::point3d & region_min,
+  const octomap::point3d & region_max)
+{
+  use_update_region = true;
+  update_region_min = region_min;
+  update_region_max = region_max;
+}
+
+void WorldModel::setDecay(const float & decay_)
+{
+  decay = std::max(0.0f, decay_);
+}
+
+void WorldModel::reset()
+{
+  octree->clear();
+  octree->resetChangeDetection();
+  changed_keys.clear();
+  observation_counts.clear();
+  initialized = false;
+  fcl_octree->computeLocalAABB();
+  collision_object->computeAABB();
+}
+
+float WorldModel::getResolution() const
+{
+  return static_cast<float>(octree->getResolution());
+}
+
+std::shared_ptr<CollisionObject> WorldModel::getCollisionObject() const
+{
+  return collision_object;
+}
+
+/***************************************************************************************//**
+ * Function that integrates a point cloud into the map. Only cells inside the update region
+ * are touched. Once a surface cell has been observed in enough consecutive updates for its ray
+ * to clear anything previously in front of it, its ray is no longer cast. Anything appearing
+ * in front of it would hide it and reset its count, so the cost of an update follows how much
+ * of the scene changed. Occupied cells inside the update region that were not observed are
+ * decayed if a decay is set. The map is reset if the sensor has moved.
+ * @param cloud Point cloud in the map frame
+ * @param sensor_origin Origin of the sensor in the map frame
+ * @param num_threads Number of threads used to compute the updated cells
+ * @return Number of cells whose occupancy changed
+ *******************************************************************************************/
+size_t WorldModel::integratePointCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const octomap::point3d & sensor_origin,
+  const unsigned int & num_threads)
+{
+  if (initialized && (sensor_origin - last_sensor_origin).norm() > octree->getResolution()) {
+    reset();
+  }
+  const bool first_update = !initialized;
+  initialized = true;
+  last_sensor_origin = sensor_origin;
+  octree->resetChangeDetection();
+
+  FCLFunctions::UpdateRegion region;
+  region.enabled = use_update_region;
+  region.min = update_region_min;
+  region.max = update_region_max;
+
+  // Free space in front of a continuously observed surface is already integrated
+  FCLFunctions::IntegrationKeys keys;
+  FCLFunctions::computeIntegrationKeys(
+    *octree, *cloud, sensor_origin, num_threads, keys, region,
+    [this](const octomap::OcTreeKey & key) {
+      auto observed = observation_counts.find(key);
+      return observed != observation_counts.end() && observed->second >= rays_per_surface;
+    });
+
+  if (decay > 0) {
+    octomap::KeySet occupied_cells(keys.occupied_cells.begin(), keys.occupied_cells.end());
+    std::vector<octomap::OcTreeKey> decayed_cells;
+    auto decay_leaf = [&](const auto & it) {
+        if (octree->isNodeOccupied(*it) &&
+          occupied_cells.find(it.getKey()) == occupied_cells.end())
+        {
+          decayed_cells.push_back(it.getKey());
+        }
+      };
+    if (use_update_region) {
+      for (auto it = octree->begin_leafs_bbx(update_region_min, update_region_max),
+        end = octree->end_leafs_bbx(); it != end; ++it)
+      {
+        decay_leaf(it);
+      }
+    } else {
+      for (auto it = octree->begin_leafs(), end = octree->end_leafs(); it != end; ++it) {
+        decay_leaf(it);
+      }
+    }
+    for (const auto & key : decayed_cells) {
+      octree->updateNode(key, -decay, true);
+    }
+  }
+
+  FCLFunctions::applyIntegrationKeys(*octree, keys);
+
+  std::unordered_map<octomap::OcTreeKey, unsigned int, octomap::OcTreeKey::KeyHash> counts;
+  for (const auto & key : keys.occupied_cells) {
+    auto observed = observation_counts.find(key);
+    counts[key] = (observed == observation_counts.end()) ?
+      1 : std::min(observed->second + 1, rays_per_surface);
+  }
+  observation_counts.swap(counts);
+
+  changed_keys.clear();
+  for (auto it = octree->changedKeysBegin(); it != octree->changedKeysEnd(); ++it) {
+    changed_keys.push_back(it->first);
+  }
+
+  // Bounds of the collision object only need refreshing if the map changed
+  if (first_update || !changed_keys.empty()) {
+    fcl_octree->computeLocalAABB();
+    collision_object->computeAABB();
+  }
+  return changed_keys.size();
+}
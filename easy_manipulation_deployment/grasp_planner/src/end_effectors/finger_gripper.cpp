@@ -41,6 +41,12 @@ static const rclcpp::Logger & LOGGER = rclcpp::get_logger("FingerGripper");
  * @param grasp_stroke_direction_ Axis in the same direction as the gripper stroke
  * @param grasp_stroke_normal_direction_ Axis normal to the direction of the gripper stroke
  * @param grasp_approach_direction_ Axis in which the gripper approaches the object
+ * @param grasp_clearance_weight_ weight of the clearance of the open fingers in grasp ranking
+ * @param friction_cone_angle_ Largest angle between a finger's surface normal and the grasp
+ * direction, pi/2 accepts any angle
+ * @param coarse_voxel_size_ Voxel size of the coarse level of a coarse to fine search, 0 plans
+ * on the full object cloud only
+ * @param coarse_candidates_ Number of best coarse grasps the fine level searches around
  ******************************************************************************/
 
 FingerGripper::FingerGripper(
@@ -61,7 +67,11 @@ FingerGripper::FingerGripper(
   const float & worldZAngleThreshold_,
   std::string grasp_stroke_direction_,
   std::string grasp_stroke_normal_direction_,
-  std::string grasp_approach_direction_)
+  std::string grasp_approach_direction_,
+  const float & grasp_clearance_weight_,
+  const float & friction_cone_angle_,
+  const float & coarse_voxel_size_,
+  const int & coarse_candidates_)
 : id(id_),
   num_fingers_side_1(num_fingers_side_1_),
   num_fingers_side_2(num_fingers_side_2_),
@@ -79,7 +89,11 @@ FingerGripper::FingerGripper(
   worldZAngleThreshold(worldZAngleThreshold_),
   grasp_stroke_direction(grasp_stroke_direction_[0]),
   grasp_stroke_normal_direction(grasp_stroke_normal_direction_[0]),
-  grasp_approach_direction(grasp_approach_direction_[0])
+  grasp_approach_direction(grasp_approach_direction_[0]),
+  grasp_clearance_weight(grasp_clearance_weight_),
+  friction_cone_angle(friction_cone_angle_),
+  coarse_voxel_size(coarse_voxel_size_),
+  coarse_candidates(coarse_candidates_)
 {
   if (num_fingers_side_1_ <= 0 || num_fingers_side_2_ <= 0) {
     RCLCPP_ERROR(LOGGER, "Each side needs to have a minimum of 1 finger");
@@ -135,6 +149,14 @@ FingerGripper::FingerGripper(
     RCLCPP_ERROR(LOGGER, "Gripper stroke needs larger than finger_thickness");
     throw std::invalid_argument("Invalid value for field.");
   }
+  if (friction_cone_angle < 0) {
+    RCLCPP_ERROR(LOGGER, "Friction cone angle needs to be positive");
+    throw std::invalid_argument("Invalid value for field.");
+  }
+  if (coarse_voxel_size > 0 && coarse_candidates <= 0) {
+    RCLCPP_ERROR(LOGGER, "Coarse to fine search needs at least 1 coarse candidate");
+    throw std::invalid_argument("Invalid value for field.");
+  }
   this->num_fingers_total = this->num_fingers_side_1 + this->num_fingers_side_2;
 
   generateGripperAttributes();
@@ -163,59 +185,91 @@ void FingerGripper::generateGripperAttributes()
 }
 
 /***************************************************************************//**
- * Inherited method that visualizes the required grasps
+ * Method that plans the grasps of an object, keeping all intermediate samples in
+ * a context owned by the caller. Neither the gripper nor the object is modified, so several
+ * requests can be planned concurrently with the same gripper and object, each with its own
+ * context.
+ * Returns the valid grasps sorted by decreasing rank, which are also kept in the context.
+ * Planning is abandoned with no grasps when the deadline of the context passes, unless the
+ * context is set up for an anytime search, which ranks the grasps found until then.
+ * With a coarse voxel size, the finger samples are only taken around the best grasps planned
+ * on a coarse object cloud.
  *
+ * @param context Planning context of this request, expected to be empty
  * @param object Grasp Object
  * @param grasp_method Grasp method output for all possible grasps
  * @param world_collision_object FCL collision object of the world
+ * @param camera_frame Frame of the grasp markers
  ******************************************************************************/
-
-std::vector<std::shared_ptr<multiFingerGripper>>& FingerGripper::planGraspsWithFingerResult(
+std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::planGraspsWithFingerResult(
+  FingerPlanningContext & context,
   std::shared_ptr<GraspObject> object,
   emd_msgs::msg::GraspMethod * grasp_method,
   std::shared_ptr<CollisionObject> world_collision_object,
-  std::string camera_frame)
+  std::string camera_frame) const
 {
-  getCenterCuttingPlane(object);
-  getCuttingPlanes(object);
+  // Search trees over the finger clouds of a previous plan in the context are not reused
+  context.sample_cloud_indices.clear();
+  getCenterCuttingPlane(context, object);
+  getCuttingPlanes(context, object);
+
+  // The whole object is searched if the coarse level of a coarse to fine search found no grasp
+  if (this->coarse_voxel_size <= 0 ||
+    !getRefinedSampleCloud(context, object, world_collision_object))
+  {
+    if (!getGraspCloud(context, object)) {
+      RCLCPP_ERROR(
+        LOGGER,
+        "Grasping Planes do not intersect with object. Off center grasp is needed. Please change gripper");
+      return context.sorted_gripper_configs;
+    }
 
-  std::vector<std::shared_ptr<multiFingerGripper>> empty_result;
-  if (!this->getGraspCloud(object)) {
-    RCLCPP_ERROR(
-      LOGGER,
-      "Grasping Planes do not intersect with object. Off center grasp is needed. Please change gripper");
-    this->resetVariables();
-    
-    return empty_result;
-  }
+    if (!getInitialSamplePoints(context, object) || context.expired()) {
+      return context.sorted_gripper_configs;
+    }
 
-  if (!this->getInitialSamplePoints(object)) {
-    this->resetVariables();
-    return empty_result;
+    getInitialSampleCloud(context, object);
+  }
+  voxelizeSampleCloud(context);
+  getMaxMinValues(context, object);
+  getFingerSamples(context, object);
+  getGripperClusters(context);
+  if (context.expired()) {
+    return context.sorted_gripper_configs;
   }
-
-  getInitialSampleCloud(object);
-  voxelizeSampleCloud();
-  getMaxMinValues(object);
-  getFingerSamples(object);
-  getGripperClusters();
   std::vector<std::shared_ptr<multiFingerGripper>> valid_open_gripper_configs =
-    getAllGripperConfigs(object, world_collision_object, camera_frame);
-  for (auto & gripper : valid_open_gripper_configs) {
-    getGraspPose(gripper, object);
+    getAllGripperConfigs(context, object, world_collision_object);
+  if (context.timed_out && !context.anytime) {
+    return context.sorted_gripper_configs;
   }
 
-  this->sorted_gripper_configs = getAllRanks(valid_open_gripper_configs, grasp_method);
-  return this->sorted_gripper_configs;
+  // Only the grasps that are returned are given a pose and a marker
+  context.sorted_gripper_configs = getBestRanks(
+    valid_open_gripper_configs, context.anytime ? context.max_grasps : 0);
+  for (auto & gripper : context.sorted_gripper_configs) {
+    getGraspPose(gripper, object);
+    getGraspMarker(gripper, camera_frame);
+  }
+  fillGraspMethod(context.sorted_gripper_configs, grasp_method);
+  return context.sorted_gripper_configs;
 }
 
+/***************************************************************************//**
+ * Inherited method that plans the grasps of an object with a context of its own
+ *
+ * @param object Grasp Object
+ * @param grasp_method Grasp method output for all possible grasps
+ * @param world_collision_object FCL collision object of the world
+ * @param camera_frame Frame of the grasp markers
+ ******************************************************************************/
 void FingerGripper::planGrasps(
   std::shared_ptr<GraspObject> object,
   emd_msgs::msg::GraspMethod * grasp_method,
   std::shared_ptr<CollisionObject> world_collision_object,
   std::string camera_frame)
 {
-  planGraspsWithFingerResult(object, grasp_method, world_collision_object, camera_frame);
+  FingerPlanningContext context;
+  planGraspsWithFingerResult(context, object, grasp_method, world_collision_object, camera_frame);
 }
 
 /***************************************************************************//**
@@ -223,7 +277,9 @@ void FingerGripper::planGrasps(
  * @param object grasp object
  ******************************************************************************/
 
-void FingerGripper::getCenterCuttingPlane(const std::shared_ptr<GraspObject> & object)
+void FingerGripper::getCenterCuttingPlane(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   /*! \brief First we find the normal of the cutting plane */
   Eigen::Vector3f centerpoint(
@@ -245,8 +301,8 @@ void FingerGripper::getCenterCuttingPlane(const std::shared_ptr<GraspObject> & o
   Eigen::Vector4f grasp_plane_vector(a, b, c, d);
   Eigen::Vector3f grasp_plane_normal_(a, b, c);
 
-  this->center_cutting_plane = grasp_plane_vector;
-  this->center_cutting_plane_normal = grasp_plane_normal_;
+  context.center_cutting_plane = grasp_plane_vector;
+  context.center_cutting_plane_normal = grasp_plane_normal_;
 
   bool side_1_even = this->num_fingers_side_1 % 2 == 0;
   bool side_2_even = this->num_fingers_side_2 % 2 == 0;
@@ -259,19 +315,19 @@ void FingerGripper::getCenterCuttingPlane(const std::shared_ptr<GraspObject> & o
       object->centerpoint(1),
       object->centerpoint(2));
 
-    this->grasp_samples.push_back(
+    context.grasp_samples.push_back(
       generateGraspSamples(
-        this->center_cutting_plane,
+        context.center_cutting_plane,
         centerpoint3f,
         0,
         0));
 
-    this->cutting_plane_distances.push_back(0);
+    context.cutting_plane_distances.push_back(0);
     if (!side_1_even) {
-      this->plane_1_index.push_back(0);
+      context.plane_1_index.push_back(0);
     }
     if (!side_2_even) {
-      this->plane_2_index.push_back(0);
+      context.plane_2_index.push_back(0);
     }
   }
 }
@@ -281,7 +337,9 @@ void FingerGripper::getCenterCuttingPlane(const std::shared_ptr<GraspObject> & o
  * the planar contact area for two fingers. For multi-fingered gripper, multiple planes are created,
  * @param object grasp object
  ******************************************************************************/
-void FingerGripper::getCuttingPlanes(const std::shared_ptr<GraspObject> & object)
+void FingerGripper::getCuttingPlanes(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   bool side_1_even = this->num_fingers_side_1 % 2 == 0;
   bool side_2_even = this->num_fingers_side_2 % 2 == 0;
@@ -292,11 +350,12 @@ void FingerGripper::getCuttingPlanes(const std::shared_ptr<GraspObject> & object
   if (both_sides_even || both_sides_odd) {
     if (this->distance_between_fingers_1 == this->distance_between_fingers_2) {
       addCuttingPlanesEqualAligned(
-        object->centerpoint, this->center_cutting_plane,
+        context, object->centerpoint, context.center_cutting_plane,
         both_sides_even);
     } else {
       addCuttingPlanes(
-        object->centerpoint, this->center_cutting_plane, this->num_itr_1, this->num_itr_2,
+        context, object->centerpoint, context.center_cutting_plane,
+        this->num_itr_1, this->num_itr_2,
         this->initial_gap_1,
         this->initial_gap_2);
     }
@@ -304,7 +363,7 @@ void FingerGripper::getCuttingPlanes(const std::shared_ptr<GraspObject> & object
   } else { /*! \brief If both sides are different, the spacing for planes is not consistent,
                       we need to create planes separately */
     addCuttingPlanes(
-      object->centerpoint, this->center_cutting_plane, this->num_itr_1, this->num_itr_2,
+      context, object->centerpoint, context.center_cutting_plane, this->num_itr_1, this->num_itr_2,
       this->initial_gap_1,
       this->initial_gap_2);
   }
@@ -321,9 +380,10 @@ void FingerGripper::getCuttingPlanes(const std::shared_ptr<GraspObject> & object
  * @param both_sides_even True if both sides of the end effector is even
  ******************************************************************************/
 void FingerGripper::addCuttingPlanesEqualAligned(
+  FingerPlanningContext & context,
   const Eigen::Vector4f & centerpoint,
   const Eigen::Vector4f & plane_vector,
-  const bool & both_sides_even)
+  const bool & both_sides_even) const
 {
   /*! \brief If both even, the initial gap is half the space between fingers, since middle plane is ignored
   If both odd, the initial gap is the space between fingers*/
@@ -333,40 +393,40 @@ void FingerGripper::addCuttingPlanesEqualAligned(
   int max_fingers = (side_1_max ? this->num_fingers_side_1 : this->num_fingers_side_2);
   int min_fingers = (side_1_max ? this->num_fingers_side_2 : this->num_fingers_side_1);
   int num_itr = (max_fingers == 1 ? 0 : floor(max_fingers / 2) + 1);
-  int curr_min_size = (side_1_max ? this->plane_2_index.size() : this->plane_1_index.size());
+  int curr_min_size = (side_1_max ? context.plane_2_index.size() : context.plane_1_index.size());
   for (int row = 0, updown_toggle = 1; row < num_itr; row += updown_toggle ^= 1) {
     float gap;
     gap =
       (updown_toggle ==
       0 ? 1 : -1) * (initial_gap + (row > 0 ? (row - 1) : 0) * this->distance_between_fingers_1);
-    int plane_index = checkPlaneExists(gap);
+    int plane_index = checkPlaneExists(context, gap);
     if (plane_index >= 0) {
       // std::cout << "plane exists" <<std::endl;
       // if(min_fingers > 0) // Plane still contains fingers on both side
       // {
-      //   this->plane_1_index.push_back(plane_index);
-      //   this->plane_2_index.push_back(plane_index);
+      //   context.plane_1_index.push_back(plane_index);
+      //   context.plane_2_index.push_back(plane_index);
       // }
       // else // Plane only contains fingers on the side with more fingers
       // {
       //   if(side_1_max)
       //   {
-      //     this->plane_1_index.push_back(plane_index);
+      //     context.plane_1_index.push_back(plane_index);
       //   }
       //   else{
-      //     this->plane_2_index.push_back(plane_index);
+      //     context.plane_2_index.push_back(plane_index);
       //   }
       // }
 
     } else {
       if (curr_min_size < min_fingers) {  // Plane still contains fingers on both side
-        addPlane(gap, centerpoint, plane_vector, true, true);
+        addPlane(context, gap, centerpoint, plane_vector, true, true);
         curr_min_size++;
       } else {  // Plane only contains fingers on the side with more fingers
         if (side_1_max) {
-          addPlane(gap, centerpoint, plane_vector, true, false);
+          addPlane(context, gap, centerpoint, plane_vector, true, false);
         } else {
-          addPlane(gap, centerpoint, plane_vector, false, true);
+          addPlane(context, gap, centerpoint, plane_vector, false, true);
         }
       }
     }
@@ -384,33 +444,34 @@ void FingerGripper::addCuttingPlanesEqualAligned(
  * @param initial_gap_2 Initial Gap from the center plane to the next cutting plane for side 2
  ******************************************************************************/
 void FingerGripper::addCuttingPlanes(
+  FingerPlanningContext & context,
   const Eigen::Vector4f & centerpoint,
   const Eigen::Vector4f & plane_vector,
   const int & num_itr_1,
   const int & num_itr_2,
   const float & initial_gap_1,
-  const float & initial_gap_2)
+  const float & initial_gap_2) const
 {
   for (int side_1 = 0, updown_toggle_1 = 1; side_1 < num_itr_1; side_1 += updown_toggle_1 ^= 1) {
     float gap;
     gap =
       (updown_toggle_1 == 0 ? 1 : -1) * (initial_gap_1 + side_1 * this->distance_between_fingers_1);
-    int plane_index = checkPlaneExists(gap);
+    int plane_index = checkPlaneExists(context, gap);
     if (plane_index >= 0) {
-      this->plane_1_index.push_back(plane_index);
+      context.plane_1_index.push_back(plane_index);
     } else {
-      addPlane(gap, centerpoint, plane_vector, true, false);
+      addPlane(context, gap, centerpoint, plane_vector, true, false);
     }
   }
   for (int side_2 = 0, updown_toggle_2 = 1; side_2 < num_itr_2; side_2 += updown_toggle_2 ^= 1) {
     float gap;
     gap =
       (updown_toggle_2 == 0 ? 1 : -1) * (initial_gap_2 + side_2 * this->distance_between_fingers_2);
-    int plane_index = checkPlaneExists(gap);
+    int plane_index = checkPlaneExists(context, gap);
     if (plane_index >= 0) {
-      this->plane_2_index.push_back(plane_index);
+      context.plane_2_index.push_back(plane_index);
     } else {
-      addPlane(gap, centerpoint, plane_vector, false, true);
+      addPlane(context, gap, centerpoint, plane_vector, false, true);
     }
   }
 }
@@ -422,12 +483,14 @@ void FingerGripper::addCuttingPlanes(
  * @param dist Distance from the center plane to the current plane checked
  ******************************************************************************/
 
-int FingerGripper::checkPlaneExists(const float & dist)
+int FingerGripper::checkPlaneExists(
+  const FingerPlanningContext & context,
+  const float & dist) const
 {
-  std::vector<float>::iterator it = std::find(
-    this->cutting_plane_distances.begin(), this->cutting_plane_distances.end(), dist);
-  if (it != this->cutting_plane_distances.end()) {
-    return it - this->cutting_plane_distances.begin();
+  std::vector<float>::const_iterator it = std::find(
+    context.cutting_plane_distances.begin(), context.cutting_plane_distances.end(), dist);
+  if (it != context.cutting_plane_distances.end()) {
+    return it - context.cutting_plane_distances.begin();
   } else {
     return -1;
   }
@@ -444,11 +507,12 @@ int FingerGripper::checkPlaneExists(const float & dist)
  ******************************************************************************/
 
 void FingerGripper::addPlane(
+  FingerPlanningContext & context,
   const float & dist,
   const Eigen::Vector4f & centerpoint,
   const Eigen::Vector4f & plane_vector,
   const bool & inside_1,
-  const bool & inside_2)
+  const bool & inside_2) const
 {
   // Get the vector representing the gripper direction
   Eigen::Vector3f plane_normal(plane_vector(0), plane_vector(1), plane_vector(2));
@@ -457,12 +521,10 @@ void FingerGripper::addPlane(
   Eigen::Vector3f point_on_plane(centerpoint(0) + dist * plane_normal_norm(0), centerpoint(
       1) + dist * plane_normal_norm(1), centerpoint(2) + dist * plane_normal_norm(2));
 
-  static std::mutex mutex;
-  std::lock_guard<std::mutex> lock(mutex);
-  int curr_index = this->grasp_samples.size();
-  this->cutting_plane_distances.push_back(dist);
+  int curr_index = context.grasp_samples.size();
+  context.cutting_plane_distances.push_back(dist);
 
-  this->grasp_samples.push_back(
+  context.grasp_samples.push_back(
     generateGraspSamples(
       plane_vector,
       point_on_plane,
@@ -470,31 +532,40 @@ void FingerGripper::addPlane(
       curr_index));
 
   if (inside_1) {
-    this->plane_1_index.push_back(curr_index);
+    context.plane_1_index.push_back(curr_index);
   }
   if (inside_2) {
-    this->plane_2_index.push_back(curr_index);
+    context.plane_2_index.push_back(curr_index);
   }
 }
 
 /***************************************************************************//**
- * Function to create a grasp cloud. Thisis done through SAC which finds points within the
- * grasp_plane_dist_limit. This create a strip of point cloud about the grasp plane.
+ * Function to create a grasp cloud. Thisis done by finding the points within the
+ * grasp_plane_dist_limit of each plane. This create a strip of point cloud about the grasp plane.
+ * The cutting planes are parallel, so the object cloud is binned into all of them in one pass.
+ * On a voxelized object cloud, the strips are at least half a voxel wide.
  * @param object grasp object
  ******************************************************************************/
-bool FingerGripper::getGraspCloud(const std::shared_ptr<GraspObject> & object)
+bool FingerGripper::getGraspCloud(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   bool at_least_one_plane_intersect = false;
-  pcl::SampleConsensusModelPlane<pcl::PointNormal>::Ptr planeSAC(
-    new pcl::SampleConsensusModelPlane<pcl::PointNormal>(
-      object->cloud_normal));
-  for (auto & sample : this->grasp_samples) {
-    Eigen::Vector4f plane_vector(sample->plane->values[0], sample->plane->values[1],
+  std::vector<Eigen::Vector4f> planes;
+  planes.reserve(context.grasp_samples.size());
+  for (auto & sample : context.grasp_samples) {
+    planes.emplace_back(
+      sample->plane->values[0], sample->plane->values[1],
       sample->plane->values[2], sample->plane->values[3]);
+  }
+  // A voxelized cloud is too sparse for strips thinner than half a voxel
+  std::vector<std::vector<int>> plane_indices = PCLFunctions::selectWithinDistanceOfPlanes(
+    object->cloud_normal, planes,
+    std::max(this->grasp_plane_dist_limit, context.cloud_resolution / 2));
+  for (size_t i = 0; i < context.grasp_samples.size(); i++) {
+    const std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i];
     pcl::PointIndices::Ptr grasp_plane_indices(new pcl::PointIndices);
-    planeSAC->selectWithinDistance(
-      plane_vector, this->grasp_plane_dist_limit,
-      grasp_plane_indices->indices);
+    grasp_plane_indices->indices = std::move(plane_indices[i]);
     PCLFunctions::extractInliersCloud<pcl::PointCloud<pcl::PointNormal>::Ptr,
       pcl::ExtractIndices<pcl::PointNormal>>(
       object->cloud_normal,
@@ -513,9 +584,12 @@ bool FingerGripper::getGraspCloud(const std::shared_ptr<GraspObject> & object)
 /***************************************************************************//**
  * Function that determines the start points on the center plane of the object depending
  * on the angle of the object with respect to the world. This start point will represent
- * the center of the finger cloud on that side of this plane.
+ * the center of the finger cloud on that side of this plane. The third of the points closest
+ * to the grasp axis is selected without sorting the points.
  ******************************************************************************/
-bool FingerGripper::getInitialSamplePoints(const std::shared_ptr<GraspObject> & object)
+bool FingerGripper::getInitialSamplePoints(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   pcl::PointNormal centerpoint;
   centerpoint.x = object->centerpoint(0);
@@ -527,7 +601,7 @@ bool FingerGripper::getInitialSamplePoints(const std::shared_ptr<GraspObject> &
     object->centerpoint(1),
     object->centerpoint(2));
 
-  for (auto & sample : this->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     int first_point_index, second_point_index;
     float min_dist = std::numeric_limits<float>::max();
     // float min_linepoint_factor = std::numeric_limits<float>::max();
@@ -535,6 +609,7 @@ bool FingerGripper::getInitialSamplePoints(const std::shared_ptr<GraspObject> &
     // float max_linepoint_factor = std::numeric_limits<float>::max();
     std::vector<MathFunctions::Point> point_vector;
     if (sample->plane_intersects_object) {
+      point_vector.reserve(sample->grasp_plane_ncloud->points.size());
       for (size_t i = 0; i < sample->grasp_plane_ncloud->points.size(); ++i) {
 
         Eigen::Vector3f point(
@@ -551,24 +626,41 @@ bool FingerGripper::getInitialSamplePoints(const std::shared_ptr<GraspObject> &
         point_vector.push_back(point_temp);
       }
 
-      // Sort point vector according to its perpendicular distance from the direction vector
-      std::sort(
-        point_vector.begin(), point_vector.end(),
-        [](MathFunctions::Point a, MathFunctions::Point b)
-        {return a.perpendicular_distance < b.perpendicular_distance;});
+      // Order of the points by their perpendicular distance from the direction vector
+      auto closer = [](const MathFunctions::Point & a, const MathFunctions::Point & b)
+        {
+          return a.perpendicular_distance < b.perpendicular_distance ||
+                 (a.perpendicular_distance == b.perpendicular_distance && a.index < b.index);
+        };
 
-      // Get the first 1/3 of points in the sorted vector (1/3 pts closest to the vector)
+      // Get the first 1/3 of points in that order (1/3 pts closest to the vector)
       int resize_size = static_cast<int>(point_vector.size() / 3);
+      if (resize_size > 0) {
+        std::nth_element(
+          point_vector.begin(), point_vector.begin() + (resize_size - 1), point_vector.end(),
+          closer);
+      }
 
+      // Among equally distant points, the closest to the vector is taken, as in sorted order
+      const MathFunctions::Point * first_point = nullptr;
+      const MathFunctions::Point * second_point = nullptr;
       for (int i = 0; i < resize_size; i++) {
-        if (point_vector[i].projection_distance < min_dist) {
-          min_dist = point_vector[i].projection_distance;
-          first_point_index = point_vector[i].index;
+        const MathFunctions::Point & point = point_vector[i];
+        if (point.projection_distance < min_dist ||
+          (first_point && point.projection_distance == min_dist && closer(point, *first_point)))
+        {
+          min_dist = point.projection_distance;
+          first_point = &point;
+          first_point_index = point.index;
         }
 
-        if (point_vector[i].projection_distance > max_dist) {
-          max_dist = point_vector[i].projection_distance;
-          second_point_index = point_vector[i].index;
+        if (point.projection_distance > max_dist ||
+          (second_point && point.projection_distance == max_dist &&
+          closer(point, *second_point)))
+        {
+          max_dist = point.projection_distance;
+          second_point = &point;
+          second_point_index = point.index;
         }
       }
       sample->sample_side_1->start_index = first_point_index;
@@ -581,176 +673,236 @@ bool FingerGripper::getInitialSamplePoints(const std::shared_ptr<GraspObject> &
 /***************************************************************************//**
  * Function that gets the cluster of point clouds based on a certain radius from
  * a certain start index that has already been defined in another method. This cluster
- * of point clouds will repreesnt the gripper finger point cloud at that point on the plane
+ * of point clouds will repreesnt the gripper finger point cloud at that point on the plane.
+ * On a voxelized object cloud, the radius grows by a voxel to cover the full resolution cluster.
  ******************************************************************************/
-void FingerGripper::getInitialSampleCloud(const std::shared_ptr<GraspObject> & object)
+void FingerGripper::getInitialSampleCloud(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
-  std::vector<std::future<void>> futures;
-  auto getAllRadiusPoints = [this](
-    std::shared_ptr<graspPlaneSample> & sample,
-    const std::shared_ptr<GraspObject> & object) -> void
+  // All planes query the same tree over the object normal cloud
+  pcl::search::KdTree<pcl::PointNormal>::Ptr normal_cloud_search = object->getNormalCloudSearch();
+  const float radius = this->finger_thickness + context.cloud_resolution;
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, context.grasp_samples.size(),
+    [&context, &object, &normal_cloud_search, &radius](std::size_t i)
     {
+      std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i];
       if (sample->plane_intersects_object) {
         PCLFunctions::getClosestPointsByRadius(
           sample->grasp_plane_ncloud->points[sample->sample_side_1->start_index],
-          this->finger_thickness, object->cloud, object->cloud_normal,
+          radius, object->cloud, object->cloud_normal, normal_cloud_search,
           sample->sample_side_1->finger_cloud, sample->sample_side_1->finger_ncloud);
 
-          auto index = sample->sample_side_2->start_index;
-          if(index <=0 || sample->grasp_plane_ncloud->points.size() <= index)
-          {
-            return;
-          }
-          
+        auto index = sample->sample_side_2->start_index;
+        if (index <= 0 || sample->grasp_plane_ncloud->points.size() <= index) {
+          return;
+        }
+
         PCLFunctions::getClosestPointsByRadius(
           sample->grasp_plane_ncloud->points[sample->sample_side_2->start_index],
-          this->finger_thickness, object->cloud, object->cloud_normal,
+          radius, object->cloud, object->cloud_normal, normal_cloud_search,
           sample->sample_side_2->finger_cloud, sample->sample_side_2->finger_ncloud);
       }
-    };
-  for (auto & sample : this->grasp_samples) {
-    futures.push_back(
-      std::async(
-        std::launch::async,
-        getAllRadiusPoints,
-        std::ref(sample),
-        std::ref(object)));
+    });
+}
+
+/***************************************************************************//**
+ * Method that runs the coarse level of a coarse to fine search, and gathers the finger clouds
+ * of the fine level around the best grasps it finds. The coarse level runs the whole pipeline
+ * on the object cloud voxelized at coarse_voxel_size, and only checks collisions with the
+ * occupancy grid when there is one. The fine level then takes the full resolution object cloud
+ * around the fingers of the coarse_candidates best coarse grasps. Returns false if the coarse
+ * level found no grasp, the finger clouds are then left empty.
+ * @param context Planning context of this request, holding its cutting planes
+ * @param object Grasp object
+ * @param world_collision_object FCL collision object of the world
+ ******************************************************************************/
+bool FingerGripper::getRefinedSampleCloud(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object,
+  const std::shared_ptr<CollisionObject> & world_collision_object) const
+{
+  // The cutting planes only depend on the center and axes of the object
+  std::shared_ptr<GraspObject> coarse_object = std::make_shared<GraspObject>(
+    object->object_name, object->object_frame,
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr(new pcl::PointCloud<pcl::PointXYZRGB>),
+    object->centerpoint);
+  coarse_object->axis = object->axis;
+  coarse_object->minor_axis = object->minor_axis;
+  coarse_object->grasp_axis = object->grasp_axis;
+  PCLFunctions::voxelizeCloud<pcl::PointCloud<pcl::PointNormal>::Ptr,
+    pcl::VoxelGrid<pcl::PointNormal>>(
+    object->cloud_normal, this->coarse_voxel_size, coarse_object->cloud_normal);
+  pcl::copyPointCloud(*coarse_object->cloud_normal, *coarse_object->cloud);
+
+  FingerPlanningContext coarse_context;
+  coarse_context.deadline = context.deadline;
+  coarse_context.world_grid = context.world_grid;
+  coarse_context.world_distance_field = context.world_distance_field;
+  coarse_context.cloud_resolution = this->coarse_voxel_size;
+  getCenterCuttingPlane(coarse_context, coarse_object);
+  getCuttingPlanes(coarse_context, coarse_object);
+  if (coarse_context.grasp_samples.size() != context.grasp_samples.size() ||
+    !getGraspCloud(coarse_context, coarse_object) ||
+    !getInitialSamplePoints(coarse_context, coarse_object))
+  {
+    return false;
+  }
+  getInitialSampleCloud(coarse_context, coarse_object);
+  voxelizeSampleCloud(coarse_context);
+  getMaxMinValues(coarse_context, coarse_object);
+  getFingerSamples(coarse_context, coarse_object);
+  std::vector<std::shared_ptr<multiFingerGripper>> coarse_grippers = getBestRanks(
+    getAllGripperConfigs(coarse_context, coarse_object, world_collision_object),
+    static_cast<size_t>(this->coarse_candidates));
+  if (coarse_grippers.empty()) {
+    return false;
   }
+
+  // Finger points of the best coarse grasps on each side of each cutting plane
+  std::vector<std::vector<pcl::PointNormal>> finger_points(2 * context.grasp_samples.size());
+  for (const auto & gripper : coarse_grippers) {
+    finger_points[2 * gripper->base_point_1->plane_index].push_back(
+      gripper->base_point_1->finger_point);
+    finger_points[2 * gripper->base_point_2->plane_index + 1].push_back(
+      gripper->base_point_2->finger_point);
+    for (const auto & finger : gripper->closed_fingers_1) {
+      finger_points[2 * finger->plane_index].push_back(finger->finger_point);
+    }
+    for (const auto & finger : gripper->closed_fingers_2) {
+      finger_points[2 * finger->plane_index + 1].push_back(finger->finger_point);
+    }
+  }
+  for (size_t i = 0; i < context.grasp_samples.size(); i++) {
+    const std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i];
+    const std::shared_ptr<graspPlaneSample> & coarse_sample = coarse_context.grasp_samples[i];
+    sample->plane_intersects_object = coarse_sample->plane_intersects_object;
+    sample->grasp_plane_ncloud = coarse_sample->grasp_plane_ncloud;
+    sample->sample_side_1->start_index = coarse_sample->sample_side_1->start_index;
+    sample->sample_side_2->start_index = coarse_sample->sample_side_2->start_index;
+  }
+
+  // A coarse finger point stands for the full resolution points of its voxel
+  const float radius = std::max(this->finger_thickness, this->coarse_voxel_size);
+  pcl::search::KdTree<pcl::PointNormal>::Ptr normal_cloud_search = object->getNormalCloudSearch();
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, finger_points.size(),
+    [&context, &object, &normal_cloud_search, &finger_points, &radius](std::size_t i)
+    {
+      if (finger_points[i].empty()) {
+        return;
+      }
+      const std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i / 2];
+      const std::shared_ptr<fingerCloudSample> & sample_side =
+        (i % 2 == 0) ? sample->sample_side_1 : sample->sample_side_2;
+      pcl::PointIndices::Ptr finger_indices(new pcl::PointIndices);
+      std::vector<int> indices;
+      std::vector<float> squared_distances;
+      for (const auto & finger_point : finger_points[i]) {
+        normal_cloud_search->radiusSearch(finger_point, radius, indices, squared_distances);
+        finger_indices->indices.insert(
+          finger_indices->indices.end(), indices.begin(), indices.end());
+      }
+      std::sort(finger_indices->indices.begin(), finger_indices->indices.end());
+      finger_indices->indices.erase(
+        std::unique(finger_indices->indices.begin(), finger_indices->indices.end()),
+        finger_indices->indices.end());
+      if (finger_indices->indices.empty()) {
+        return;
+      }
+      PCLFunctions::extractInliersCloud<pcl::PointCloud<pcl::PointXYZRGB>::Ptr,
+        pcl::ExtractIndices<pcl::PointXYZRGB>>(
+        object->cloud, finger_indices, sample_side->finger_cloud);
+      PCLFunctions::extractInliersCloud<pcl::PointCloud<pcl::PointNormal>::Ptr,
+        pcl::ExtractIndices<pcl::PointNormal>>(
+        object->cloud_normal, finger_indices, sample_side->finger_ncloud);
+    });
+  return true;
 }
 
 /***************************************************************************//**
  * Function to voxelize a sample cloud
- * This is used to voxelize finger sample cloud for easier traversal
+ * This is used to voxelize finger sample cloud for easier traversal. Sample clouds of a
+ * voxelized object cloud are not voxelized finer than the object cloud.
  ******************************************************************************/
-void FingerGripper::voxelizeSampleCloud()
+void FingerGripper::voxelizeSampleCloud(FingerPlanningContext & context) const
 {
-  auto getAllRadiusPoints = [this](
-    std::shared_ptr<graspPlaneSample> & sample) -> void
+  const float leaf_size = std::max(this->finger_thickness, context.cloud_resolution);
+  // One task per side of each plane
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, 2 * context.grasp_samples.size(), [&context, &leaf_size](std::size_t i)
     {
-      auto getEachRadiusPoints = [this](
-        std::shared_ptr<fingerCloudSample> & sample_side) -> void
-        {
-          PCLFunctions::voxelizeCloud<pcl::PointCloud<pcl::PointNormal>::Ptr,
-            pcl::VoxelGrid<pcl::PointNormal>>(
-            sample_side->finger_ncloud,
-            this->finger_thickness,
-            sample_side->finger_nvoxel);
-        };
-
-      std::vector<std::future<void>> futures_inner;
-      futures_inner.push_back(
-        std::async(
-          std::launch::async,
-          getEachRadiusPoints,
-          std::ref(sample->sample_side_1)));
-      futures_inner.push_back(
-        std::async(
-          std::launch::async,
-          getEachRadiusPoints,
-          std::ref(sample->sample_side_2)));
-    };
-  std::vector<std::future<void>> futures;
-  for (auto & sample : this->grasp_samples) {
-    futures.push_back(
-      std::async(
-        std::launch::async,
-        getAllRadiusPoints,
-        std::ref(sample)));
-  }
+      const std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i / 2];
+      const std::shared_ptr<fingerCloudSample> & sample_side =
+        (i % 2 == 0) ? sample->sample_side_1 : sample->sample_side_2;
+      PCLFunctions::voxelizeCloud<pcl::PointCloud<pcl::PointNormal>::Ptr,
+        pcl::VoxelGrid<pcl::PointNormal>>(
+        sample_side->finger_ncloud,
+        leaf_size,
+        sample_side->finger_nvoxel);
+    });
 }
 
 /***************************************************************************//**
- * Method that generates all possible finger grasp samples
+ * Method that generates all possible finger grasp samples. The samples of each side of a plane
+ * are allocated together, and their attributes used for pairing are also stored as arrays.
  *
  * @param object Grasp Object
  ******************************************************************************/
-void FingerGripper::getFingerSamples(const std::shared_ptr<GraspObject> & object)
+void FingerGripper::getFingerSamples(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   pcl::PointNormal centroid_point;
   centroid_point.x = object->centerpoint(0);
   centroid_point.y = object->centerpoint(1);
   centroid_point.z = object->centerpoint(2);
 
-  std::vector<std::future<void>> futures;
-  auto getFingerSample = [this](
-    std::shared_ptr<graspPlaneSample> & sample,
-    pcl::PointNormal & centroid_point) -> void
+  // One task per side of each plane, each writing its own pre-sized range of finger samples
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, 2 * context.grasp_samples.size(), [this, &context, &centroid_point](std::size_t i)
     {
-      auto getFingerSampleFromSide1 = [this](
-        const pcl::PointNormal & point,
-        pcl::PointNormal & centroid_point,
-        std::shared_ptr<graspPlaneSample> & sample) -> void
-        {
-          // Eigen::Vector3f curr1_vector(point.x, point.y, point.z);
-          float centroid_dist = MathFunctions::normalize(
-            pcl::geometry::distance(point, centroid_point),
-            sample->sample_side_1->centroid_dist_min, sample->sample_side_1->centroid_dist_max);
-          float grasp_plane_dist = MathFunctions::normalize(
-            PCLFunctions::pointToPlane(sample->plane_eigen, point),
-            sample->sample_side_1->grasp_plane_dist_min,
-            sample->sample_side_1->grasp_plane_dist_max);
-          float curvature = MathFunctions::normalize(
-            point.curvature,
-            sample->sample_side_1->curvature_min, sample->sample_side_1->curvature_max);
-          singleFinger finger(point, centroid_dist, grasp_plane_dist, curvature,
-            sample->plane_index);
-          static std::mutex mutex;
-          std::lock_guard<std::mutex> lock(mutex);
-          sample->sample_side_1->finger_samples.push_back(std::make_shared<singleFinger>(finger));
-        };
-      auto getFingerSampleFromSide2 = [this](
-        const pcl::PointNormal & point,
-        pcl::PointNormal & centroid_point,
-        std::shared_ptr<graspPlaneSample> & sample) -> void
-        {
-          // Eigen::Vector3f curr2_vector(point.x, point.y, point.z);
-          float centroid_dist = MathFunctions::normalize(
-            pcl::geometry::distance(point, centroid_point),
-            sample->sample_side_2->centroid_dist_min, sample->sample_side_2->centroid_dist_max);
-          float grasp_plane_dist = MathFunctions::normalize(
-            PCLFunctions::pointToPlane(sample->plane_eigen, point),
-            sample->sample_side_2->grasp_plane_dist_min,
-            sample->sample_side_2->grasp_plane_dist_max);
-          float curvature = MathFunctions::normalize(
-            point.curvature,
-            sample->sample_side_2->curvature_min, sample->sample_side_2->curvature_max);
-          singleFinger finger(point, centroid_dist, grasp_plane_dist, curvature,
-            sample->plane_index);
-          static std::mutex mutex;
-          std::lock_guard<std::mutex> lock(mutex);
-          sample->sample_side_2->finger_samples.push_back(std::make_shared<singleFinger>(finger));
-        };
-      std::vector<std::future<void>> futures_inner1;
-      if (sample->plane_intersects_object) {
-        for (auto const & curr1_point : sample->sample_side_1->finger_nvoxel->points) {
-          futures_inner1.push_back(
-            std::async(
-              std::launch::async,
-              getFingerSampleFromSide1,
-              std::ref(curr1_point),
-              std::ref(centroid_point),
-              std::ref(sample)));
-        }
-        std::vector<std::future<void>> futures_inner2;
-        for (auto const & curr2_point : sample->sample_side_2->finger_nvoxel->points) {
-          futures_inner2.push_back(
-            std::async(
-              std::launch::async,
-              getFingerSampleFromSide2,
-              std::ref(curr2_point),
-              std::ref(centroid_point),
-              std::ref(sample)));
-        }
+      const std::shared_ptr<graspPlaneSample> & sample = context.grasp_samples[i / 2];
+      if (!sample->plane_intersects_object) {
+        return;
       }
-    };
-  for (auto & sample : this->grasp_samples) {
-    futures.push_back(
-      std::async(
-        std::launch::async,
-        getFingerSample,
-        std::ref(sample),
-        std::ref(centroid_point)));
-  }
+      const std::shared_ptr<fingerCloudSample> & sample_side =
+        (i % 2 == 0) ? sample->sample_side_1 : sample->sample_side_2;
+      const auto & voxel_points = sample_side->finger_nvoxel->points;
+      const std::size_t offset = sample_side->finger_samples.size();
+      const Eigen::Index num_samples = static_cast<Eigen::Index>(offset + voxel_points.size());
+      sample_side->finger_samples.resize(offset + voxel_points.size());
+      sample_side->finger_positions.conservativeResize(Eigen::NoChange, num_samples);
+      sample_side->finger_normals.conservativeResize(Eigen::NoChange, num_samples);
+      sample_side->finger_grasp_plane_dists.conservativeResize(num_samples);
+      sample_side->finger_curvatures.conservativeResize(num_samples);
+      std::shared_ptr<std::vector<singleFinger>> finger_arena =
+        std::make_shared<std::vector<singleFinger>>();
+      finger_arena->reserve(voxel_points.size());
+      for (std::size_t j = 0; j < voxel_points.size(); j++) {
+        const pcl::PointNormal & point = voxel_points[j];
+        float centroid_dist = MathFunctions::normalize(
+          pcl::geometry::distance(point, centroid_point),
+          sample_side->centroid_dist_min, sample_side->centroid_dist_max);
+        float grasp_plane_dist = MathFunctions::normalize(
+          PCLFunctions::pointToPlane(sample->plane_eigen, point),
+          sample_side->grasp_plane_dist_min,
+          sample_side->grasp_plane_dist_max);
+        float curvature = MathFunctions::normalize(
+          point.curvature,
+          sample_side->curvature_min, sample_side->curvature_max);
+        finger_arena->emplace_back(
+          point, centroid_dist, grasp_plane_dist, curvature, sample->plane_index);
+        sample_side->finger_samples[offset + j] =
+          std::shared_ptr<singleFinger>(finger_arena, &finger_arena->back());
+        const Eigen::Index index = static_cast<Eigen::Index>(offset + j);
+        sample_side->finger_positions.col(index) = PCLFunctions::convertPCLtoEigen(point);
+        sample_side->finger_normals.col(index) = PCLFunctions::convertPCLNormaltoEigen(point);
+        sample_side->finger_grasp_plane_dists(index) = grasp_plane_dist;
+        sample_side->finger_curvatures(index) = curvature;
+      }
+    });
 }
 
 /***************************************************************************//**
@@ -758,92 +910,210 @@ void FingerGripper::getFingerSamples(const std::shared_ptr<GraspObject> & object
  * (2 per plane), we now choose the correct finger clouds that corresponds to
  * the multifinger gripper. TODO:
  ******************************************************************************/
-void FingerGripper::getGripperClusters()
+void FingerGripper::getGripperClusters(FingerPlanningContext & context) const
 {
-  for (size_t i = 0; i < this->grasp_samples.size(); i++) {
+  for (size_t i = 0; i < context.grasp_samples.size(); i++) {
     // grasp planes that do not intersect the object would not contain grasp clouds.
-    if (this->grasp_samples[i]->plane_intersects_object) {
+    if (context.grasp_samples[i]->plane_intersects_object) {
       // Check if this grasp plane contains finger on side 1
       if (std::find(
-          this->plane_1_index.begin(), this->plane_1_index.end(),
-          i) != this->plane_1_index.end())
+          context.plane_1_index.begin(), context.plane_1_index.end(),
+          i) != context.plane_1_index.end())
       {
         // Finger cloud on side 1 on this plane is part of the gripper
-        this->gripper_clusters.push_back(this->grasp_samples[i]->sample_side_1->finger_samples);
+        context.gripper_clusters.push_back(context.grasp_samples[i]->sample_side_1->finger_samples);
       }
       // Check if this grasp plane contains finger on side 2
       if (std::find(
-          this->plane_2_index.begin(), this->plane_2_index.end(),
-          i) != this->plane_2_index.end())
+          context.plane_2_index.begin(), context.plane_2_index.end(),
+          i) != context.plane_2_index.end())
       {
         // Finger cloud on side 2 on this plane is part of the gripper
-        this->gripper_clusters.push_back(this->grasp_samples[i]->sample_side_2->finger_samples);
+        context.gripper_clusters.push_back(context.grasp_samples[i]->sample_side_2->finger_samples);
       }
     }
   }
 }
 
 /***************************************************************************//**
- * Function to create all possible gripper configurations. Returns a vector
- * containing the configurations.
+ * Function that pairs the finger samples of both sides at the center cutting plane, and
+ * prefilters the pairs with tests that only need the two samples. Pairs further apart than
+ * the gripper stroke cannot be grasped, and with a friction cone angle below pi/2, pairs
+ * where the surface normal at either finger is further from the grasp direction than the
+ * friction cone angle are not antipodal. Returns the remaining pairs sorted by decreasing
+ * upper bound of the rank of the gripper configurations built on them. The bound counts the
+ * center fingers, the only fingers known from the pair, and assumes the rest are perfect.
+ * @param context Planning context holding the finger samples
+ ******************************************************************************/
+std::vector<fingerPair> FingerGripper::getFingerPairs(const FingerPlanningContext & context) const
+{
+  const fingerCloudSample & side_1 = *context.grasp_samples[0]->sample_side_1;
+  const fingerCloudSample & side_2 = *context.grasp_samples[0]->sample_side_2;
+  const int num_samples_1 = static_cast<int>(side_1.finger_positions.cols());
+  const int num_samples_2 = static_cast<int>(side_2.finger_positions.cols());
+
+  const Eigen::Matrix3Xf & points_1 = side_1.finger_positions;
+  const Eigen::Matrix3Xf & points_2 = side_2.finger_positions;
+  const Eigen::Matrix3Xf normals_1 = side_1.finger_normals.colwise().normalized();
+  const Eigen::Matrix3Xf normals_2 = side_2.finger_normals.colwise().normalized();
+  const Eigen::Vector3f plane_normal = context.center_cutting_plane_normal.normalized();
+
+  const float squared_stroke = this->gripper_stroke * this->gripper_stroke;
+  const bool check_antipodal = this->friction_cone_angle < M_PI / 2;
+  const float min_angle_cos = std::cos(this->friction_cone_angle);
+  const float rank_bound_base = (this->grasp_quality_weight1 + this->grasp_quality_weight2) *
+    this->num_fingers_total + std::max(this->grasp_clearance_weight, 0.0f);
+
+  // Only the pairs that pass the prefilter are kept
+  std::vector<fingerPair> pairs;
+  for (int i = 0; i < num_samples_1; i++) {
+    for (int j = 0; j < num_samples_2; j++) {
+      const Eigen::Vector3f pair_vector = points_2.col(j) - points_1.col(i);
+      const float squared_distance = pair_vector.squaredNorm();
+      if (squared_distance > squared_stroke || squared_distance == 0) {
+        continue;
+      }
+      const float distance = std::sqrt(squared_distance);
+      if (check_antipodal &&
+        (std::abs(normals_1.col(i).dot(pair_vector)) < min_angle_cos * distance ||
+        std::abs(normals_2.col(j).dot(pair_vector)) < min_angle_cos * distance))
+      {
+        continue;
+      }
+      float rank_bound = rank_bound_base - this->grasp_quality_weight1 * 10.0 *
+        (std::abs(plane_normal.dot(pair_vector)) / distance - 0.2);
+      if (!this->is_even_1) {
+        rank_bound -= this->grasp_quality_weight1 * side_1.finger_grasp_plane_dists(i) +
+          this->grasp_quality_weight2 * side_1.finger_curvatures(i);
+      }
+      if (!this->is_even_2) {
+        rank_bound -= this->grasp_quality_weight1 * side_2.finger_grasp_plane_dists(j) +
+          this->grasp_quality_weight2 * side_2.finger_curvatures(j);
+      }
+      // Pairs with undefined normals or curvature cannot be ranked, they are tried last
+      if (!std::isfinite(rank_bound)) {
+        rank_bound = std::numeric_limits<float>::lowest();
+      }
+      pairs.push_back({i, j, rank_bound});
+    }
+  }
+  std::stable_sort(
+    pairs.begin(), pairs.end(), [](const fingerPair & a, const fingerPair & b) {
+      return a.rank_bound > b.rank_bound;
+    });
+  return pairs;
+}
 
+/***************************************************************************//**
+ * Function to create all possible gripper configurations. Returns a vector
+ * containing the configurations. Only the finger pairs that pass the pair prefilter
+ * are expanded, in decreasing order of their rank bound.
+ * An anytime search keeps the configurations found before the deadline, and with
+ * max_grasps set, stops once that many configurations reach the minimum rank or once
+ * the rank bound of the remaining pairs shows none can enter the best max_grasps. The bound
+ * only holds for non negative quality weights.
+
+ * @param context Planning context of this request
  * @param object Object to be grasped
  * @param world_collision_object Collision object representing the world
  ******************************************************************************/
 
 std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getAllGripperConfigs(
+  FingerPlanningContext & context,
   const std::shared_ptr<GraspObject> & object,
-  const std::shared_ptr<CollisionObject> & world_collision_object,
-  std::string camera_frame)
+  const std::shared_ptr<CollisionObject> & world_collision_object) const
 {
   std::vector<std::shared_ptr<multiFingerGripper>> valid_open_gripper_configs;
   // Query the gripping points at the center cutting plane
-  if (this->grasp_samples[0]->plane_intersects_object) {
-    for (auto & finger_sample_1 : this->grasp_samples[0]->sample_side_1->finger_samples) {
-      for (auto & finger_sample_2 : this->grasp_samples[0]->sample_side_2->finger_samples) {
-        Eigen::Vector3f centerpoint_side1_vector =
-          PCLFunctions::convertPCLtoEigen(finger_sample_1->finger_point);
-        Eigen::Vector3f centerpoint_side2_vector =
-          PCLFunctions::convertPCLtoEigen(finger_sample_2->finger_point);
-
-        // Get the vector representing the grasping direction
-        Eigen::Vector3f grasp_direction = Eigen::ParametrizedLine<float, 3>::Through(
-          centerpoint_side1_vector, centerpoint_side2_vector).direction();
-
-        // Find the angle of the normal vector of each point with the grasp direction vector.
-        finger_sample_1->angle_cos = MathFunctions::getAngleBetweenVectors(
-          grasp_direction,
-          {finger_sample_1->finger_point.normal_x,
-            finger_sample_1->finger_point.normal_y,
-            finger_sample_1->finger_point.normal_z});
-
-        finger_sample_2->angle_cos = MathFunctions::getAngleBetweenVectors(
-          grasp_direction,
-          {finger_sample_2->finger_point.normal_x,
-            finger_sample_2->finger_point.normal_y,
-            finger_sample_2->finger_point.normal_z});
-
-        /* Get the vector perpendicular to the grasp direction. This vector will be used to generate
-         the other fingers with reference to the center finger. */
-
-        Eigen::Vector3f perpendicular_grasp_direction = getGripperPlane(
-          finger_sample_1,
-          finger_sample_2,
-          grasp_direction, object);
-
-        /* Get the coordinates of the open finger configuration of the center fingers of the gripper */
-        std::vector<Eigen::Vector3f> open_coords = getOpenFingerCoordinates(
-          grasp_direction,
-          centerpoint_side1_vector,
-          centerpoint_side2_vector);
-
-        /* With the open configuration of the center fingers, generate the rest of the open configuration grippers */
-        std::shared_ptr<multiFingerGripper> gripper_sample = generateGripperOpenConfig(
-          world_collision_object, finger_sample_1, finger_sample_2,
-          open_coords[0], open_coords[1], perpendicular_grasp_direction,
-          grasp_direction, camera_frame);
-        if (!gripper_sample->collides_with_world) {
-          valid_open_gripper_configs.push_back(gripper_sample);
+  if (context.grasp_samples[0]->plane_intersects_object) {
+    const std::vector<std::shared_ptr<singleFinger>> & finger_samples_1 =
+      context.grasp_samples[0]->sample_side_1->finger_samples;
+    const std::vector<std::shared_ptr<singleFinger>> & finger_samples_2 =
+      context.grasp_samples[0]->sample_side_2->finger_samples;
+    const size_t max_grasps = context.anytime ? context.max_grasps : 0;
+    const bool rank_bounded = this->grasp_quality_weight1 >= 0 &&
+      this->grasp_quality_weight2 >= 0;
+    // Min heap of the ranks of the best max_grasps configurations found so far
+    std::vector<float> best_ranks;
+    size_t num_ranked_grasps = 0;
+    context.exhaustive = true;
+    for (const auto & pair : getFingerPairs(context)) {
+      if (context.expired()) {
+        RCLCPP_WARN(LOGGER, "Grasp planning deadline reached, remaining samples skipped");
+        if (!context.anytime) {
+          return valid_open_gripper_configs;
+        }
+        context.exhaustive = false;
+        break;
+      }
+      if (max_grasps > 0 && best_ranks.size() == max_grasps) {
+        const bool bound_reached = rank_bounded && pair.rank_bound <= best_ranks.front();
+        if (bound_reached || num_ranked_grasps >= max_grasps) {
+          context.exhaustive = bound_reached;
+          break;
+        }
+      }
+      const std::shared_ptr<singleFinger> & finger_sample_1 = finger_samples_1[pair.index_1];
+      const std::shared_ptr<singleFinger> & finger_sample_2 = finger_samples_2[pair.index_2];
+      Eigen::Vector3f centerpoint_side1_vector =
+        PCLFunctions::convertPCLtoEigen(finger_sample_1->finger_point);
+      Eigen::Vector3f centerpoint_side2_vector =
+        PCLFunctions::convertPCLtoEigen(finger_sample_2->finger_point);
+
+      // Get the vector representing the grasping direction
+      Eigen::Vector3f grasp_direction = Eigen::ParametrizedLine<float, 3>::Through(
+        centerpoint_side1_vector, centerpoint_side2_vector).direction();
+
+      // Find the angle of the normal vector of each point with the grasp direction vector.
+      finger_sample_1->angle_cos = MathFunctions::getAngleBetweenVectors(
+        grasp_direction,
+        {finger_sample_1->finger_point.normal_x,
+          finger_sample_1->finger_point.normal_y,
+          finger_sample_1->finger_point.normal_z});
+
+      finger_sample_2->angle_cos = MathFunctions::getAngleBetweenVectors(
+        grasp_direction,
+        {finger_sample_2->finger_point.normal_x,
+          finger_sample_2->finger_point.normal_y,
+          finger_sample_2->finger_point.normal_z});
+
+      /* Get the vector perpendicular to the grasp direction. This vector will be used to generate
+       the other fingers with reference to the center finger. */
+
+      Eigen::Vector3f perpendicular_grasp_direction = getGripperPlane(
+        finger_sample_1,
+        finger_sample_2,
+        grasp_direction, object);
+
+      /* Get the coordinates of the open finger configuration of the center fingers of the
+         gripper */
+      std::vector<Eigen::Vector3f> open_coords = getOpenFingerCoordinates(
+        grasp_direction,
+        centerpoint_side1_vector,
+        centerpoint_side2_vector);
+
+      /* With the open configuration of the center fingers, generate the rest of the open
+         configuration grippers */
+      std::shared_ptr<multiFingerGripper> gripper_sample = generateGripperOpenConfig(
+        context, object, world_collision_object, finger_sample_1, finger_sample_2,
+        open_coords[0], open_coords[1], perpendicular_grasp_direction,
+        grasp_direction);
+      if (gripper_sample->collides_with_world) {
+        continue;
+      }
+      valid_open_gripper_configs.push_back(gripper_sample);
+      if (max_grasps > 0) {
+        getGripperRank(gripper_sample);
+        if (gripper_sample->rank >= context.min_rank) {
+          num_ranked_grasps++;
+        }
+        if (best_ranks.size() < max_grasps) {
+          best_ranks.push_back(gripper_sample->rank);
+          std::push_heap(best_ranks.begin(), best_ranks.end(), std::greater<float>());
+        } else if (gripper_sample->rank > best_ranks.front()) {
+          std::pop_heap(best_ranks.begin(), best_ranks.end(), std::greater<float>());
+          best_ranks.back() = gripper_sample->rank;
+          std::push_heap(best_ranks.begin(), best_ranks.end(), std::greater<float>());
         }
       }
     }
@@ -865,6 +1135,7 @@ std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getAllGripperCon
  * Function to create the finger gripper configuration.
  * Returns the created finger gripper sample. Finger sample is created using the center part of the
  * gripper and then based on the grasp direction the finger will be expanded outwards.
+ * @param object Object to be grasped
  * @param world_collision_object Collision object representing the world
  * @param closed_center_finger_1 Finger representation of the closed configuration for the center finger in side 1.
  * @param closed_center_finger_2 Finger representation of the closed configuration for the center finger in side 2.
@@ -873,22 +1144,23 @@ std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getAllGripperCon
  * @param plane_normal_normalized Normal vector of the center plane.
  ******************************************************************************/
 std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
+  const FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object,
   const std::shared_ptr<CollisionObject> & world_collision_object,
   const std::shared_ptr<singleFinger> & closed_center_finger_1,
   const std::shared_ptr<singleFinger> & closed_center_finger_2,
   const Eigen::Vector3f & open_center_finger_1,
   const Eigen::Vector3f & open_center_finger_2,
   const Eigen::Vector3f & plane_normal,
-  const Eigen::Vector3f & grasp_direction,
-  std::string camera_frame)
+  const Eigen::Vector3f & grasp_direction) const
 {
   // Create an instance of the multifinger gripper.
-  multiFingerGripper gripper(
+  std::shared_ptr<multiFingerGripper> gripper = std::make_shared<multiFingerGripper>(
     closed_center_finger_1,
     closed_center_finger_2,
     grasp_direction,
     plane_normal);
-  gripper.collides_with_world = false;
+  gripper->collides_with_world = false;
   bool is_even_1 = this->num_fingers_side_1 % 2 == 0;
   bool is_even_2 = this->num_fingers_side_2 % 2 == 0;
 
@@ -896,29 +1168,26 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
      plane */
 
   float grasp_plane_angle_cos_ = MathFunctions::getAngleBetweenVectors(
-    grasp_direction, this->center_cutting_plane_normal);
-  gripper.grasp_plane_angle_cos = grasp_plane_angle_cos_;
+    grasp_direction, context.center_cutting_plane_normal);
+  gripper->grasp_plane_angle_cos = grasp_plane_angle_cos_;
 
   /* Assuming the gripper is symmetrical, if a side as an odd number of fingers, the center finger
      of that side must correspond to the point on the center plane. Thus pushback the open finger
      position and closed finger position on the center plane */
 
   if (!is_even_1) {
-    gripper.closed_fingers_1.push_back(closed_center_finger_1);
-    gripper.open_fingers_1.push_back(open_center_finger_1);
+    gripper->closed_fingers_1.push_back(closed_center_finger_1);
+    gripper->open_fingers_1.push_back(open_center_finger_1);
   }
   if (!is_even_2) {
-    gripper.closed_fingers_2.push_back(closed_center_finger_2);
-    gripper.open_fingers_2.push_back(open_center_finger_2);
+    gripper->closed_fingers_2.push_back(closed_center_finger_2);
+    gripper->open_fingers_2.push_back(open_center_finger_2);
   }
 
-  // Check Initial middle fingers if they collide with world
-  if (checkFingerCollision(open_center_finger_1, world_collision_object)) {
-    gripper.collides_with_world = true;
-  }
-  if (checkFingerCollision(open_center_finger_2, world_collision_object)) {
-    gripper.collides_with_world = true;
-  }
+  /* Open fingers to check for collisions with the world, since the end effector will approach
+     the object in its open state. They are checked together once the gripper is complete */
+  std::vector<Eigen::Vector3f> open_finger_points{open_center_finger_1, open_center_finger_2};
+  open_finger_points.reserve(2 + this->num_itr_1 + this->num_itr_2);
 
   // Iterate through the points on side 1
   for (int side_1 = 0, updown_toggle_1 = 1; side_1 < this->num_itr_1;
@@ -934,21 +1203,15 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
       open_center_finger_1,
       plane_normal, gap1);
     // Eigen::Vector3f finger_1_open_temp = open_center_finger_1 + gap1 * plane_normal_normalized;
-    gripper.open_fingers_1.push_back(finger_1_open_temp);
-
-    /* Check if this current open configuration for the finger collides with the world,
-       since the end effector will approach the object in its open state.*/
-
-    if (checkFingerCollision(finger_1_open_temp, world_collision_object)) {
-      gripper.collides_with_world = true;
-    }
+    gripper->open_fingers_1.push_back(finger_1_open_temp);
+    open_finger_points.push_back(finger_1_open_temp);
 
     /* Ranking of grasp quality involves the positions of the gripper fingers ON the object,
        so we next need to find the finger point on the object corresponding to the current
        open configuration of the finger */
 
     // Find the index of the closest cutting plane with the given gap from the center finger
-    int plane_index = getNearestPlaneIndex(gap1);
+    int plane_index = getNearestPlaneIndex(context, gap1);
 
     // Now that we find the plane, we need to find the closest point to the corresponding
     // normal cloud of the object at the particular side
@@ -959,19 +1222,20 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
 
     int point_index = getNearestPointIndex(
       finger_1_point,
-      this->grasp_samples[plane_index]->sample_side_1->finger_nvoxel);
+      context.sample_cloud_indices.getSearch(
+        context.grasp_samples[plane_index]->sample_side_1->finger_nvoxel));
 
 
     // Add the finger sample to the gripper configuration
-    gripper.closed_fingers_1.push_back(
-      this->grasp_samples[plane_index]->sample_side_1->finger_samples[point_index]);
-    gripper.closed_fingers_1_index.push_back(point_index);
+    gripper->closed_fingers_1.push_back(
+      context.grasp_samples[plane_index]->sample_side_1->finger_samples[point_index]);
+    gripper->closed_fingers_1_index.push_back(point_index);
 
     Eigen::Vector3f finger_normal =
       PCLFunctions::convertPCLNormaltoEigen(
-      gripper.closed_fingers_1[gripper.closed_fingers_1.size() - 1]->finger_point);
+      gripper->closed_fingers_1[gripper->closed_fingers_1.size() - 1]->finger_point);
 
-    gripper.closed_fingers_1[gripper.closed_fingers_1.size() - 1]->angle_cos =
+    gripper->closed_fingers_1[gripper->closed_fingers_1.size() - 1]->angle_cos =
       MathFunctions::getAngleBetweenVectors(grasp_direction, finger_normal);
   }
 
@@ -985,12 +1249,10 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
     Eigen::Vector3f finger_2_open_temp = MathFunctions::getPointInDirection(
       open_center_finger_2,
       plane_normal, gap2);
-    if (checkFingerCollision(finger_2_open_temp, world_collision_object)) {
-      gripper.collides_with_world = true;
-    }
-    gripper.open_fingers_2.push_back(finger_2_open_temp);
+    gripper->open_fingers_2.push_back(finger_2_open_temp);
+    open_finger_points.push_back(finger_2_open_temp);
 
-    int plane_index_2 = getNearestPlaneIndex(gap2);
+    int plane_index_2 = getNearestPlaneIndex(context, gap2);
 
     pcl::PointNormal finger_2_point;
     finger_2_point.x = finger_2_open_temp(0);
@@ -999,11 +1261,12 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
 
     int point_index_2 = getNearestPointIndex(
       finger_2_point,
-      this->grasp_samples[plane_index_2]->sample_side_2->finger_nvoxel);
+      context.sample_cloud_indices.getSearch(
+        context.grasp_samples[plane_index_2]->sample_side_2->finger_nvoxel));
 
-    gripper.closed_fingers_2.push_back(
-      this->grasp_samples[plane_index_2]->sample_side_2->finger_samples[point_index_2]);
-    gripper.closed_fingers_2_index.push_back(point_index_2);
+    gripper->closed_fingers_2.push_back(
+      context.grasp_samples[plane_index_2]->sample_side_2->finger_samples[point_index_2]);
+    gripper->closed_fingers_2_index.push_back(point_index_2);
 
     // Eigen::Vector3f finger_normal_2(
     //   gripper.closed_fingers_2[gripper.closed_fingers_2.size() - 1]->finger_point.normal_x,
@@ -1012,43 +1275,23 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
 
     Eigen::Vector3f finger_normal_2 =
       PCLFunctions::convertPCLNormaltoEigen(
-      gripper.closed_fingers_2[gripper.closed_fingers_2.size() - 1]->finger_point);
+      gripper->closed_fingers_2[gripper->closed_fingers_2.size() - 1]->finger_point);
 
-    gripper.closed_fingers_2[gripper.closed_fingers_2.size() - 1]->angle_cos =
+    gripper->closed_fingers_2[gripper->closed_fingers_2.size() - 1]->angle_cos =
       MathFunctions::getAngleBetweenVectors(grasp_direction, finger_normal_2);
   }
 
-  // Setting up of marker members
-  gripper.marker.header.frame_id = camera_frame;
-  gripper.marker.ns = "";
-  gripper.marker.type = gripper.marker.SPHERE_LIST;
-  gripper.marker.action = gripper.marker.ADD;
-  gripper.marker.lifetime = rclcpp::Duration::from_seconds(20);
-  gripper.marker.scale.x = 0.02;
-  gripper.marker.scale.y = 0.02;
-  gripper.marker.scale.z = 0.02;
-  gripper.marker.color.r = 1.0f;
-  gripper.marker.color.a = 1.0;
-
-  // Setting coordinates of open fingers on side 1 configuration into marker
-  for (auto finger_1 : gripper.open_fingers_1) {
-    geometry_msgs::msg::Point cup_marker_point;
-    cup_marker_point.x = finger_1(0);
-    cup_marker_point.y = finger_1(1);
-    cup_marker_point.z = finger_1(2);
-    gripper.marker.points.push_back(cup_marker_point);
-  }
-
-  // Setting coordinates of open fingers on side 2 configuration into marker
-  for (auto finger_2 : gripper.open_fingers_2) {
-    geometry_msgs::msg::Point cup_marker_point;
-    cup_marker_point.x = finger_2(0);
-    cup_marker_point.y = finger_2(1);
-    cup_marker_point.z = finger_2(2);
-    gripper.marker.points.push_back(cup_marker_point);
+  gripper->collides_with_world = checkFingersCollision(
+    context, open_finger_points, world_collision_object);
+  if (context.world_distance_field && context.world_distance_field->hasDistanceField()) {
+    for (const auto & finger_point : open_finger_points) {
+      gripper->clearance = std::min(
+        gripper->clearance,
+        context.world_distance_field->clearance(finger_point) - this->finger_thickness / 2);
+    }
   }
 
-  return std::make_shared<multiFingerGripper>(gripper);
+  return gripper;
 }
 
 /***************************************************************************//**
@@ -1059,7 +1302,7 @@ std::shared_ptr<multiFingerGripper> FingerGripper::generateGripperOpenConfig(
  ******************************************************************************/
 bool FingerGripper::checkFingerCollision(
   const Eigen::Vector3f & finger_point,
-  const std::shared_ptr<CollisionObject> & world_collision_object)
+  const std::shared_ptr<CollisionObject> & world_collision_object) const
 {
   grasp_planner::collision::Sphere * finger_shape =
     new grasp_planner::collision::Sphere(this->finger_thickness / 2);
@@ -1093,6 +1336,45 @@ bool FingerGripper::checkFingerCollision(
   return result.isCollision();
 }
 
+/***************************************************************************//**
+ * Function to check the fingers of a gripper configuration for collisions with the world.
+ * Returns true if any finger collides. The fingers are looked up in the occupancy grid of
+ * the context if it has one, and collided with the FCL world object otherwise. When the
+ * context validates collisions both are checked, disagreements are reported and the FCL
+ * result is returned.
+ * @param context Planning context holding the occupancy grid
+ * @param finger_points Coordinates of the fingers
+ * @param world_collision_object Collision object representing the world
+ ******************************************************************************/
+bool FingerGripper::checkFingersCollision(
+  const FingerPlanningContext & context,
+  const std::vector<Eigen::Vector3f> & finger_points,
+  const std::shared_ptr<CollisionObject> & world_collision_object) const
+{
+  const float finger_radius = this->finger_thickness / 2;
+  if (context.world_grid && !context.validate_collisions) {
+    return context.world_grid->anySphereCollides(finger_points, finger_radius);
+  }
+
+  bool collides = false;
+  for (const auto & finger_point : finger_points) {
+    bool finger_collides = checkFingerCollision(finger_point, world_collision_object);
+    if (!context.world_grid) {
+      if (finger_collides) {
+        return true;
+      }
+    } else if (
+      context.world_grid->sphereCollides(finger_point, finger_radius) != finger_collides)
+    {
+      RCLCPP_WARN(
+        LOGGER, "Occupancy grid and FCL disagree on finger at (%f, %f, %f), FCL collision: %d",
+        finger_point(0), finger_point(1), finger_point(2), finger_collides);
+    }
+    collides = collides || finger_collides;
+  }
+  return collides;
+}
+
 
 /***************************************************************************//**
  * Function that gets the maximum and minimum values of certain grasp ranking attributes within
@@ -1100,14 +1382,16 @@ bool FingerGripper::checkFingerCollision(
  * compare between the 2 voxelized clouds in each plane
  * @param object Grasp object.
  ******************************************************************************/
-void FingerGripper::getMaxMinValues(const std::shared_ptr<GraspObject> & object)
+void FingerGripper::getMaxMinValues(
+  FingerPlanningContext & context,
+  const std::shared_ptr<GraspObject> & object) const
 {
   pcl::PointNormal centroid_point;
   centroid_point.x = object->centerpoint(0);
   centroid_point.y = object->centerpoint(1);
   centroid_point.z = object->centerpoint(2);
 
-  for (auto & sample : this->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     if (sample->plane_intersects_object) {
       for (auto & point : sample->sample_side_1->finger_nvoxel->points) {
         float centroid_distance, grasp_plane_distance, curvature;
@@ -1147,7 +1431,7 @@ void FingerGripper::updateMaxMinAttributes(
   std::shared_ptr<fingerCloudSample> & sample,
   const float & centroid_distance,
   const float & grasp_plane_distance,
-  const float & curvature)
+  const float & curvature) const
 {
   if (curvature < sample->curvature_min) {
     sample->curvature_min = curvature;
@@ -1170,52 +1454,81 @@ void FingerGripper::updateMaxMinAttributes(
 }
 
 /***************************************************************************//**
- * Function that gets the rank of each multiFingerGripper instance, and sort them into a vector
- * of decreasing rank. This function also populates the GraspMethod message which will be sent
- * To the grasp execution
+ * Function that gets the rank of each multiFingerGripper instance, and returns the best ranked
+ * ones in decreasing rank.
  * @param input_vector Unsorted vector of gripper instances
- * @param grasp_method GraspMethod output for grasp execution
+ * @param max_grasps Maximum number of grippers returned, 0 returns all of them
  ******************************************************************************/
-std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getAllRanks(
-  std::vector<std::shared_ptr<multiFingerGripper>> input_vector,
-  emd_msgs::msg::GraspMethod * grasp_method)
+std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getBestRanks(
+  const std::vector<std::shared_ptr<multiFingerGripper>> & input_vector,
+  const size_t & max_grasps) const
 {
+  std::vector<float> ranks;
+  ranks.reserve(input_vector.size());
+  for (auto & gripper : input_vector) {
+    getGripperRank(gripper);
+    ranks.push_back(gripper->rank);
+  }
   std::vector<std::shared_ptr<multiFingerGripper>> sorted_gripper_ranks;
-  for (auto gripper : input_vector) {
+  for (const size_t & index : MathFunctions::getTopRankIndices(ranks, max_grasps)) {
+    sorted_gripper_ranks.push_back(input_vector[index]);
+  }
+  return sorted_gripper_ranks;
+}
+
+/***************************************************************************//**
+ * Function that populates the GraspMethod message which will be sent To the grasp execution
+ * with ranked grippers, after any grasps it already holds. The grippers need their pose and
+ * marker set.
+ * @param sorted_grippers Gripper instances in decreasing rank
+ * @param grasp_method GraspMethod output for grasp execution
+ ******************************************************************************/
+void FingerGripper::fillGraspMethod(
+  const std::vector<std::shared_ptr<multiFingerGripper>> & sorted_grippers,
+  emd_msgs::msg::GraspMethod * grasp_method) const
+{
+  grasp_method->grasp_ranks.reserve(grasp_method->grasp_ranks.size() + sorted_grippers.size());
+  grasp_method->grasp_poses.reserve(grasp_method->grasp_poses.size() + sorted_grippers.size());
+  grasp_method->grasp_markers.reserve(
+    grasp_method->grasp_markers.size() + sorted_grippers.size());
+  grasp_method->grasp_options.reserve(
+    grasp_method->grasp_options.size() + sorted_grippers.size());
+  for (const auto & gripper : sorted_grippers) {
     emd_msgs::msg::OptionArray grasp_option;
     grasp_option.options.push_back(addClosedGraspDistanceOption(gripper));
-    getGripperRank(gripper);
-    std::vector<geometry_msgs::msg::PoseStamped>::iterator grasps_it;
-    std::vector<std::shared_ptr<multiFingerGripper>>::iterator contacts_it;
-    std::vector<visualization_msgs::msg::Marker>::iterator markers_it;
-    std::vector<emd_msgs::msg::OptionArray>::iterator options_it;
-    size_t rank;
-    for (rank = 0,
-      grasps_it = grasp_method->grasp_poses.begin(), contacts_it = sorted_gripper_ranks.begin(),
-      markers_it = grasp_method->grasp_markers.begin(),
-      options_it = grasp_method->grasp_options.begin();
-      rank < grasp_method->grasp_ranks.size();
-      ++rank, ++grasps_it, ++contacts_it, ++markers_it, ++options_it)
-    {
-      if (gripper->rank > grasp_method->grasp_ranks[rank]) {
-        grasp_method->grasp_ranks.insert(grasp_method->grasp_ranks.begin() + rank, gripper->rank);
-        grasp_method->grasp_poses.insert(grasps_it, gripper->pose);
-        grasp_method->grasp_markers.insert(markers_it, gripper->marker);
-        grasp_method->grasp_options.insert(options_it, grasp_option);
-        sorted_gripper_ranks.insert(contacts_it, gripper);
-        break;
-      }
-    }
+    grasp_method->grasp_ranks.push_back(gripper->rank);
+    grasp_method->grasp_poses.push_back(gripper->pose);
+    grasp_method->grasp_markers.push_back(gripper->marker);
+    grasp_method->grasp_options.push_back(std::move(grasp_option));
   }
+}
+
+/***************************************************************************//**
+ * Function that gets the rank of each multiFingerGripper instance, and sort them into a vector
+ * of decreasing rank. This function also populates the GraspMethod message which will be sent
+ * To the grasp execution with the best ranked grippers
+ * @param input_vector Unsorted vector of gripper instances
+ * @param grasp_method GraspMethod output for grasp execution
+ * @param max_grasps Maximum number of grippers returned, 0 returns all of them
+ ******************************************************************************/
+std::vector<std::shared_ptr<multiFingerGripper>> FingerGripper::getAllRanks(
+  const std::vector<std::shared_ptr<multiFingerGripper>> & input_vector,
+  emd_msgs::msg::GraspMethod * grasp_method,
+  const size_t & max_grasps) const
+{
+  std::vector<std::shared_ptr<multiFingerGripper>> sorted_gripper_ranks =
+    getBestRanks(input_vector, max_grasps);
+  fillGraspMethod(sorted_gripper_ranks, grasp_method);
   return sorted_gripper_ranks;
 }
 
 /***************************************************************************//**
  * Get the current rank of a multifinger gripper. This is an extension of the implementation
- * by the research paper.
+ * by the research paper. The clearance of the open fingers adds to the rank in units of finger
+ * thickness, up to one finger thickness.
  * @param gripper Target gripper
  ******************************************************************************/
-void FingerGripper::getGripperRank(std::shared_ptr<multiFingerGripper> gripper)
+void FingerGripper::getGripperRank(std::shared_ptr<multiFingerGripper> gripper) const
 {
   float curvature_sum = 0;
   float grasp_plane_dist_sum = 0;
@@ -1238,6 +1551,10 @@ void FingerGripper::getGripperRank(std::shared_ptr<multiFingerGripper> gripper)
   float rank_2 = (gripper->closed_fingers_1.size() + gripper->closed_fingers_2.size()) -
     curvature_sum;
   gripper->rank = this->grasp_quality_weight1 * rank_1 + this->grasp_quality_weight2 * rank_2;
+  if (this->grasp_clearance_weight > 0) {
+    gripper->rank += this->grasp_clearance_weight *
+      std::min(std::max(gripper->clearance / this->finger_thickness, 0.0f), 1.0f);
+  }
 }
 
 /***************************************************************************//**
@@ -1251,7 +1568,7 @@ void FingerGripper::getGripperRank(std::shared_ptr<multiFingerGripper> gripper)
 
 std::vector<double> FingerGripper::getPlanarRPY(
   const Eigen::Vector3f & grasp_direction,
-  const Eigen::Vector3f & grasp_direction_normal)
+  const Eigen::Vector3f & grasp_direction_normal) const
 {
   std::vector<double> output_vec;
   Eigen::Vector3f x_norm;
@@ -1341,7 +1658,7 @@ std::vector<double> FingerGripper::getPlanarRPY(
  ******************************************************************************/
 void FingerGripper::getGraspPose(
   std::shared_ptr<multiFingerGripper> gripper,
-  const std::shared_ptr<GraspObject> & object)
+  const std::shared_ptr<GraspObject> & object) const
 {
   geometry_msgs::msg::PoseStamped result_pose;
   result_pose.pose.position.x = gripper->gripper_palm_center.x;
@@ -1367,6 +1684,47 @@ void FingerGripper::getGraspPose(
   gripper->pose = result_pose;
 }
 
+/***************************************************************************//**
+ * Function that sets the marker of the open finger configuration of a gripper. Markers are only
+ * made for the grippers that are returned.
+ * @param gripper Target gripper
+ * @param camera_frame Frame of the marker
+ ******************************************************************************/
+void FingerGripper::getGraspMarker(
+  std::shared_ptr<multiFingerGripper> gripper,
+  const std::string & camera_frame) const
+{
+  // Setting up of marker members
+  gripper->marker.header.frame_id = camera_frame;
+  gripper->marker.ns = "";
+  gripper->marker.type = gripper->marker.SPHERE_LIST;
+  gripper->marker.action = gripper->marker.ADD;
+  gripper->marker.lifetime = rclcpp::Duration::from_seconds(20);
+  gripper->marker.scale.x = 0.02;
+  gripper->marker.scale.y = 0.02;
+  gripper->marker.scale.z = 0.02;
+  gripper->marker.color.r = 1.0f;
+  gripper->marker.color.a = 1.0;
+
+  // Setting coordinates of open fingers on side 1 configuration into marker
+  for (auto finger_1 : gripper->open_fingers_1) {
+    geometry_msgs::msg::Point cup_marker_point;
+    cup_marker_point.x = finger_1(0);
+    cup_marker_point.y = finger_1(1);
+    cup_marker_point.z = finger_1(2);
+    gripper->marker.points.push_back(cup_marker_point);
+  }
+
+  // Setting coordinates of open fingers on side 2 configuration into marker
+  for (auto finger_2 : gripper->open_fingers_2) {
+    geometry_msgs::msg::Point cup_marker_point;
+    cup_marker_point.x = finger_2(0);
+    cup_marker_point.y = finger_2(1);
+    cup_marker_point.z = finger_2(2);
+    gripper->marker.points.push_back(cup_marker_point);
+  }
+}
+
 /***************************************************************************//**
  * Get a vector that is perpendicular to another vector that is on the same plane
  * Equations below is a culmination of simultaneous equations
@@ -1375,7 +1733,7 @@ void FingerGripper::getGraspPose(
  ******************************************************************************/
 Eigen::Vector3f FingerGripper::getPerpendicularVectorInPlane(
   Eigen::Vector3f target_vector,
-  pcl::ModelCoefficients::Ptr plane)
+  pcl::ModelCoefficients::Ptr plane) const
 {
   Eigen::Vector3f plane_normal_vector(plane->values[0], plane->values[1], plane->values[2]);
   return target_vector.cross(plane_normal_vector);
@@ -1393,7 +1751,7 @@ Eigen::Vector3f FingerGripper::getPerpendicularVectorInPlane(
 std::vector<Eigen::Vector3f> FingerGripper::getOpenFingerCoordinates(
   const Eigen::Vector3f & grasp_direction,
   const Eigen::Vector3f & finger_1,
-  const Eigen::Vector3f & finger_2)
+  const Eigen::Vector3f & finger_2) const
 {
   // Get the centerpoint vector of the grasp
   Eigen::Vector3f side1_2_centerpoint_vector(
@@ -1412,22 +1770,18 @@ std::vector<Eigen::Vector3f> FingerGripper::getOpenFingerCoordinates(
   std::vector<Eigen::Vector3f> result{open_center_finger_1, open_center_finger_2};
   return result;
 }
-/***************************************************************************//**
- * Method to reset gripper variables (Not used)
- ******************************************************************************/
-void FingerGripper::resetVariables()
-{
-}
-
 // LCOV_EXCL_START
 /***************************************************************************//**
- * Inherited method that visualizes the required grasps
+ * Method that visualizes the grasps planned with a context
  *
  * @param viewer Projected Cloud Visualizer
+ * @param object Grasp Object
+ * @param context Planning context the grasps of the object were planned with
  ******************************************************************************/
 void FingerGripper::visualizeGrasps(
   pcl::visualization::PCLVisualizer::Ptr viewer,
-  std::shared_ptr<GraspObject> object)
+  std::shared_ptr<GraspObject> object,
+  const FingerPlanningContext & context) const
 {
   PCLVisualizer::centerCamera(object->cloud, viewer);
   pcl::visualization::PointCloudColorHandlerCustom<pcl::PointXYZRGB> rgb2(object->cloud, 255, 0,
@@ -1435,7 +1789,7 @@ void FingerGripper::visualizeGrasps(
 
   viewer->addPointCloud<pcl::PointXYZRGB>(object->cloud, rgb2, "cloud_" + object->object_name);
 
-  for (auto const & multigripper : this->sorted_gripper_configs) {
+  for (auto const & multigripper : context.sorted_gripper_configs) {
     //Testing
     pcl::PointXYZ grasp_direction;
     grasp_direction.x = multigripper->grasping_direction(0) + multigripper->gripper_palm_center.x;
@@ -1501,19 +1855,19 @@ void FingerGripper::visualizeGrasps(
       object->maxPoint.z - object->minPoint.z, "bbox_" + object->object_name);
 
 
-    for (size_t i = 0; i < this->grasp_samples.size(); i++) {
+    for (size_t i = 0; i < context.grasp_samples.size(); i++) {
       viewer->addSphere(
-        this->grasp_samples[i]->grasp_plane_ncloud->points[
-          this->grasp_samples[i]->sample_side_1->start_index],
+        context.grasp_samples[i]->grasp_plane_ncloud->points[
+          context.grasp_samples[i]->sample_side_1->start_index],
         0.01, 1.0, 0, 1.0, "sample_side_1 " + std::to_string(i));
 
       viewer->addSphere(
-        this->grasp_samples[i]->grasp_plane_ncloud->points[
-          this->grasp_samples[i]->sample_side_2->start_index],
+        context.grasp_samples[i]->grasp_plane_ncloud->points[
+          context.grasp_samples[i]->sample_side_2->start_index],
         0.01, 1.0, 0, 1.0, "sample_side_2 " + std::to_string(i));
 
-        auto pos = this->grasp_samples[i]->grasp_plane_ncloud->points[
-          this->grasp_samples[i]->sample_side_1->start_index];
+        auto pos = context.grasp_samples[i]->grasp_plane_ncloud->points[
+          context.grasp_samples[i]->sample_side_1->start_index];
     }
 
     viewer->spin();
@@ -1537,7 +1891,7 @@ std::shared_ptr<graspPlaneSample> FingerGripper::generateGraspSamples(
   Eigen::Vector4f plane_vector,
   Eigen::Vector3f point_on_plane,
   float dist_to_center_plane,
-  int plane_index)
+  int plane_index) const
 {
   graspPlaneSample grasp_sample;
   grasp_sample.plane_index = plane_index;
@@ -1558,7 +1912,9 @@ std::shared_ptr<graspPlaneSample> FingerGripper::generateGraspSamples(
  * @param target_distance Distance target plane is from the center plane
  ******************************************************************************/
 
-int FingerGripper::getNearestPlaneIndex(float target_distance)
+int FingerGripper::getNearestPlaneIndex(
+  const FingerPlanningContext & context,
+  float target_distance) const
 {
   float plane_dist_diff = std::numeric_limits<float>::max();
   int plane_index;
@@ -1567,11 +1923,13 @@ int FingerGripper::getNearestPlaneIndex(float target_distance)
       gaps to find the most identical distance between the center plane to that plane, and
       that will be the plane index that corresponds to the correct plane */
 
-  for (size_t plane_index_ = 0; plane_index_ < this->cutting_plane_distances.size();
+  for (size_t plane_index_ = 0; plane_index_ < context.cutting_plane_distances.size();
     plane_index_++)
   {
-    if (std::abs(this->cutting_plane_distances[plane_index_] - target_distance) < plane_dist_diff) {
-      plane_dist_diff = std::abs(cutting_plane_distances[plane_index_] - target_distance);
+    if (std::abs(context.cutting_plane_distances[plane_index_] - target_distance) <
+      plane_dist_diff)
+    {
+      plane_dist_diff = std::abs(context.cutting_plane_distances[plane_index_] - target_distance);
       plane_index = plane_index_;
     }
   }
@@ -1586,18 +1944,30 @@ int FingerGripper::getNearestPlaneIndex(float target_distance)
  ******************************************************************************/
 int FingerGripper::getNearestPointIndex(
   const pcl::PointNormal & target_point,
-  const pcl::PointCloud<pcl::PointNormal>::Ptr cloud)
+  const pcl::PointCloud<pcl::PointNormal>::Ptr cloud) const
+{
+  pcl::search::KdTree<pcl::PointNormal>::Ptr search(new pcl::search::KdTree<pcl::PointNormal>());
+  search->setInputCloud(cloud);
+  return getNearestPointIndex(target_point, search);
+}
+
+/***************************************************************************//**
+ * Finds the index of the point nearest to a target point, using an existing search
+ * tree such as the shared tree of a sample cloud from the grasp object.
+ * @param target_point target point of reference
+ * @param search search tree over the cloud to search
+ ******************************************************************************/
+int FingerGripper::getNearestPointIndex(
+  const pcl::PointNormal & target_point,
+  const pcl::search::KdTree<pcl::PointNormal>::Ptr & search) const
 {
-  pcl::KdTreeFLANN<pcl::PointNormal> kdtree;
   // We only need to find 1 neighbour. can be changed later
   int K = 1;
   std::vector<int> pointIdxNKNSearch(K);
   std::vector<float> pointNKNSquaredDistance(K);
 
   // We already have a set of voxelized points on the correspoinding side, and correspoinding plane.
-  kdtree.setInputCloud(cloud);
-
-  if (kdtree.nearestKSearch(target_point, K, pointIdxNKNSearch, pointNKNSquaredDistance) > 0) {
+  if (search->nearestKSearch(target_point, K, pointIdxNKNSearch, pointNKNSquaredDistance) > 0) {
     return pointIdxNKNSearch[0];
   } else {
     return -1;
@@ -1612,10 +1982,10 @@ int FingerGripper::getNearestPointIndex(
  * @param object Grasp object
  ******************************************************************************/
 Eigen::Vector3f FingerGripper::getGripperPlane(
-  std::shared_ptr<singleFinger> & finger_sample_1,
-  std::shared_ptr<singleFinger> & finger_sample_2,
+  const std::shared_ptr<singleFinger> & finger_sample_1,
+  const std::shared_ptr<singleFinger> & finger_sample_2,
   const Eigen::Vector3f & grasp_direction,
-  const std::shared_ptr<GraspObject> & object)
+  const std::shared_ptr<GraspObject> & object) const
 {
   Eigen::Vector3f centerpoint(
     object->centerpoint(0),
@@ -1650,7 +2020,7 @@ Eigen::Vector3f FingerGripper::getGripperPlane(
  * @param gripper Finger gripper sample
  ******************************************************************************/
 emd_msgs::msg::Option FingerGripper::addClosedGraspDistanceOption(
-  std::shared_ptr<multiFingerGripper> gripper)
+  std::shared_ptr<multiFingerGripper> gripper) const
 {
   emd_msgs::msg::Option closed_grasp_option;
   closed_grasp_option.header = "closed finger distance";
@@ -38,6 +38,8 @@ static const rclcpp::Logger & LOGGER = rclcpp::get_logger("EMD::SuctionGripper")
  * @param length_direction_ Axis in the direction of the length vector
  * @param breadth_direction_ Axis in the direction of the breadth vector
  * @param grasp_approach_direction_ Axis in which the gripper approaches the object
+ * @param clearance_weight_ Weights for the clearance of the cups from the world
+ * @param contact_raster_resolution_ Cell size of the contact raster, 0 counts contacts on points
  ***********************************************************************************/
 
 SuctionGripper::SuctionGripper(
@@ -57,7 +59,9 @@ SuctionGripper::SuctionGripper(
   const float & num_contact_points_weight_,
   std::string length_direction_,
   std::string breadth_direction_,
-  std::string grasp_approach_direction_)
+  std::string grasp_approach_direction_,
+  const float & clearance_weight_,
+  const float & contact_raster_resolution_)
 : id(id_),
   num_cups_length(num_cups_length_),
   num_cups_breadth(num_cups_breadth_),
@@ -72,6 +76,8 @@ SuctionGripper::SuctionGripper(
   curvature_weight(curvature_weight_),
   grasp_center_distance_weight(grasp_center_distance_weight_),
   num_contact_points_weight(num_contact_points_weight_),
+  clearance_weight(clearance_weight_),
+  contact_raster_resolution(contact_raster_resolution_),
   length_direction(length_direction_[0]),
   breadth_direction(breadth_direction_[0]),
   grasp_approach_direction(grasp_approach_direction_[0])
@@ -111,10 +117,16 @@ SuctionGripper::SuctionGripper(
     RCLCPP_ERROR(LOGGER, "search_angle_resolution_ variable needs to be positive and non-zero");
     throw std::invalid_argument("Invalid value for field.");
   }
+
+  if (contact_raster_resolution_ < 0) {
+    RCLCPP_ERROR(LOGGER, "contact_raster_resolution variable cannot be negative");
+    throw std::invalid_argument("Invalid value for field.");
+  }
   if (
     curvature_weight_ > 1.0 || curvature_weight_ < 0.0 ||
     grasp_center_distance_weight_ > 1.0 || grasp_center_distance_weight_ < 0.0 ||
-    num_contact_points_weight_ > 1.0 || num_contact_points_weight_ < 0.0)
+    num_contact_points_weight_ > 1.0 || num_contact_points_weight_ < 0.0 ||
+    clearance_weight_ > 1.0 || clearance_weight_ < 0.0)
   {
     RCLCPP_ERROR(LOGGER, "All Weights need to be a positive value less than 1");
     throw std::invalid_argument("Invalid value for field.");
@@ -174,7 +186,8 @@ void SuctionGripper::generateGripperAttributes()
   }
 }
 /***************************************************************************//**
- * Inherited method that plans the required grasps
+ * Inherited method that plans the required grasps. Grasp samples generated before the deadline
+ * are ranked, and exhaustive is cleared if the deadline cut sample generation short.
  *
  * @param object Grasp Object
  * @param grasp_method Grasp method output for all possible grasps
@@ -189,6 +202,7 @@ void SuctionGripper::planGrasps(
 {
   // RCLCPP_INFO(LOGGER, "Generate Gripper Attributes");
   generateGripperAttributes();
+  this->exhaustive = true;
   UNUSED(world_collision_object);
   pcl::PointXYZ object_center;
   object_center.x = object->centerpoint(0);
@@ -206,7 +220,11 @@ void SuctionGripper::planGrasps(
 }
 
 /***************************************************************************//**
- * Inherited method that gets all possible grasp samples
+ * Inherited method that gets all possible grasp samples. Each slice of the object is searched
+ * on the thread pool and generates its samples into a buffer of its own, and the buffers are
+ * merged once all slices are done. The object points are sorted by height and projected once,
+ * every slice is then the first points of the sorted clouds, which are searched in place.
+ * With a contact raster resolution, each slice is rasterised before its samples are generated.
  *
  * @param object Grasp Object
  * @param object_center PCL centroid point of the object
@@ -226,30 +244,32 @@ void SuctionGripper::getAllPossibleGrasps(
     const std::shared_ptr<GraspObject> & object,
     const pcl::PointXYZ & object_center,
     std::string camera_frame,
-    pcl::ModelCoefficients::Ptr & plane
+    const std::vector<float> & sorted_heights,
+    const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & sorted_projected_cloud,
+    const pcl::PointCloud<pcl::PointNormal>::Ptr & sorted_cloud_normal,
+    suctionSampleBuffer & buffer
     ) -> void
     {
-      pcl::PointCloud<pcl::PointXYZRGB>::Ptr sliced_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
-      pcl::PointCloud<pcl::PointXYZRGB>::Ptr projected_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
-      pcl::PointCloud<pcl::PointNormal>::Ptr sliced_cloud_normal(
-        new pcl::PointCloud<pcl::PointNormal>);
-      std::vector<std::future<void>> futures_2;
-
       slice_limit = slice_limit + 0.001 * i;  // How far down to slice the object cloud
 
       /*! \brief A sliced cloud is created to account for noise,
-      so we take a range of z values and assume them to be in the same height*/
-      // RCLCPP_INFO(LOGGER, "Slice pointcloud");
-      getSlicedCloud(
-        object->cloud, object->cloud_normal, slice_limit, 0, sliced_cloud,
-        sliced_cloud_normal, 'z');
-      /*! \brief We then make them part of the same plane throguh projection*/
-      // RCLCPP_INFO(LOGGER, "Project Sliced pointcloud to a plane");
-      projectCloudToPlane(sliced_cloud, plane, projected_cloud);
+      so we take a range of z values and assume them to be in the same height.
+      The points are sorted by height, so the slice is the first slice_size points of the
+      sorted clouds, which were already made part of the same plane through projection*/
+      const std::size_t slice_size = std::upper_bound(
+        sorted_heights.begin(), sorted_heights.end(), slice_limit) - sorted_heights.begin();
+      // Rasterise the slice once, every cup of every sample is then a single lookup
+      std::shared_ptr<const grasp_planner::ContactRaster> contact_raster;
+      if (this->contact_raster_resolution > 0) {
+        contact_raster = getContactRaster(sorted_projected_cloud, sorted_cloud_normal, slice_size);
+      }
       /*! \brief Get the center index of the sliced cloud,
       which may not necessarily be the center of the object cloud*/
       // RCLCPP_INFO(LOGGER, "Get the centroid of the projected point cloud");
-      int centroid_index = getCentroidIndex(projected_cloud);
+      int centroid_index = getCentroidIndex(sorted_projected_cloud, slice_size);
+      if (centroid_index < 0) {
+        return;  // No points in the slice
+      }
       // RCLCPP_INFO(LOGGER, "Generate grasp samples");
 
       // Iterate at different angles to search for best possible grasp
@@ -267,7 +287,7 @@ void SuctionGripper::getAllPossibleGrasps(
           pcl::PointXYZ sample_gripper_center = getGripperCenter(
             object->axis,
             offset,
-            projected_cloud->points[centroid_index]);
+            sorted_projected_cloud->points[centroid_index]);
 
           Eigen::Vector3f grasp_direction = MathFunctions::getRotatedVector(
             object->grasp_axis,
@@ -277,24 +297,24 @@ void SuctionGripper::getAllPossibleGrasps(
             object->axis,
             PI / angle, 'z');
 
-          static std::mutex mutex_2;
-          std::lock_guard<std::mutex> lock(mutex_2);
+          if (std::chrono::steady_clock::now() > this->deadline) {
+            buffer.exhaustive = false;
+            return;
+          }
           // RCLCPP_INFO(LOGGER, "Generate grasp samples");
           suctionCupArray grasp_sample = generateGraspSample(
-            projected_cloud,
-            sliced_cloud_normal,
+            sorted_projected_cloud,
+            sorted_cloud_normal,
             sample_gripper_center,
             object_center,
             grasp_direction,
             object_direction,
             object_max_dim,
-            camera_frame);
+            camera_frame,
+            contact_raster,
+            slice_size);
 
-          updateMaxMinValues(
-            grasp_sample.total_contact_points, grasp_sample.average_curvature,
-            grasp_sample.center_dist);
-
-          this->cup_array_samples.push_back(std::make_shared<suctionCupArray>(grasp_sample));
+          buffer.add(std::make_shared<suctionCupArray>(grasp_sample));
         }
       }
     };
@@ -316,26 +336,29 @@ void SuctionGripper::getAllPossibleGrasps(
   //   slice_limit = top_point.x;
   // }
 
-  std::vector<std::future<void>> futures_1;
-
-  for (int i = 0; i < static_cast<int>(round(this->cup_height / 0.001)); i++) {
-
-    // Start async
-    futures_1.push_back(
-      std::async(
-        std::launch::async,
-        GetBestGrasps1,
-        i,
-        slice_limit,
-        std::ref(object),
-        std::ref(object_center),
-        std::ref(camera_frame),
-        std::ref(plane)
-    ));
-
-    // Non Async version
-    // GetBestGrasps1(i, slice_limit, std::ref(object), std::ref(object_center), std::ref(plane));
-  }
+  // Points above the bottom limit of the slices, sorted by height and projected once
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr sorted_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PointCloud<pcl::PointNormal>::Ptr sorted_cloud_normal(
+    new pcl::PointCloud<pcl::PointNormal>);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr sorted_projected_cloud(
+    new pcl::PointCloud<pcl::PointXYZRGB>);
+  const std::vector<float> sorted_heights = getHeightSortedCloud(
+    object->cloud, object->cloud_normal, 0, sorted_cloud, sorted_cloud_normal, 'z');
+  projectCloudToPlane(sorted_cloud, plane, sorted_projected_cloud);
+
+  // One slice per millimetre of cup height
+  std::vector<suctionSampleBuffer> buffers(
+    std::max(static_cast<int>(round(this->cup_height / 0.001)), 0));
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, buffers.size(),
+    [&GetBestGrasps1, &slice_limit, &object, &object_center, &camera_frame, &sorted_heights,
+    &sorted_projected_cloud, &sorted_cloud_normal, &buffers](std::size_t i)
+    {
+      GetBestGrasps1(
+        static_cast<int>(i), slice_limit, object, object_center, camera_frame, sorted_heights,
+        sorted_projected_cloud, sorted_cloud_normal, buffers[i]);
+    });
+  mergeSampleBuffers(buffers);
 }
 
 // LCOV_EXCL_START
@@ -385,29 +408,41 @@ void SuctionGripper::visualizeGrasps(
 // LCOV_EXCL_STOP
 
 /***************************************************************************//**
- * Method that gets the index of the centroid of the projected cloud
+ * Method that gets the index of the centroid of the projected cloud. The projected
+ * cloud is queried only once, so a linear scan is used instead of building a search tree.
  *
  * @param cloud Projected Cloud
+ * @param num_points Number of leading points of the cloud to search, all points by default
  ******************************************************************************/
 int SuctionGripper::getCentroidIndex(
-  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud)
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & cloud,
+  const std::size_t & num_points)
 {
-  Eigen::Vector4f centroid;
-  pcl::KdTreeFLANN<pcl::PointXYZRGB> kdtree;
-  std::vector<int> kd_radius_search;
-  std::vector<float> kd_sq_dist;
-  pcl::compute3DCentroid(*(cloud), centroid);
-  kdtree.setInputCloud(cloud);
-  pcl::PointXYZRGB centroid_point;
-  centroid_point.x = centroid(0);
-  centroid_point.y = centroid(1);
-  centroid_point.z = centroid(2);
-
-  if (kdtree.nearestKSearch(centroid_point, 1, kd_radius_search, kd_sq_dist) > 0) {
-    return kd_radius_search[0];
-  } else {
+  const std::size_t size = std::min(num_points, cloud->points.size());
+  Eigen::Vector3f centroid = Eigen::Vector3f::Zero();
+  std::size_t num_finite = 0;
+  for (size_t i = 0; i < size; i++) {
+    if (pcl::isFinite(cloud->points[i])) {
+      centroid += cloud->points[i].getVector3fMap();
+      num_finite++;
+    }
+  }
+  if (num_finite == 0) {
     return -1;
   }
+  centroid /= static_cast<float>(num_finite);
+
+  int centroid_index = -1;
+  float min_sq_dist = std::numeric_limits<float>::max();
+  for (size_t i = 0; i < size; i++) {
+    const pcl::PointXYZRGB & point = cloud->points[i];
+    float sq_dist = (point.getVector3fMap() - centroid).squaredNorm();
+    if (sq_dist < min_sq_dist) {
+      min_sq_dist = sq_dist;
+      centroid_index = static_cast<int>(i);
+    }
+  }
+  return centroid_index;
 }
 
 /***************************************************************************//**
@@ -578,6 +613,55 @@ void SuctionGripper::getSlicedCloud(
   }
 }
 
+/***************************************************************************//**
+ * Function that sorts the points of a cloud above a limit by increasing height, so that
+ * slicing the cloud to any top limit keeps a prefix of the sorted points. Points at the same
+ * height keep their order. Returns the height of each sorted point.
+ *
+ * @param input_cloud Input cloud to be sorted
+ * @param input_cloud_normal Normals of the input cloud, in the same order
+ * @param bottom_limit Height below which points are dropped
+ * @param sorted_cloud Resultant sorted cloud
+ * @param sorted_cloud_normal Resultant sorted cloud normal
+ * @param height_axis Current axis on which the height axis represents(WIP)
+ ******************************************************************************/
+
+std::vector<float> SuctionGripper::getHeightSortedCloud(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & input_cloud_normal,
+  const float & bottom_limit,
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr sorted_cloud,
+  pcl::PointCloud<pcl::PointNormal>::Ptr sorted_cloud_normal,
+  const char & height_axis)
+{
+  const int axis = (height_axis == 'x' ? 0 : (height_axis == 'y' ? 1 : 2));
+  const std::size_t num_points =
+    std::min(input_cloud->points.size(), input_cloud_normal->points.size());
+  std::vector<float> heights(num_points);
+  std::vector<int> indices;
+  indices.reserve(num_points);
+  for (std::size_t i = 0; i < num_points; i++) {
+    heights[i] = input_cloud->points[i].getVector3fMap()(axis);
+    // Heights that are not a number are dropped, as by a passthrough filter
+    if (heights[i] >= bottom_limit) {
+      indices.push_back(static_cast<int>(i));
+    }
+  }
+  std::stable_sort(
+    indices.begin(), indices.end(), [&heights](const int & a, const int & b) {
+      return heights[a] < heights[b];
+    });
+  pcl::copyPointCloud(*input_cloud, indices, *sorted_cloud);
+  pcl::copyPointCloud(*input_cloud_normal, indices, *sorted_cloud_normal);
+
+  std::vector<float> sorted_heights;
+  sorted_heights.reserve(indices.size());
+  for (const int & index : indices) {
+    sorted_heights.push_back(heights[index]);
+  }
+  return sorted_heights;
+}
+
 /***************************************************************************//**
  * Function that projects a cloud to the required plane. This function is used
  * to approximate a relatively flat point cloud onto a plane to start grasp sampling
@@ -603,12 +687,14 @@ int SuctionGripper::getContactPoints(
   const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & input_cloud,
   const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
   const pcl::PointXYZ & centerpoint,
-  float & curvature_sum)
+  float & curvature_sum,
+  const std::size_t & num_points)
 {
   //pcl::PointCloud<pcl::PointXYZ>::Ptr disk_cloud(new pcl::PointCloud<pcl::PointXYZ>);
   // std::vector<int> points_inside;
   int num_contact_points = 0;
-  for (int i = 0; i < static_cast<int>(input_cloud->points.size()); i++) {
+  const int size = static_cast<int>(std::min(num_points, input_cloud->points.size()));
+  for (int i = 0; i < size; i++) {
     // Using circle equation, determine if current cloud point is in contact with the suction cup
     float inside_cup = pow((input_cloud->points[i].x - centerpoint.x), 2) +
       pow((input_cloud->points[i].y - centerpoint.y), 2) - pow(this->cup_radius, 2);
@@ -620,6 +706,38 @@ int SuctionGripper::getContactPoints(
   return num_contact_points;
 }
 
+/***************************************************************************//**
+ * Function that rasterises a projected slice for contact counting. Cup contacts are
+ * counted in the x-y plane, as in getContactPoints, on cells of the contact raster
+ * resolution. Returns null if the slice is too large to rasterise, in which case the
+ * contacts are counted on the points.
+ *
+ * @param projected_cloud Projected cloud slice on a plane
+ * @param sliced_cloud_normal Normals of the sliced cloud
+ * @param num_points Number of leading points of the clouds in the slice, all points by default
+ ******************************************************************************/
+std::shared_ptr<const grasp_planner::ContactRaster> SuctionGripper::getContactRaster(
+  const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & projected_cloud,
+  const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
+  const std::size_t & num_points)
+{
+  const std::size_t size = std::min(num_points, projected_cloud->points.size());
+  std::vector<Eigen::Vector2f> points(size);
+  std::vector<float> curvatures(size);
+  for (std::size_t i = 0; i < size; i++) {
+    points[i] = Eigen::Vector2f(projected_cloud->points[i].x, projected_cloud->points[i].y);
+    curvatures[i] = sliced_cloud_normal->points[i].curvature;
+  }
+  auto contact_raster = std::make_shared<grasp_planner::ContactRaster>();
+  if (!contact_raster->build(
+      points, curvatures, this->contact_raster_resolution, this->cup_radius))
+  {
+    RCLCPP_WARN_ONCE(LOGGER, "Slice too large for the contact raster, counting contacts on points");
+    return nullptr;
+  }
+  return contact_raster;
+}
+
 /***************************************************************************//**
  * Function that updates the maximum and minimum values of the attributes
  * required for calculation of ranks, for normalization later on
@@ -649,6 +767,40 @@ void SuctionGripper::updateMaxMinValues(
   }
 }
 
+/***************************************************************************//**
+ * Function that appends the grasp samples of several workers to the grasp samples of the
+ * gripper, in the order of the buffers, and merges the range of their ranking attributes
+ * into the gripper. The samples of each buffer are moved on the thread pool, into a range of
+ * their own.
+ *
+ * @param buffers Grasp samples of each worker, left empty
+ ******************************************************************************/
+
+void SuctionGripper::mergeSampleBuffers(std::vector<suctionSampleBuffer> & buffers)
+{
+  std::vector<size_t> offsets(buffers.size() + 1, this->cup_array_samples.size());
+  for (size_t i = 0; i < buffers.size(); i++) {
+    const suctionSampleBuffer & buffer = buffers[i];
+    offsets[i + 1] = offsets[i] + buffer.samples.size();
+    this->min_center_dist = std::min(this->min_center_dist, buffer.min_center_dist);
+    this->max_center_dist = std::max(this->max_center_dist, buffer.max_center_dist);
+    this->min_contact_points = std::min(this->min_contact_points, buffer.min_contact_points);
+    this->max_contact_points = std::max(this->max_contact_points, buffer.max_contact_points);
+    this->min_curvature = std::min(this->min_curvature, buffer.min_curvature);
+    this->max_curvature = std::max(this->max_curvature, buffer.max_curvature);
+    this->exhaustive = this->exhaustive && buffer.exhaustive;
+  }
+  this->cup_array_samples.resize(offsets.back());
+  grasp_planner::ThreadPool::global()->parallelFor(
+    0, buffers.size(), [this, &buffers, &offsets](std::size_t i)
+    {
+      std::move(
+        buffers[i].samples.begin(), buffers[i].samples.end(),
+        this->cup_array_samples.begin() + offsets[i]);
+      buffers[i].samples.clear();
+    });
+}
+
 /***************************************************************************//**
  * Function that generates a single grasp sample of the user defined end effector
  *
@@ -660,6 +812,8 @@ void SuctionGripper::updateMaxMinValues(
  * @param col_direction Vector representing the suction array col direction
  * @param object_max_dim Maximum dimensions of object
  * @param camera_frame tf frame representing camera
+ * @param contact_raster Raster of the slice, contacts are counted on the points if null
+ * @param num_points Number of leading points of the clouds in the slice, all points by default
  ******************************************************************************/
 
 suctionCupArray SuctionGripper::generateGraspSample(
@@ -670,7 +824,9 @@ suctionCupArray SuctionGripper::generateGraspSample(
   const Eigen::Vector3f & row_direction,
   const Eigen::Vector3f & col_direction,
   const float & object_max_dim,
-  std::string camera_frame)
+  std::string camera_frame,
+  const std::shared_ptr<const grasp_planner::ContactRaster> & contact_raster,
+  const std::size_t & num_points)
 {
 
   suctionCupArray grasp_sample(sample_gripper_center, row_direction, col_direction);
@@ -728,7 +884,7 @@ suctionCupArray SuctionGripper::generateGraspSample(
 
       singleSuctionCup cup = generateSuctionCup(
         projected_cloud, sliced_cloud_normal,
-        cup_vector, object_center, object_max_dim);
+        cup_vector, object_center, object_max_dim, contact_raster, num_points);
       total_contact_points += cup.weighted_contact_points;
 
       total_curvature += cup.curvature_sum;
@@ -754,13 +910,17 @@ suctionCupArray SuctionGripper::generateGraspSample(
  * @param suction_cup_center Center of Suction Cup
  * @param object_center Center point of object
  * @param object_max_dim Maximum dimensions of obejct
+ * @param contact_raster Raster of the slice, contacts are counted on the points if null
+ * @param num_points Number of leading points of the clouds in the slice, all points by default
  ******************************************************************************/
 singleSuctionCup SuctionGripper::generateSuctionCup(
   const pcl::PointCloud<pcl::PointXYZRGB>::Ptr & projected_cloud,
   const pcl::PointCloud<pcl::PointNormal>::Ptr & sliced_cloud_normal,
   const Eigen::Vector3f & suction_cup_center,
   const pcl::PointXYZ & object_center,
-  const float & object_max_dim)
+  const float & object_max_dim,
+  const std::shared_ptr<const grasp_planner::ContactRaster> & contact_raster,
+  const std::size_t & num_points)
 {
   pcl::PointXYZ cup_point;
   cup_point.x = suction_cup_center(0);
@@ -771,8 +931,10 @@ singleSuctionCup SuctionGripper::generateSuctionCup(
   // Check how many points of the projected pointcloud land on a suction cup.
   float curvature_sum = 0;
 
-  int contact_points = getContactPoints(
-    projected_cloud, sliced_cloud_normal, cup_point, curvature_sum);
+  int contact_points = contact_raster ?
+    contact_raster->discSum(Eigen::Vector2f(cup_point.x, cup_point.y), curvature_sum) :
+    getContactPoints(
+    projected_cloud, sliced_cloud_normal, cup_point, curvature_sum, num_points);
 
   int weighted_contact_points = generateWeightedContactPoints(
     contact_points,
@@ -868,7 +1030,11 @@ pcl::PointXYZ SuctionGripper::getGripperCenter(
 }
 
 /***************************************************************************//**
- * Method that calculate the ranks of all grasp samples
+ * Method that calculate the ranks of all grasp samples. When the world grid has a distance
+ * field, the clearance of the cups from the world is ranked as well, normalized over all
+ * grasp samples. The samples are kept in decreasing rank and added to the grasp method after
+ * any grasps it already holds. With max_grasps set, only that many of the best ranked samples
+ * are kept.
  *
  * @param grasp_method Output Grasp Method to be used for Grasp Execution
  * @param object Target Grasp Object
@@ -879,6 +1045,28 @@ void SuctionGripper::getAllGraspRanks(
   const std::shared_ptr<GraspObject> & object)
 {
   std::vector<std::shared_ptr<suctionCupArray>> sorted_grasps;
+  const bool rank_clearance = this->clearance_weight > 0 && this->world_grid &&
+    this->world_grid->hasDistanceField();
+  float min_clearance = std::numeric_limits<float>::max();
+  float max_clearance = std::numeric_limits<float>::lowest();
+  if (rank_clearance) {
+    // The suction array approaches along the negative world Z axis
+    for (auto & grasp : this->cup_array_samples) {
+      for (auto & cup_row : grasp->cup_array) {
+        for (auto & cup : cup_row) {
+          grasp->clearance = std::min(
+            grasp->clearance,
+            this->world_grid->clearance(
+              Eigen::Vector3f(cup->cup_center.x, cup->cup_center.y,
+              cup->cup_center.z - this->cup_height)));
+        }
+      }
+      min_clearance = std::min(min_clearance, grasp->clearance);
+      max_clearance = std::max(max_clearance, grasp->clearance);
+    }
+  }
+  std::vector<float> ranks;
+  ranks.reserve(this->cup_array_samples.size());
   for (auto grasp : this->cup_array_samples) {
     float contact_points_norm = MathFunctions::normalizeInt(
       grasp->total_contact_points,
@@ -895,35 +1083,25 @@ void SuctionGripper::getAllGraspRanks(
     grasp->rank = 2.0 - curvature_norm * this->curvature_weight -
       grasp_center_norm * this->grasp_center_distance_weight +
       contact_points_norm * this->num_contact_points_weight;
-    geometry_msgs::msg::PoseStamped grasp_pose = getGraspPose(grasp, object);
-
-    if (sorted_grasps.size() == 0 && grasp_method->grasp_ranks.empty() &&
-      grasp_method->grasp_poses.empty())
-    {
-      sorted_grasps.push_back(grasp);
-      grasp_method->grasp_ranks.push_back(grasp->rank);
-      grasp_method->grasp_poses.push_back(grasp_pose);
-      grasp_method->grasp_markers.push_back(grasp->marker);
-    } else {
-      std::vector<std::shared_ptr<suctionCupArray>>::iterator grasp_it;
-      std::vector<geometry_msgs::msg::PoseStamped>::iterator pose_it;
-      std::vector<visualization_msgs::msg::Marker>::iterator markers_it;
-
-      int index;
-      for (index = 0, pose_it = grasp_method->grasp_poses.begin(), grasp_it = sorted_grasps.begin(),
-        markers_it = grasp_method->grasp_markers.begin();
-        index < static_cast<int>(grasp_method->grasp_ranks.size());
-        ++index, ++pose_it, ++grasp_it, ++markers_it)
-      {
-        if (grasp->rank > grasp_method->grasp_ranks[index]) {
-          sorted_grasps.insert(grasp_it, grasp);
-          grasp_method->grasp_ranks.insert(grasp_method->grasp_ranks.begin() + index, grasp->rank);
-          grasp_method->grasp_poses.insert(pose_it, grasp_pose);
-          grasp_method->grasp_markers.insert(markers_it, grasp->marker);
-          break;
-        }
-      }
+    if (rank_clearance) {
+      grasp->rank += MathFunctions::normalize(grasp->clearance, min_clearance, max_clearance) *
+        this->clearance_weight;
     }
+    ranks.push_back(grasp->rank);
+  }
+  // Only the best max_grasps samples are given a pose
+  const std::vector<size_t> rank_order = MathFunctions::getTopRankIndices(
+    ranks, this->max_grasps);
+  sorted_grasps.reserve(rank_order.size());
+  grasp_method->grasp_ranks.reserve(grasp_method->grasp_ranks.size() + rank_order.size());
+  grasp_method->grasp_poses.reserve(grasp_method->grasp_poses.size() + rank_order.size());
+  grasp_method->grasp_markers.reserve(grasp_method->grasp_markers.size() + rank_order.size());
+  for (const size_t & index : rank_order) {
+    const std::shared_ptr<suctionCupArray> & grasp = this->cup_array_samples[index];
+    sorted_grasps.push_back(grasp);
+    grasp_method->grasp_ranks.push_back(grasp->rank);
+    grasp_method->grasp_poses.push_back(getGraspPose(grasp, object));
+    grasp_method->grasp_markers.push_back(grasp->marker);
   }
   this->cup_array_samples = sorted_grasps;
 }
@@ -235,3 +235,21 @@ char GraspObject::getAxis(Eigen::Vector3f vector)
   }
   return '-';
 }
+
+/***************************************************************************//**
+ * Returns the search tree over the object point cloud. The tree is built on the first
+ * call and shared by all later neighbour queries on the cloud.
+ ******************************************************************************/
+pcl::search::KdTree<pcl::PointXYZRGB>::Ptr GraspObject::getCloudSearch()
+{
+  return this->cloud_index.getSearch(this->cloud);
+}
+
+/***************************************************************************//**
+ * Returns the search tree over the object normal point cloud. The tree is built on the
+ * first call and shared by all later neighbour queries on the cloud.
+ ******************************************************************************/
+pcl::search::KdTree<pcl::PointNormal>::Ptr GraspObject::getNormalCloudSearch()
+{
+  return this->cloud_normal_index.getSearch(this->cloud_normal);
+}
@@ -164,8 +164,12 @@ void grasp_planner::GraspScene<T>::sendToExecution(
 }
 
 /****************************************************************************************//**
- * Method to generate Grasp Tasks for manipulation
- * @param msg Input message
+ * Method to generate Grasp Tasks for manipulation. Every (object, end effector) pair is
+ * planned separately, in parallel on the planning thread pool when parallel_planning is set,
+ * and the task is assembled afterwards in object and end effector order. Planning of an
+ * object is abandoned once object_planning_timeout seconds have passed since it started.
+ * With anytime_planning set, the grasps found until then are kept instead, and planning
+ * stops once anytime_max_grasps grasps of rank anytime_min_rank or more are found.
  *******************************************************************************************/
 template<typename T>
 emd_msgs::msg::GraspTask grasp_planner::GraspScene<T>::generateGraspTask()
@@ -175,44 +179,115 @@ emd_msgs::msg::GraspTask grasp_planner::GraspScene<T>::generateGraspTask()
 
   if (this->grasp_objects.size() == 0) {return grasp_task;}
 
-  for (auto object : this->grasp_objects) {
-    loadEndEffectors();
-    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-    for (auto gripper : this->end_effectors) {
+  loadEndEffectors();
+  const std::string camera_frame =
+    node->get_parameter("camera_parameters.camera_frame").as_string();
+  // Parameters added after the first release default to their previous behaviour
+  const double object_planning_timeout = node->get_parameter_or("object_planning_timeout", 0.0);
+  const bool anytime_planning = node->get_parameter_or("anytime_planning", false);
+  const int64_t anytime_max_grasps =
+    node->get_parameter_or("anytime_max_grasps", static_cast<int64_t>(0));
+  const float anytime_min_rank =
+    static_cast<float>(node->get_parameter_or("anytime_min_rank", 0.0));
+  const grasp_planner::collision::CollisionCheckMode collision_check_mode =
+    grasp_planner::collision::getCollisionCheckMode(
+    node->get_parameter_or("point_cloud_params.collision_check_mode", std::string("fcl")));
+  // In fcl mode the world grid is only built for its distance field
+  const std::shared_ptr<const grasp_planner::collision::OccupancyGrid> collision_grid =
+    collision_check_mode == grasp_planner::collision::CollisionCheckMode::FCL ?
+    nullptr : this->world_grid;
+  const std::shared_ptr<const grasp_planner::collision::OccupancyGrid> distance_field =
+    this->world_grid && this->world_grid->hasDistanceField() ? this->world_grid : nullptr;
+  const size_t num_end_effectors = this->end_effectors.size();
+  const size_t num_plans = this->grasp_objects.size() * num_end_effectors;
+
+  // Result of planning one object with one end effector
+  struct GraspPlan
+  {
+    emd_msgs::msg::GraspMethod grasp_method;
+    std::vector<std::shared_ptr<multiFingerGripper>> grasp_config;
+    FingerPlanningContext context;
+    std::chrono::milliseconds planning_time;
+  };
+  std::vector<GraspPlan> plans(num_plans);
+  std::vector<std::once_flag> object_started(this->grasp_objects.size());
+  std::vector<std::chrono::steady_clock::time_point> object_deadlines(
+    this->grasp_objects.size(), std::chrono::steady_clock::time_point::max());
+
+  // Plans are stored in object major order, so that the task does not depend on scheduling
+  auto planPair = [&](std::size_t plan_index) {
+      const size_t object_index = plan_index / num_end_effectors;
+      std::call_once(
+        object_started[object_index], [&]() {
+          if (object_planning_timeout > 0) {
+            object_deadlines[object_index] = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::duration<double>(object_planning_timeout));
+          }
+        });
+      const std::shared_ptr<GraspObject> & object = this->grasp_objects[object_index];
+      const std::shared_ptr<FingerGripper> & gripper =
+        this->end_effectors[plan_index % num_end_effectors];
+      GraspPlan & plan = plans[plan_index];
       std::chrono::steady_clock::time_point grasp_begin = std::chrono::steady_clock::now();
 
-      emd_msgs::msg::GraspMethod grasp_method;
-      grasp_method.ee_id = gripper->getID();
-      grasp_method.grasp_ranks.insert(
-        grasp_method.grasp_ranks.begin(), std::numeric_limits<float>::min());
-
-      auto& grasp_config = gripper->planGraspsWithFingerResult(
-        object, &grasp_method, world_collision_object,
-        node->get_parameter("camera_parameters.camera_frame").as_string());
-      grasp_method.grasp_ranks.pop_back();
-      if (grasp_method.grasp_ranks.size() > 0) {
-        object->grasp_target.grasp_methods.push_back(grasp_method);
+      plan.grasp_method.ee_id = gripper->getID();
+      plan.context.deadline = object_deadlines[object_index];
+      plan.context.world_grid = collision_grid;
+      plan.context.validate_collisions =
+        collision_check_mode == grasp_planner::collision::CollisionCheckMode::VALIDATE;
+      plan.context.world_distance_field = distance_field;
+      plan.context.anytime = anytime_planning;
+      plan.context.max_grasps = static_cast<size_t>(std::max<int64_t>(anytime_max_grasps, 0));
+      plan.context.min_rank = anytime_min_rank;
+      plan.grasp_config = gripper->planGraspsWithFingerResult(
+        plan.context, object, &plan.grasp_method, world_collision_object, camera_frame);
+      plan.planning_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - grasp_begin);
+    };
+  if (node->get_parameter_or("parallel_planning", false)) {
+    grasp_planner::ThreadPool::global()->parallelFor(0, num_plans, planPair);
+  } else {
+    for (size_t plan_index = 0; plan_index < num_plans; plan_index++) {
+      planPair(plan_index);
+    }
+  }
+
+  for (size_t object_index = 0; object_index < this->grasp_objects.size(); object_index++) {
+    const std::shared_ptr<GraspObject> & object = this->grasp_objects[object_index];
+    std::chrono::milliseconds object_planning_time(0);
+    for (size_t ee_index = 0; ee_index < num_end_effectors; ee_index++) {
+      GraspPlan & plan = plans[object_index * num_end_effectors + ee_index];
+      object_planning_time += plan.planning_time;
+      if (plan.context.timed_out && plan.grasp_method.grasp_ranks.empty()) {
+        RCLCPP_ERROR_STREAM(
+          LOGGER, "For Object " << object->grasp_target.target_type.c_str() <<
+            ", planning with end effector " << plan.grasp_method.ee_id << " timed out");
+      } else if (plan.grasp_method.grasp_ranks.size() > 0) {
+        if (!plan.context.exhaustive) {
+          RCLCPP_INFO_STREAM(
+            LOGGER, "For Object " << object->grasp_target.target_type.c_str() <<
+              ", anytime planning with end effector " << plan.grasp_method.ee_id <<
+              " stopped early, better grasps may exist");
+        }
+        object->grasp_target.grasp_methods.push_back(plan.grasp_method);
       } else {
         RCLCPP_ERROR_STREAM(
           LOGGER, "For Object " << object->grasp_target.target_type.c_str() <<
-            ", no grasp methods can be found with end effector " << gripper->getID());
-        // continue;
-        
+            ", no grasp methods can be found with end effector " << plan.grasp_method.ee_id);
       }
 
-      
-      publishMarkers(this->node, grasp_config);
-      std::chrono::steady_clock::time_point grasp_end = std::chrono::steady_clock::now();
-      RCLCPP_INFO_STREAM(LOGGER, "Grasp planning found " << grasp_config.size() << " grasps for " << std::chrono::duration_cast<std::chrono::milliseconds>(grasp_end - grasp_begin).count()
-      << "ms");
+      publishMarkers(this->node, plan.grasp_config);
       RCLCPP_INFO_STREAM(
-        LOGGER, "Grasp planning time for " << grasp_method.ee_id << " " <<
-          std::to_string(
-          std::chrono::duration_cast<std::chrono::milliseconds>(grasp_end - grasp_begin).count()) +
-          " [ms] " << grasp_config.size() << " grasps");
+        LOGGER, "Grasp planning time for " << plan.grasp_method.ee_id << " " <<
+          std::to_string(plan.planning_time.count()) +
+          " [ms] " << plan.grasp_config.size() << " grasps");
 
       if (node->get_parameter("visualization_params.point_cloud_visualization").as_bool()) {
-        gripper->visualizeGrasps(viewer, object);
+        if (!viewer) {
+          viewer.reset(new pcl::visualization::PCLVisualizer("Cloud viewer"));
+        }
+        this->end_effectors[ee_index]->visualizeGrasps(viewer, object, plan.context);
         std::cout << "Point Cloud Viewer Visualization" << std::endl;
       }
     }
@@ -226,12 +301,9 @@ emd_msgs::msg::GraspTask grasp_planner::GraspScene<T>::generateGraspTask()
           " end effectors provided. ");
       continue;
     }
-    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
     RCLCPP_INFO_STREAM(
       LOGGER, "Grasp planning time for object " << object->object_name << " " <<
-        std::to_string(
-        std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count()) +
-        " [ms] ");
+        std::to_string(object_planning_time.count()) + " [ms] ");
   }
 
   objectPoseRectification(grasp_task);
@@ -240,77 +312,190 @@ emd_msgs::msg::GraspTask grasp_planner::GraspScene<T>::generateGraspTask()
 }
 
 /***************************************************************************//**
- * Method that loads all available end effector based on the parameter files
+ * Method that loads the end effectors based on the parameter files. Loaded end
+ * effectors are kept, and only the ones whose parameters changed since they were
+ * loaded are built again. The stale state is taken before the parameters are read,
+ * so the parameter callback is never waited on while the node parameters are locked.
  ******************************************************************************/
 template<typename T>
 void grasp_planner::GraspScene<T>::loadEndEffectors()
 {
-  this->end_effectors.clear();
-  std::vector<std::string> end_effector_array = node->get_parameter(
-    "end_effectors.end_effector_names").as_string_array();
-  for (std::string end_effector : end_effector_array) {
-    std::string end_effector_type =
-      node->get_parameter("end_effectors." + end_effector + ".type").as_string();
-    RCLCPP_INFO_STREAM(LOGGER, "Loading " << end_effector_type << " gripper " << end_effector);
-    if (end_effector_type.compare("finger") == 0) {
-      FingerGripper gripper(
-        end_effector,
-        node->get_parameter("end_effectors." + end_effector + ".num_fingers_side_1").as_int(),
-        node->get_parameter("end_effectors." + end_effector + ".num_fingers_side_2").as_int(),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".distance_between_fingers_1").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".distance_between_fingers_2").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".finger_thickness").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".gripper_stroke").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.voxel_size").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.grasp_rank_weight_1").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.grasp_rank_weight_2").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.grasp_plane_dist_limit").as_double()),
-        static_cast<float>(node->get_parameter(
-          "point_cloud_params.cloud_normal_radius").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.world_x_angle_threshold").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.world_y_angle_threshold").as_double()),
-        static_cast<float>(node->get_parameter(
-          "end_effectors." + end_effector +
-          ".grasp_planning_params.world_z_angle_threshold").as_double()),
-        node->get_parameter(
-          "end_effectors." + end_effector +
-          ".gripper_coordinate_system.grasp_stroke_direction").as_string(),
-        node->get_parameter(
-          "end_effectors." + end_effector +
-          ".gripper_coordinate_system.grasp_stroke_normal_direction").as_string(),
-        node->get_parameter(
-          "end_effectors." + end_effector +
-          ".gripper_coordinate_system.grasp_approach_direction").as_string()
-      );
-      std::shared_ptr<FingerGripper> gripper_ptr = std::make_shared<FingerGripper>(gripper);
-      this->end_effectors.push_back(gripper_ptr);
-    } else if (end_effector_type.compare("suction") == 0) {
-      // Not used
+  std::set<std::string> stale_end_effectors;
+  bool all_end_effectors_stale;
+  {
+    std::lock_guard<std::mutex> lock(this->end_effector_mutex);
+    if (!this->all_end_effectors_stale && this->stale_end_effectors.empty()) {
+      return;
+    }
+    stale_end_effectors.swap(this->stale_end_effectors);
+    all_end_effectors_stale = this->all_end_effectors_stale;
+    this->all_end_effectors_stale = false;
+  }
+  std::vector<std::shared_ptr<FingerGripper>> loaded_end_effectors;
+  loaded_end_effectors.swap(this->end_effectors);
+  try {
+    std::vector<std::string> end_effector_array = node->get_parameter(
+      "end_effectors.end_effector_names").as_string_array();
+    for (std::string end_effector : end_effector_array) {
+      auto loaded = std::find_if(
+        loaded_end_effectors.begin(), loaded_end_effectors.end(),
+        [&end_effector](const std::shared_ptr<FingerGripper> & gripper) {
+          return gripper->getID() == end_effector;
+        });
+      if (!all_end_effectors_stale && loaded != loaded_end_effectors.end() &&
+        stale_end_effectors.count(end_effector) == 0)
+      {
+        this->end_effectors.push_back(*loaded);
+        continue;
+      }
+      std::string end_effector_type =
+        node->get_parameter("end_effectors." + end_effector + ".type").as_string();
+      RCLCPP_INFO_STREAM(LOGGER, "Loading " << end_effector_type << " gripper " << end_effector);
+      if (end_effector_type.compare("finger") == 0) {
+        this->end_effectors.push_back(loadFingerGripper(end_effector));
+      } else if (end_effector_type.compare("suction") == 0) {
+        // Not used
+      }
     }
+  } catch (...) {
+    // Nothing is kept from a failed load, so everything is built again next time
+    std::lock_guard<std::mutex> lock(this->end_effector_mutex);
+    this->all_end_effectors_stale = true;
+    throw;
   }
   RCLCPP_INFO(LOGGER, "All End Effectors Loaded");
 }
 
+/***************************************************************************//**
+ * Method that builds a finger gripper from a single snapshot of the parameters
+ * in its namespace
+ * @param end_effector Name of the end effector
+ * @param overrides Parameters being set, used in place of the current values
+ ******************************************************************************/
+template<typename T>
+std::shared_ptr<FingerGripper> grasp_planner::GraspScene<T>::loadFingerGripper(
+  const std::string & end_effector, const std::vector<rclcpp::Parameter> & overrides)
+{
+  const std::string prefix = "end_effectors." + end_effector + ".";
+  std::map<std::string, rclcpp::Parameter> params;
+  node->get_node_parameters_interface()->get_parameters_by_prefix(
+    "end_effectors." + end_effector, params);
+  rclcpp::Parameter cloud_normal_radius;
+  node->get_parameter("point_cloud_params.cloud_normal_radius", cloud_normal_radius);
+  for (const auto & parameter : overrides) {
+    if (parameter.get_name().compare(0, prefix.size(), prefix) == 0) {
+      params[parameter.get_name().substr(prefix.size())] = parameter;
+    } else if (parameter.get_name() == "point_cloud_params.cloud_normal_radius") {
+      cloud_normal_radius = parameter;
+    }
+  }
+  if (params.empty()) {
+    throw std::invalid_argument("No parameters for end effector " + end_effector);
+  }
+  auto param = [&params, &end_effector](const std::string & name) -> const rclcpp::Parameter & {
+      auto it = params.find(name);
+      if (it == params.end()) {
+        throw std::invalid_argument("Missing parameter " + end_effector + "." + name);
+      }
+      return it->second;
+    };
+  auto optional_param = [&params](const std::string & name, double default_value) {
+      auto it = params.find(name);
+      return it == params.end() ? default_value : it->second.as_double();
+    };
+  auto optional_int_param = [&params](const std::string & name, int64_t default_value) {
+      auto it = params.find(name);
+      return it == params.end() ? default_value : it->second.as_int();
+    };
+  if (optional_param("grasp_planning_params.grasp_rank_weight_clearance", 0.0) > 0 &&
+    !node->get_parameter_or("point_cloud_params.world_distance_field", false))
+  {
+    RCLCPP_WARN(
+      LOGGER, "Clearance of %s is not ranked without point_cloud_params.world_distance_field",
+      end_effector.c_str());
+  }
+  return std::make_shared<FingerGripper>(
+    end_effector,
+    param("num_fingers_side_1").as_int(),
+    param("num_fingers_side_2").as_int(),
+    static_cast<float>(param("distance_between_fingers_1").as_double()),
+    static_cast<float>(param("distance_between_fingers_2").as_double()),
+    static_cast<float>(param("finger_thickness").as_double()),
+    static_cast<float>(param("gripper_stroke").as_double()),
+    static_cast<float>(param("grasp_planning_params.voxel_size").as_double()),
+    static_cast<float>(param("grasp_planning_params.grasp_rank_weight_1").as_double()),
+    static_cast<float>(param("grasp_planning_params.grasp_rank_weight_2").as_double()),
+    static_cast<float>(param("grasp_planning_params.grasp_plane_dist_limit").as_double()),
+    static_cast<float>(cloud_normal_radius.as_double()),
+    static_cast<float>(param("grasp_planning_params.world_x_angle_threshold").as_double()),
+    static_cast<float>(param("grasp_planning_params.world_y_angle_threshold").as_double()),
+    static_cast<float>(param("grasp_planning_params.world_z_angle_threshold").as_double()),
+    param("gripper_coordinate_system.grasp_stroke_direction").as_string(),
+    param("gripper_coordinate_system.grasp_stroke_normal_direction").as_string(),
+    param("gripper_coordinate_system.grasp_approach_direction").as_string(),
+    static_cast<float>(optional_param("grasp_planning_params.grasp_rank_weight_clearance", 0.0)),
+    static_cast<float>(optional_param("grasp_planning_params.friction_cone_angle", M_PI / 2)),
+    static_cast<float>(optional_param("grasp_planning_params.coarse_voxel_size", 0.0)),
+    static_cast<int>(optional_int_param("grasp_planning_params.coarse_candidates", 5)));
+}
+
+/***************************************************************************//**
+ * Parameter callback that checks the end effector parameters being changed and,
+ * once they are accepted, marks those end effectors so that they are built again
+ * before the next plan. The loaded end effectors are rebuilt with the new values,
+ * and the update is rejected if any of them cannot be built.
+ * @param parameters Parameters being set
+ ******************************************************************************/
+template<typename T>
+rcl_interfaces::msg::SetParametersResult
+grasp_planner::GraspScene<T>::onParametersChanged(
+  const std::vector<rclcpp::Parameter> & parameters)
+{
+  const std::string prefix = "end_effectors.";
+  std::vector<std::string> end_effector_names =
+    node->get_parameter_or("end_effectors.end_effector_names", std::vector<std::string>());
+  std::set<std::string> stale_end_effectors;
+  bool all_end_effectors_stale = false;
+  rcl_interfaces::msg::SetParametersResult result;
+  result.successful = true;
+  try {
+    for (const auto & parameter : parameters) {
+      const std::string & name = parameter.get_name();
+      if (name == "point_cloud_params.cloud_normal_radius") {
+        all_end_effectors_stale = true;
+      } else if (name == prefix + "end_effector_names") {
+        all_end_effectors_stale = true;
+        end_effector_names = parameter.as_string_array();
+      } else if (name.compare(0, prefix.size(), prefix) == 0) {
+        stale_end_effectors.insert(
+          name.substr(prefix.size(), name.find('.', prefix.size()) - prefix.size()));
+      }
+    }
+    for (const auto & end_effector : end_effector_names) {
+      if (!all_end_effectors_stale && stale_end_effectors.count(end_effector) == 0) {
+        continue;
+      }
+      rclcpp::Parameter type;
+      node->get_parameter(prefix + end_effector + ".type", type);
+      for (const auto & parameter : parameters) {
+        if (parameter.get_name() == prefix + end_effector + ".type") {
+          type = parameter;
+        }
+      }
+      if (type.as_string().compare("finger") == 0) {
+        loadFingerGripper(end_effector, parameters);
+      }
+    }
+  } catch (const std::exception & e) {
+    result.successful = false;
+    result.reason = e.what();
+    return result;
+  }
+  std::lock_guard<std::mutex> lock(this->end_effector_mutex);
+  this->all_end_effectors_stale = this->all_end_effectors_stale || all_end_effectors_stale;
+  this->stale_end_effectors.insert(stale_end_effectors.begin(), stale_end_effectors.end());
+  return result;
+}
 
 /****************************************************************************************//**
  * Function that processes the Objects in a point cloud scene and outputs a vector
@@ -332,6 +517,12 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::extractObjectsDir
   float cluster_tolerance = static_cast<float>(node->get_parameter(
       "point_cloud_params.cluster_tolerance").as_double());
 
+  int normal_estimation_threads = static_cast<int>(node->get_parameter_or(
+      "point_cloud_params.normal_estimation_threads", static_cast<int64_t>(0)));
+  if (normal_estimation_threads <= 0) {
+    normal_estimation_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
   // pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>);
   // std::vector<pcl::PointIndices> clusterIndices;
   // pcl::EuclideanClusterExtraction<pcl::PointXYZRGB> ecExtractor;
@@ -343,8 +534,37 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::extractObjectsDir
   // ecExtractor.setInputCloud(cloud);
   // ecExtractor.extract(clusterIndices);
 
-  std::vector<pcl::PointIndices> clusterIndices = PCLFunctions::extractPointCloudClusters(
-    this->cloud_plane_removed, cluster_tolerance, min_cluster_size);
+  // Organized clouds are clustered in image space, which needs the support plane
+  const bool organized_clustering = this->organized_cloud->isOrganized() &&
+    this->table_coeff->values.size() == 4;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr source_cloud = this->cloud_plane_removed;
+  pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree;
+  std::vector<pcl::PointIndices> clusterIndices;
+  if (organized_clustering) {
+    const std::vector<double> limits_x = node->get_parameter(
+      "point_cloud_params.passthrough_filter_limits_x").as_double_array();
+    const std::vector<double> limits_y = node->get_parameter(
+      "point_cloud_params.passthrough_filter_limits_y").as_double_array();
+    const std::vector<double> limits_z = node->get_parameter(
+      "point_cloud_params.passthrough_filter_limits_z").as_double_array();
+    source_cloud = this->organized_cloud;
+    clusterIndices = PCLFunctions::extractOrganizedClusters(
+      this->organized_cloud, this->table_coeff->values,
+      static_cast<float>(node->get_parameter(
+        "point_cloud_params.segmentation_distance_threshold").as_double()),
+      static_cast<float>(limits_x[1]), static_cast<float>(limits_x[0]),
+      static_cast<float>(limits_y[1]), static_cast<float>(limits_y[0]),
+      static_cast<float>(limits_z[1]), static_cast<float>(limits_z[0]),
+      cluster_tolerance, min_cluster_size,
+      pcl::deg2rad(static_cast<float>(node->get_parameter_or(
+        "point_cloud_params.organized_cluster_max_normal_angle", 0.0))));
+  } else {
+    // The tree built for clustering is reused for the normal estimation of every object
+    tree.reset(new pcl::search::KdTree<pcl::PointXYZRGB>);
+    tree->setInputCloud(this->cloud_plane_removed);
+    clusterIndices = PCLFunctions::extractPointCloudClusters(
+      this->cloud_plane_removed, cluster_tolerance, min_cluster_size, tree);
+  }
 
   if (clusterIndices.empty()) {
     RCLCPP_ERROR(LOGGER, "No Objects can be extracted");
@@ -355,12 +575,17 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::extractObjectsDir
       for (std::vector<int>::const_iterator pit = it->indices.begin();
         pit != it->indices.end(); ++pit)
       {
-        objectCloud->points.push_back(this->cloud_plane_removed->points[*pit]);
+        objectCloud->points.push_back(source_cloud->points[*pit]);
       }
 
       objectCloud->width = objectCloud->points.size();
       objectCloud->height = 1;
       objectCloud->is_dense = true;
+      if (organized_clustering) {
+        // The organized cloud skipped the outlier removal of the filtered cloud, which the
+        // clusters of the Euclidean path are taken from
+        PCLFunctions::removeStatisticalOutlier(objectCloud, 1.0);
+      }
 
       // Get the centroid of the point cloud
       Eigen::Vector4f centroid;
@@ -369,7 +594,15 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::extractObjectsDir
         camera_frame,
         objectCloud,
         centroid);
-      PCLFunctions::computeCloudNormal(objectCloud, object->cloud_normal, cloud_normal_radius);
+      if (organized_clustering) {
+        PCLFunctions::computeCloudNormal(
+          objectCloud, object->cloud_normal, cloud_normal_radius, object->getCloudSearch(),
+          normal_estimation_threads);
+      } else {
+        PCLFunctions::computeClusterNormal(
+          this->cloud_plane_removed, tree, *it, object->cloud_normal, cloud_normal_radius,
+          normal_estimation_threads);
+      }
       object->get_object_bb();
       object->get_object_world_angles();
       object->grasp_target.target_shape = object->getObjectShape();
@@ -400,6 +633,12 @@ void grasp_planner::GraspScene<T>::extractObjectsEPD(
   float cloud_normal_radius = static_cast<float>(node->get_parameter(
       "point_cloud_params.cloud_normal_radius").as_double());
 
+  int normal_estimation_threads = static_cast<int>(node->get_parameter_or(
+      "point_cloud_params.normal_estimation_threads", static_cast<int64_t>(0)));
+  if (normal_estimation_threads <= 0) {
+    normal_estimation_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+
   for (auto raw_object : objects) {
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr objectCloud(new pcl::PointCloud<pcl::PointXYZRGB>());
     pcl::PCLPointCloud2 * pcl_pc2(new pcl::PCLPointCloud2);
@@ -421,7 +660,10 @@ void grasp_planner::GraspScene<T>::extractObjectsEPD(
       raw_object.name,
       camera_frame, objectCloud,
       centroid);
-    PCLFunctions::computeCloudNormal(objectCloud, object->cloud_normal, cloud_normal_radius);
+    // The object search tree is kept for the neighbour queries of grasp planning
+    PCLFunctions::computeCloudNormal(
+      objectCloud, object->cloud_normal, cloud_normal_radius, object->getCloudSearch(),
+      normal_estimation_threads);
     object->get_object_bb();
     object->get_object_world_angles();
     object->grasp_target.target_shape = object->getObjectShape();
@@ -463,7 +705,7 @@ void grasp_planner::GraspScene<epd_msgs::msg::EPDObjectTracking>::extractObjects
  * @param msg Pointcloud input
  ******************************************************************************/
 template<>
-void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::createWorldCollision(
+bool grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::createWorldCollision(
   const sensor_msgs::msg::PointCloud2::ConstSharedPtr & msg)
 {
   geometry_msgs::msg::TransformStamped sensorToWorldTf =
@@ -471,82 +713,153 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::createWorldCollis
     "base_link", msg->header.frame_id,
     msg->header.stamp);
   octomap::point3d sensor_origin = octomap::pointTfToOctomap(sensorToWorldTf.transform.translation);
-  this->world_collision_object = FCLFunctions::createCollisionObjectFromPointCloudRGB(
-    this->org_cloud, sensor_origin,
-    static_cast<float>(node->get_parameter("point_cloud_params.octomap_resolution").as_double()));
+  updateWorldCollision(sensor_origin);
+  return true;
 }
 
 /***************************************************************************//**
  * Function that converts an EPD localization message into an FCL compatible
- * collision object
+ * collision object. The depth image is cropped while it is projected, so the
+ * projected cloud is only downsampled. Returns false, leaving the collision
+ * object unchanged, if the depth image does not match the camera info.
  * @param msg EPD input
  ******************************************************************************/
 template<typename T>
-void grasp_planner::GraspScene<T>::createWorldCollision(
+bool grasp_planner::GraspScene<T>::createWorldCollision(
   const typename T::ConstSharedPtr & msg)
 {
-  // auto ppx = camera_info.k.at(2);
-  // auto fx = camera_info.k.at(0);
-  // auto ppy = camera_info.k.at(5);
-  // auto fy = camera_info.k.at(4);
-
-  float ppx = 323.3077697753906;
-  float fx = 610.3740844726562;
-  float ppy = 235.43516540527344;
-  float fy = 609.8685913085938;
-  cv_bridge::CvImagePtr cv_ptr;
-  cv_ptr = cv_bridge::toCvCopy(msg->depth_image, sensor_msgs::image_encodings::TYPE_16UC1);
-  cv::Mat depth_img = cv_ptr->image;
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr scene_cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
-  for (size_t i = 0; i < msg->depth_image.width; i++) {
-    for (size_t j = 0; j < msg->depth_image.height; j++) {
-      pcl::PointXYZRGB temp_point;
-      auto depth = depth_img.at<ushort>(j, i) * 0.001;    // NOLINT
-      temp_point.x = (i - ppx) / fx * depth;
-      temp_point.y = (j - ppy) / fy * depth;
-      temp_point.z = depth;
-      scene_cloud->points.push_back(temp_point);
-    }
+  if (!this->depth_projector.projectDepthImage(
+      msg->depth_image, scene_cloud,
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
+      as_double_array()[1]),
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
+      as_double_array()[0]),
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
+      as_double_array()[1]),
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
+      as_double_array()[0]),
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
+      as_double_array()[1]),
+      static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
+      as_double_array()[0]),
+      false))
+  {
+    RCLCPP_ERROR(
+      LOGGER, "Depth image (%s, %dx%d) does not match the received camera info.",
+      msg->depth_image.encoding.c_str(), msg->depth_image.width, msg->depth_image.height);
+    return false;
   }
 
-  PCLFunctions::passthroughFilter(
+  PCLFunctions::downsampleCloud(
     scene_cloud,
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
-    as_double_array()[0]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
-    as_double_array()[0]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
-    as_double_array()[0]));
-  PCLFunctions::removeStatisticalOutlier(scene_cloud, 1.0);
+    1.0,
+    static_cast<float>(node->get_parameter(
+      "point_cloud_params.fcl_voxel_size").as_double()),
+    scene_cloud, this->org_cloud,
+    static_cast<int>(node->get_parameter_or(
+      "point_cloud_params.preprocessing_threads", static_cast<int64_t>(1))));
 
   geometry_msgs::msg::TransformStamped sensorToWorldTf =
     this->buffer_->lookupTransform(
     "base_link", msg->header.frame_id,
     msg->header.stamp);
   octomap::point3d sensor_origin = octomap::pointTfToOctomap(sensorToWorldTf.transform.translation);
+  updateWorldCollision(sensor_origin);
+  return true;
+}
 
-  PCLFunctions::voxelizeCloud
-  <pcl::PointCloud<pcl::PointXYZRGB>::Ptr, pcl::VoxelGrid<pcl::PointXYZRGB>>(
-    scene_cloud,
-    static_cast<float>(node->get_parameter(
-      "point_cloud_params.fcl_voxel_size").as_double()),
-    this->org_cloud);
+/***************************************************************************//**
+ * Function that updates the world collision object from org_cloud. With a persistent
+ * world model the cloud is integrated into the map kept from previous planning cycles,
+ * restricted to the passthrough filter region, and the same collision object is reused.
+ * Otherwise, or when the world model mode does not cast rays to clear free space, a new
+ * collision object is built from the cloud alone.
+ * @param sensor_origin Origin of the sensor
+ ******************************************************************************/
+template<typename T>
+void grasp_planner::GraspScene<T>::updateWorldCollision(const octomap::point3d & sensor_origin)
+{
+  const float octomap_resolution = static_cast<float>(node->get_parameter(
+      "point_cloud_params.octomap_resolution").as_double());
+  const unsigned int num_threads = static_cast<unsigned int>(
+    node->get_parameter_or("point_cloud_params.preprocessing_threads", static_cast<int64_t>(1)));
+  const FCLFunctions::IntegrationMode mode = FCLFunctions::getIntegrationMode(
+    node->get_parameter_or("point_cloud_params.world_model_mode", std::string("ray_casting")));
+  if (!node->get_parameter_or("point_cloud_params.persistent_world_model", false) ||
+    mode != FCLFunctions::IntegrationMode::RAY_CASTING)
+  {
+    this->world_model.reset();
+    this->world_collision_object = FCLFunctions::createCollisionObjectFromPointCloudRGB(
+      this->org_cloud, sensor_origin, octomap_resolution, num_threads, mode,
+      static_cast<float>(node->get_parameter_or("point_cloud_params.occlusion_depth", 0.05)));
+    updateWorldGrid();
+    return;
+  }
 
-  this->world_collision_object = FCLFunctions::createCollisionObjectFromPointCloudRGB(
-    this->org_cloud, sensor_origin,
-    static_cast<float>(node->get_parameter("point_cloud_params.octomap_resolution").as_double()));
+  if (!this->world_model || this->world_model->getResolution() != octomap_resolution) {
+    this->world_model = std::make_shared<grasp_planner::collision::WorldModel>(
+      octomap_resolution);
+  }
+  const std::vector<double> limits_x = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_x").as_double_array();
+  const std::vector<double> limits_y = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_y").as_double_array();
+  const std::vector<double> limits_z = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_z").as_double_array();
+  this->world_model->setUpdateRegion(
+    octomap::point3d(limits_x[0], limits_y[0], limits_z[0]),
+    octomap::point3d(limits_x[1], limits_y[1], limits_z[1]));
+  this->world_model->setDecay(
+    static_cast<float>(node->get_parameter_or("point_cloud_params.world_model_decay", 0.0)));
+
+  size_t changed_cells = this->world_model->integratePointCloud(
+    this->org_cloud, sensor_origin, num_threads);
+  RCLCPP_INFO(LOGGER, "World model updated, %zu cells changed", changed_cells);
+  this->world_collision_object = this->world_model->getCollisionObject();
+  updateWorldGrid();
+}
+
+/***************************************************************************//**
+ * Function that rebuilds the occupancy grid of the world collision object, which finger
+ * collisions are looked up in instead of FCL unless collision_check_mode is "fcl". If the
+ * grid cannot be built, finger collisions fall back to FCL. With world_distance_field set,
+ * the grid is built in every collision check mode, and its distance field is computed as
+ * well for clearance queries.
+ ******************************************************************************/
+template<typename T>
+void grasp_planner::GraspScene<T>::updateWorldGrid()
+{
+  const grasp_planner::collision::CollisionCheckMode mode =
+    grasp_planner::collision::getCollisionCheckMode(
+    node->get_parameter_or("point_cloud_params.collision_check_mode", std::string("fcl")));
+  const bool world_distance_field =
+    node->get_parameter_or("point_cloud_params.world_distance_field", false);
+  this->world_grid.reset();
+  if (mode == grasp_planner::collision::CollisionCheckMode::FCL && !world_distance_field) {
+    return;
+  }
+  auto grid = std::make_shared<grasp_planner::collision::OccupancyGrid>();
+  if (!grid->build(*this->world_collision_object)) {
+    RCLCPP_WARN(
+      LOGGER, "World occupancy grid could not be built, using FCL collision checks "
+      "and not ranking clearance");
+    return;
+  }
+  if (world_distance_field && !grid->computeDistanceField())
+  {
+    RCLCPP_WARN(LOGGER, "World distance field could not be computed, clearance is not ranked");
+  }
+  this->world_grid = grid;
 }
 
 /***************************************************************************//**
  * Function that processes an input sensor_msgs pointcloud2 message.
- * Includes Conversion to PCL Pointcloud2 type, undergoing passthrough filtering,
- * Removing statistical outlier, downsampling and plane segmentation.
+ * Includes reading the message into a PCL cloud with passthrough filtering (falling back to
+ * conversion through PCL Pointcloud2 for unrecognised layouts, and keeping the organized
+ * cloud for organized clustering), a downsampling step with statistical outlier removal that
+ * only crops the points again if they were not cropped while reading, and plane segmentation,
+ * which keeps the support plane of the previous cloud when plane tracking is enabled.
  * @param msg Pointcloud input
  ******************************************************************************/
 template<typename T>
@@ -554,40 +867,85 @@ void grasp_planner::GraspScene<T>::processPointCloud(
   const sensor_msgs::msg::PointCloud2::ConstSharedPtr & msg)
 {
   RCLCPP_INFO(LOGGER, "Processing Point Cloud... ");
-  pcl::PCLPointCloud2 * pcl_pc2(new pcl::PCLPointCloud2);
-  PCLFunctions::SensorMsgtoPCLPointCloud2(*msg, *pcl_pc2);
-  pcl::fromPCLPointCloud2(*pcl_pc2, *(this->cloud));
-  RCLCPP_INFO(LOGGER, "Applying Passthrough filters");
-  PCLFunctions::passthroughFilter(
-    this->cloud,
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_x").
-    as_double_array()[0]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_y").
-    as_double_array()[0]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
-    as_double_array()[1]),
-    static_cast<float>(node->get_parameter("point_cloud_params.passthrough_filter_limits_z").
-    as_double_array()[0]));
-  RCLCPP_INFO(LOGGER, "Removing Statistical Outlier");
-  PCLFunctions::removeStatisticalOutlier(this->cloud, 1.0);
-  RCLCPP_INFO(LOGGER, "Downsampling Point Cloud");
-  PCLFunctions::voxelizeCloud
-  <pcl::PointCloud<pcl::PointXYZRGB>::Ptr, pcl::VoxelGrid<pcl::PointXYZRGB>>(
-    this->cloud,
-    static_cast<float>(node->get_parameter(
-      "point_cloud_params.fcl_voxel_size").as_double()),
-    this->org_cloud);
+  const std::vector<double> limits_x = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_x").as_double_array();
+  const std::vector<double> limits_y = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_y").as_double_array();
+  const std::vector<double> limits_z = node->get_parameter(
+    "point_cloud_params.passthrough_filter_limits_z").as_double_array();
+
+  this->organized_cloud->clear();
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr input_cloud = this->cloud;
+  // True once the points have been cropped and NaN points dropped while reading them
+  bool input_filtered = false;
+  // Keep the image layout for clustering, with the dropped points set to NaN
+  const bool keep_organized = msg->height > 1 &&
+    node->get_parameter_or(
+    "point_cloud_params.clustering_method", std::string("euclidean")) == "organized";
+  if (PCLFunctions::SensorMsgtoFilteredPointCloud(
+      *msg, this->cloud,
+      static_cast<float>(limits_x[1]), static_cast<float>(limits_x[0]),
+      static_cast<float>(limits_y[1]), static_cast<float>(limits_y[0]),
+      static_cast<float>(limits_z[1]), static_cast<float>(limits_z[0]),
+      keep_organized ? this->organized_cloud : nullptr))
+  {
+    // Read and filter the points directly from the message buffer where the layout allows it
+    input_filtered = true;
+  } else {
+    RCLCPP_INFO(LOGGER, "Unrecognised point cloud layout, using PCLPointCloud2 conversion");
+    pcl::PCLPointCloud2 pcl_pc2;
+    PCLFunctions::SensorMsgtoPCLPointCloud2(*msg, pcl_pc2);
+    if (keep_organized) {
+      // The filtered cloud is cropped from the organized cloud below
+      pcl::fromPCLPointCloud2(pcl_pc2, *(this->organized_cloud));
+      input_cloud = this->organized_cloud;
+    } else {
+      pcl::fromPCLPointCloud2(pcl_pc2, *(this->cloud));
+    }
+  }
+  RCLCPP_INFO(LOGGER, "Filtering and downsampling Point Cloud");
+  const float fcl_voxel_size = static_cast<float>(node->get_parameter(
+      "point_cloud_params.fcl_voxel_size").as_double());
+  const int preprocessing_threads = static_cast<int>(node->get_parameter_or(
+      "point_cloud_params.preprocessing_threads", static_cast<int64_t>(1)));
+  if (input_filtered) {
+    PCLFunctions::downsampleCloud(
+      input_cloud, 1.0, fcl_voxel_size, this->cloud, this->org_cloud, preprocessing_threads);
+  } else {
+    PCLFunctions::preprocessCloud(
+      input_cloud,
+      static_cast<float>(limits_x[1]), static_cast<float>(limits_x[0]),
+      static_cast<float>(limits_y[1]), static_cast<float>(limits_y[0]),
+      static_cast<float>(limits_z[1]), static_cast<float>(limits_z[0]),
+      1.0, fcl_voxel_size, this->cloud, this->org_cloud, preprocessing_threads);
+  }
   RCLCPP_INFO(LOGGER, "Segmenting plane");
-  PCLFunctions::planeSegmentation(
-    this->cloud, this->cloud_plane_removed, this->cloud_table,
-    node->get_parameter(
-      "point_cloud_params.segmentation_max_iterations").as_int(),
-    static_cast<float>(node->get_parameter(
-      "point_cloud_params.segmentation_distance_threshold").as_double()));
+  if (!node->get_parameter_or("point_cloud_params.plane_tracking", false)) {
+    this->plane_tracker.reset();
+    PCLFunctions::planeSegmentation(
+      this->cloud, this->cloud_plane_removed, this->cloud_table, *(this->table_coeff),
+      node->get_parameter(
+        "point_cloud_params.segmentation_max_iterations").as_int(),
+      static_cast<float>(node->get_parameter(
+        "point_cloud_params.segmentation_distance_threshold").as_double()));
+  } else {
+    this->plane_tracker.setValidation(
+      node->get_parameter_or(
+        "point_cloud_params.plane_tracking_sample_size", static_cast<int64_t>(500)),
+      static_cast<float>(node->get_parameter_or(
+        "point_cloud_params.plane_tracking_min_inlier_ratio", 0.8)));
+    if (this->plane_tracker.segment(
+        this->cloud, this->cloud_plane_removed, this->cloud_table, *(this->table_coeff),
+        node->get_parameter(
+          "point_cloud_params.segmentation_max_iterations").as_int(),
+        static_cast<float>(node->get_parameter(
+          "point_cloud_params.segmentation_distance_threshold").as_double())))
+    {
+      RCLCPP_INFO(
+        LOGGER, this->plane_tracker.lastPlaneTracked() ?
+        "Kept the tracked support plane" : "Fitted a new support plane");
+    }
+  }
   RCLCPP_INFO(LOGGER, "Point cloud successfully processed!");
 }
 
@@ -601,7 +959,9 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::startPlanning(
 {
   RCLCPP_INFO(LOGGER, "Perception input received!");
   processPointCloud(msg);
-  createWorldCollision(msg);
+  if (!createWorldCollision(msg)) {
+    return;
+  }
   extractObjects(msg);
   // loadEndEffectors();
   emd_msgs::msg::GraspTask grasp_task = generateGraspTask();
@@ -617,7 +977,15 @@ template<typename T>
 void grasp_planner::GraspScene<T>::startPlanning(const typename T::ConstSharedPtr & msg)
 {
   RCLCPP_INFO(LOGGER, "Perception input received!");
-  createWorldCollision(msg);
+  if (!this->depth_projector.hasCameraModel()) {
+    RCLCPP_WARN(LOGGER, "No camera info received yet, skipping perception input.");
+    triggerEPDPipeline();
+    return;
+  }
+  if (!createWorldCollision(msg)) {
+    triggerEPDPipeline();
+    return;
+  }
   extractObjects(msg);
   // loadEndEffectors();
   emd_msgs::msg::GraspTask grasp_task = generateGraspTask();
@@ -633,6 +1001,8 @@ void grasp_planner::GraspScene<T>::startPlanning(const typename T::ConstSharedPt
 template<>
 void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::setup(std::string topic_name)
 {
+  grasp_planner::ThreadPool::setGlobalThreads(
+    static_cast<int>(this->node->get_parameter_or("planning_threads", static_cast<int64_t>(1))));
   this->output_client =
     this->node->create_client<emd_msgs::srv::GraspRequest>(
     this->node->get_parameter("grasp_output_service").as_string());
@@ -664,6 +1034,8 @@ void grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2>::setup(std::string
 template<typename T>
 void grasp_planner::GraspScene<T>::setup(std::string topic_name)
 {
+  grasp_planner::ThreadPool::setGlobalThreads(
+    static_cast<int>(this->node->get_parameter_or("planning_threads", static_cast<int64_t>(1))));
   this->output_client =
     this->node->template create_client<emd_msgs::srv::GraspRequest>(
     this->node->get_parameter("grasp_output_service").as_string());
@@ -673,6 +1045,17 @@ void grasp_planner::GraspScene<T>::setup(std::string topic_name)
     this->node->get_parameter("easy_perception_deployment.epd_service").as_string());
   //this->node->get_parameter("epd_service").as_string());
 
+  this->camera_info_sub = this->node->template create_subscription<sensor_msgs::msg::CameraInfo>(
+    this->node->get_parameter_or(
+      "camera_parameters.camera_info_topic",
+      std::string("/camera/aligned_depth_to_color/camera_info")), 1,
+    [this](const sensor_msgs::msg::CameraInfo::SharedPtr camera_info) {
+      if (this->depth_projector.setCameraInfo(*camera_info)) {
+        RCLCPP_INFO(
+          LOGGER, "Camera model updated: %dx%d", camera_info->width, camera_info->height);
+      }
+    });
+
   RCLCPP_INFO_STREAM(LOGGER, "Listening to: " << topic_name << "...");
   this->perception_sub = std::make_shared<
     message_filters::Subscriber<T>>(
@@ -0,0 +1,143 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include "emd/common/contact_raster.hpp"
+
+namespace
+{
+/* Points at the centers of the millimetre cells of a 30 x 20 mm patch with a 6 x 6 mm hole,
+   with a curvature that varies across the patch */
+void generateRasterTestPoints(
+  std::vector<Eigen::Vector2f> & points,
+  std::vector<float> & curvatures)
+{
+  for (int x = -10; x < 20; x++) {
+    for (int y = -5; y < 15; y++) {
+      if (x >= 0 && x < 6 && y >= 0 && y < 6) {
+        continue;
+      }
+      points.push_back(Eigen::Vector2f(x + 0.5, y + 0.5) * 0.001);
+      curvatures.push_back(0.01 * ((x * 7 + y * 3) % 11));
+    }
+  }
+}
+
+int scanRasterDisc(
+  const std::vector<Eigen::Vector2f> & points,
+  const std::vector<float> & curvatures,
+  const Eigen::Vector2f & center, float radius, float & curvature_sum)
+{
+  int count = 0;
+  curvature_sum = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if ((points[i] - center).squaredNorm() <= radius * radius) {
+      count++;
+      curvature_sum += curvatures[i];
+    }
+  }
+  return count;
+}
+}  // namespace
+
+TEST(ContactRasterTest, DiscSumMatchesScan)
+{
+  std::vector<Eigen::Vector2f> points;
+  std::vector<float> curvatures;
+  generateRasterTestPoints(points, curvatures);
+  grasp_planner::ContactRaster raster;
+  // A radius between cell distances, so that no point lies on the edge of a disc
+  const float radius = 0.0047;
+  ASSERT_TRUE(raster.build(points, curvatures, 0.001, radius));
+  EXPECT_FALSE(raster.empty());
+  EXPECT_FLOAT_EQ(0.001, raster.getResolution());
+  EXPECT_FLOAT_EQ(radius, raster.getRadius());
+
+  // Disc centers on cell centers, including ones beyond the padding of the raster
+  for (int x = -20; x < 30; x++) {
+    for (int y = -15; y < 25; y++) {
+      const Eigen::Vector2f center = Eigen::Vector2f(x + 0.5, y + 0.5) * 0.001;
+      float expected_curvature;
+      const int expected = scanRasterDisc(points, curvatures, center, radius, expected_curvature);
+      float curvature_sum;
+      EXPECT_EQ(expected, raster.discSum(center, curvature_sum));
+      EXPECT_NEAR(expected_curvature, curvature_sum, 1e-4);
+    }
+  }
+  float curvature_sum;
+  EXPECT_EQ(0, raster.discSum(Eigen::Vector2f(1.0, 1.0), curvature_sum));
+  EXPECT_FLOAT_EQ(0, curvature_sum);
+}
+
+TEST(ContactRasterTest, BoxSum)
+{
+  std::vector<Eigen::Vector2f> points;
+  std::vector<float> curvatures;
+  generateRasterTestPoints(points, curvatures);
+  grasp_planner::ContactRaster raster;
+  ASSERT_TRUE(raster.build(points, curvatures, 0.001, 0.002));
+
+  float total_curvature = 0;
+  for (float curvature : curvatures) {
+    total_curvature += curvature;
+  }
+  float curvature_sum;
+  EXPECT_EQ(
+    static_cast<int>(points.size()),
+    raster.boxSum(Eigen::Vector2i(-5, -5), raster.getDims() + Eigen::Vector2i(5, 5),
+    curvature_sum));
+  EXPECT_NEAR(total_curvature, curvature_sum, 1e-3);
+
+  // The hole, and the patch from the hole to its upper corner
+  const Eigen::Vector2i hole = raster.getCell(Eigen::Vector2f(0.0005, 0.0005));
+  EXPECT_EQ(0, raster.boxSum(hole, hole + Eigen::Vector2i(6, 6), curvature_sum));
+  EXPECT_FLOAT_EQ(0, curvature_sum);
+  EXPECT_EQ(20 * 15 - 36, raster.boxSum(hole, hole + Eigen::Vector2i(20, 15), curvature_sum));
+  EXPECT_EQ(0, raster.boxSum(hole, hole, curvature_sum));
+}
+
+TEST(ContactRasterTest, EmptyAndInvalid)
+{
+  grasp_planner::ContactRaster raster;
+  float curvature_sum;
+  EXPECT_TRUE(raster.empty());
+  EXPECT_EQ(0, raster.discSum(Eigen::Vector2f(0, 0), curvature_sum));
+
+  std::vector<Eigen::Vector2f> points;
+  std::vector<float> curvatures;
+  EXPECT_TRUE(raster.build(points, curvatures, 0.001, 0.005));
+  EXPECT_TRUE(raster.empty());
+
+  // Points that are not finite are skipped, and so are curvatures that are not finite
+  points.push_back(Eigen::Vector2f(std::nanf(""), 0));
+  curvatures.push_back(1);
+  points.push_back(Eigen::Vector2f(0.0005, 0.0005));
+  curvatures.push_back(std::nanf(""));
+  ASSERT_TRUE(raster.build(points, curvatures, 0.001, 0.005));
+  EXPECT_EQ(1, raster.discSum(Eigen::Vector2f(0.0005, 0.0005), curvature_sum));
+  EXPECT_FLOAT_EQ(0, curvature_sum);
+
+  EXPECT_FALSE(raster.build(points, curvatures, 0, 0.005));
+  EXPECT_FALSE(raster.build(points, curvatures, 0.001, -0.005));
+  curvatures.pop_back();
+  EXPECT_FALSE(raster.build(points, curvatures, 0.001, 0.005));
+  EXPECT_TRUE(raster.empty());
+
+  // Too many cells
+  points = {Eigen::Vector2f(0, 0), Eigen::Vector2f(1, 1)};
+  curvatures = {0, 0};
+  EXPECT_FALSE(raster.build(points, curvatures, 0.001, 0.005, 1000));
+  EXPECT_TRUE(raster.empty());
+}
@@ -0,0 +1,127 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include "emd/common/depth_projection.hpp"
+
+namespace
+{
+sensor_msgs::msg::CameraInfo createCameraInfo(uint32_t width, uint32_t height)
+{
+  sensor_msgs::msg::CameraInfo camera_info;
+  camera_info.width = width;
+  camera_info.height = height;
+  camera_info.distortion_model = "plumb_bob";
+  camera_info.d = {0.0, 0.0, 0.0, 0.0, 0.0};
+  camera_info.k = {500.0, 0.0, width / 2.0, 0.0, 500.0, height / 2.0, 0.0, 0.0, 1.0};
+  return camera_info;
+}
+
+sensor_msgs::msg::Image createDepthImage(uint32_t width, uint32_t height, uint16_t depth_mm)
+{
+  sensor_msgs::msg::Image depth_image;
+  depth_image.width = width;
+  depth_image.height = height;
+  depth_image.encoding = "16UC1";
+  depth_image.is_bigendian = false;
+  depth_image.step = width * sizeof(uint16_t);
+  depth_image.data.resize(depth_image.step * height);
+  for (uint32_t i = 0; i < width * height; i++) {
+    // Every third pixel has no depth reading
+    uint16_t depth = (i % 3 == 0) ? 0 : depth_mm;
+    std::memcpy(depth_image.data.data() + i * sizeof(uint16_t), &depth, sizeof(uint16_t));
+  }
+  return depth_image;
+}
+}  // namespace
+
+TEST(DepthProjectionTest, NoCameraModel)
+{
+  grasp_planner::DepthProjector projector;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_FALSE(projector.hasCameraModel());
+  EXPECT_FALSE(
+    projector.projectDepthImage(
+      createDepthImage(8, 6, 500), cloud, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, false));
+}
+
+TEST(DepthProjectionTest, SetCameraInfoRebuildsOnChange)
+{
+  grasp_planner::DepthProjector projector;
+  sensor_msgs::msg::CameraInfo camera_info = createCameraInfo(8, 6);
+  EXPECT_TRUE(projector.setCameraInfo(camera_info));
+  EXPECT_FALSE(projector.setCameraInfo(camera_info));
+  EXPECT_TRUE(projector.hasCameraModel());
+  EXPECT_EQ(projector.ray_x.size(), 48u);
+
+  camera_info.k[0] = 600.0;
+  EXPECT_TRUE(projector.setCameraInfo(camera_info));
+  EXPECT_NEAR(projector.ray_x[0], -4.0 / 600.0, 1e-6);
+  EXPECT_NEAR(projector.ray_y[0], -3.0 / 500.0, 1e-6);
+}
+
+TEST(DepthProjectionTest, ProjectUnorganized)
+{
+  grasp_planner::DepthProjector projector;
+  projector.setCameraInfo(createCameraInfo(8, 6));
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_TRUE(
+    projector.projectDepthImage(
+      createDepthImage(8, 6, 500), cloud, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, false));
+
+  // Pixels without depth are skipped
+  EXPECT_EQ(cloud->points.size(), 32u);
+  EXPECT_EQ(cloud->height, 1u);
+  for (auto point : cloud->points) {
+    EXPECT_NEAR(point.z, 0.5, 1e-6);
+  }
+  // Second pixel of the first row
+  EXPECT_NEAR(cloud->points[0].x, (1 - 4.0) / 500.0 * 0.5, 1e-6);
+  EXPECT_NEAR(cloud->points[0].y, (0 - 3.0) / 500.0 * 0.5, 1e-6);
+
+  // Depth outside the crop limits is skipped
+  EXPECT_TRUE(
+    projector.projectDepthImage(
+      createDepthImage(8, 6, 500), cloud, 1.0, -1.0, 1.0, -1.0, 0.4, 0.0, false));
+  EXPECT_EQ(cloud->points.size(), 0u);
+}
+
+TEST(DepthProjectionTest, ProjectOrganized)
+{
+  grasp_planner::DepthProjector projector;
+  projector.setCameraInfo(createCameraInfo(8, 6));
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_TRUE(
+    projector.projectDepthImage(
+      createDepthImage(8, 6, 500), cloud, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, true));
+
+  EXPECT_EQ(cloud->width, 8u);
+  EXPECT_EQ(cloud->height, 6u);
+  EXPECT_EQ(cloud->points.size(), 48u);
+  EXPECT_TRUE(std::isnan(cloud->points[0].z));
+  EXPECT_NEAR(cloud->points[1].z, 0.5, 1e-6);
+}
+
+TEST(DepthProjectionTest, ImageSizeMismatch)
+{
+  grasp_planner::DepthProjector projector;
+  projector.setCameraInfo(createCameraInfo(8, 6));
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_FALSE(
+    projector.projectDepthImage(
+      createDepthImage(6, 8, 500), cloud, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, false));
+}
@@ -13,6 +13,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <gtest/gtest.h>
 #include "emd/common/fcl_functions.hpp"
 
@@ -240,3 +241,80 @@ TEST(FCLFunctionTest, RGBCollisionTestNoCollide)
   //   const octomap::point3d & sensor_origin_wrt_world,
   //   float resolution)
 }
+
+TEST(FCLFunctionTest, IntegrationKeysThreadInvariant)
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(
+    new pcl::PointCloud<pcl::PointXYZ>());
+
+  for (float x = -0.1; x < 0.1; x += 0.002) {
+    for (float y = -0.1; y < 0.1; y += 0.002) {
+      pcl::PointXYZ temp_point;
+      temp_point.x = x;
+      temp_point.y = y;
+      temp_point.z = (std::abs(x) < 0.03 && std::abs(y) < 0.03) ? 0.45 : 0.5;
+      cloud->points.push_back(temp_point);
+    }
+  }
+
+  octomap::point3d sensor_origin(0, 0, 0);
+  octomap::OcTree octree(0.005);
+
+  FCLFunctions::IntegrationKeys single_thread_keys;
+  FCLFunctions::computeIntegrationKeys(
+    octree, *cloud, sensor_origin, 1, single_thread_keys);
+  FCLFunctions::IntegrationKeys multi_thread_keys;
+  FCLFunctions::computeIntegrationKeys(
+    octree, *cloud, sensor_origin, 4, multi_thread_keys);
+
+  EXPECT_FALSE(single_thread_keys.occupied_cells.empty());
+  EXPECT_FALSE(single_thread_keys.free_cells.empty());
+  EXPECT_TRUE(single_thread_keys.occupied_cells == multi_thread_keys.occupied_cells);
+  EXPECT_TRUE(single_thread_keys.free_cells == multi_thread_keys.free_cells);
+}
+
+TEST(FCLFunctionTest, SurfaceKeysOcclusion)
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(
+    new pcl::PointCloud<pcl::PointXYZ>());
+
+  for (float x = -0.05; x < 0.05; x += 0.0025) {
+    for (float y = -0.05; y < 0.05; y += 0.0025) {
+      pcl::PointXYZ temp_point;
+      temp_point.x = x;
+      temp_point.y = y;
+      temp_point.z = 0.5;
+      cloud->points.push_back(temp_point);
+    }
+  }
+
+  octomap::point3d sensor_origin(0, 0, 0);
+  octomap::OcTree octree(0.005);
+
+  FCLFunctions::IntegrationKeys surface_keys;
+  FCLFunctions::computeSurfaceKeys(
+    octree, *cloud, sensor_origin, 2, 0.0, surface_keys);
+  FCLFunctions::IntegrationKeys occluded_keys;
+  FCLFunctions::computeSurfaceKeys(
+    octree, *cloud, sensor_origin, 2, 0.02, occluded_keys);
+
+  EXPECT_TRUE(surface_keys.free_cells.empty());
+  EXPECT_TRUE(occluded_keys.free_cells.empty());
+  EXPECT_GT(occluded_keys.occupied_cells.size(), surface_keys.occupied_cells.size());
+
+  // The cell behind the centre of the surface is occupied only with occlusion
+  octomap::OcTreeKey behind_key = octree.coordToKey(octomap::point3d(0, 0, 0.51));
+  EXPECT_TRUE(
+    std::find(
+      surface_keys.occupied_cells.begin(), surface_keys.occupied_cells.end(),
+      behind_key) == surface_keys.occupied_cells.end());
+  EXPECT_TRUE(
+    std::find(
+      occluded_keys.occupied_cells.begin(), occluded_keys.occupied_cells.end(),
+      behind_key) != occluded_keys.occupied_cells.end());
+
+  EXPECT_TRUE(
+    FCLFunctions::getIntegrationMode("occupied_only") ==
+    FCLFunctions::IntegrationMode::OCCUPIED_ONLY);
+  EXPECT_THROW(FCLFunctions::getIntegrationMode("unknown"), std::invalid_argument);
+}
@@ -263,3 +263,31 @@ TEST_F(GraspObjectTest, getAxisTest)
   EXPECT_TRUE(object->getAxis({0, 1, 0}) == 'y');
   EXPECT_TRUE(object->getAxis({0, 0, 1}) == 'z');
 }
+
+TEST_F(GraspObjectTest, getCloudSearchTest)
+{
+  GenerateObjectCloud(0.05, 0.01, 0.02);
+  Eigen::Vector4f centroid;
+  pcl::compute3DCentroid(*object_cloud, centroid);
+  GraspObject object_("camera_frame", object_cloud, centroid);
+  object = std::make_shared<GraspObject>(object_);
+  PCLFunctions::computeCloudNormal(object->cloud, object->cloud_normal, 0.03);
+
+  // Trees are built once and shared by later queries
+  pcl::search::KdTree<pcl::PointXYZRGB>::Ptr cloud_search = object->getCloudSearch();
+  EXPECT_TRUE(cloud_search == object->getCloudSearch());
+  pcl::search::KdTree<pcl::PointNormal>::Ptr normal_search = object->getNormalCloudSearch();
+  EXPECT_TRUE(normal_search == object->getNormalCloudSearch());
+  EXPECT_TRUE(normal_search->getInputCloud() == object->cloud_normal);
+
+  std::vector<int> indices;
+  std::vector<float> sq_distances;
+  EXPECT_EQ(1, cloud_search->nearestKSearch(object->cloud->points[5], 1, indices, sq_distances));
+  EXPECT_EQ(5, indices[0]);
+
+  // A resized cloud gets a new tree
+  pcl::PointXYZRGB extra_point;
+  extra_point.x = 1.0;
+  object->cloud->points.push_back(extra_point);
+  EXPECT_FALSE(cloud_search == object->getCloudSearch());
+}
@@ -24,6 +24,84 @@ GraspSceneTest::GraspSceneTest()
   node = rclcpp::Node::make_shared("grasp_scene_test", "", node_options);
 }
 
+void GraspSceneTest::DeclareFingerGripper(
+  const std::string & end_effector, double gripper_stroke)
+{
+  const std::string prefix = "end_effectors." + end_effector + ".";
+  node->set_parameters(
+  {
+    rclcpp::Parameter(prefix + "type", "finger"),
+    rclcpp::Parameter(prefix + "num_fingers_side_1", 1),
+    rclcpp::Parameter(prefix + "num_fingers_side_2", 1),
+    rclcpp::Parameter(prefix + "distance_between_fingers_1", 0.0),
+    rclcpp::Parameter(prefix + "distance_between_fingers_2", 0.0),
+    rclcpp::Parameter(prefix + "finger_thickness", 0.02),
+    rclcpp::Parameter(prefix + "gripper_stroke", gripper_stroke),
+    rclcpp::Parameter(prefix + "gripper_coordinate_system.grasp_stroke_direction", "x"),
+    rclcpp::Parameter(prefix + "gripper_coordinate_system.grasp_stroke_normal_direction", "y"),
+    rclcpp::Parameter(prefix + "gripper_coordinate_system.grasp_approach_direction", "z"),
+    rclcpp::Parameter(prefix + "grasp_planning_params.grasp_plane_dist_limit", 0.007),
+    rclcpp::Parameter(prefix + "grasp_planning_params.voxel_size", 0.01),
+    rclcpp::Parameter(prefix + "grasp_planning_params.grasp_rank_weight_1", 1.5),
+    rclcpp::Parameter(prefix + "grasp_planning_params.grasp_rank_weight_2", 1.0),
+    rclcpp::Parameter(prefix + "grasp_planning_params.world_x_angle_threshold", 0.5),
+    rclcpp::Parameter(prefix + "grasp_planning_params.world_y_angle_threshold", 0.5),
+    rclcpp::Parameter(prefix + "grasp_planning_params.world_z_angle_threshold", 0.25)
+  });
+}
+
+TEST_F(GraspSceneTest, loadEndEffectorsCacheTest)
+{
+  node->set_parameter(rclcpp::Parameter("point_cloud_params.cloud_normal_radius", 0.03));
+  node->set_parameter(
+    rclcpp::Parameter(
+      "end_effectors.end_effector_names",
+      std::vector<std::string>{"gripper_a", "gripper_b"}));
+  DeclareFingerGripper("gripper_a", 0.09);
+  DeclareFingerGripper("gripper_b", 0.09);
+
+  grasp_planner::GraspScene<sensor_msgs::msg::PointCloud2> scene(node);
+  scene.loadEndEffectors();
+  ASSERT_EQ(2u, scene.end_effectors.size());
+  std::vector<std::shared_ptr<FingerGripper>> loaded = scene.end_effectors;
+  EXPECT_EQ("gripper_a", loaded[0]->getID());
+  EXPECT_EQ("gripper_b", loaded[1]->getID());
+
+  // Loading again without parameter changes keeps the same instances
+  scene.loadEndEffectors();
+  ASSERT_EQ(2u, scene.end_effectors.size());
+  EXPECT_TRUE(loaded[0] == scene.end_effectors[0]);
+  EXPECT_TRUE(loaded[1] == scene.end_effectors[1]);
+
+  // A parameter of one gripper only marks that gripper stale
+  node->set_parameter(rclcpp::Parameter("end_effectors.gripper_b.gripper_stroke", 0.12));
+  EXPECT_FALSE(scene.all_end_effectors_stale);
+  EXPECT_EQ(std::set<std::string>{"gripper_b"}, scene.stale_end_effectors);
+
+  scene.loadEndEffectors();
+  ASSERT_EQ(2u, scene.end_effectors.size());
+  EXPECT_TRUE(loaded[0] == scene.end_effectors[0]);
+  EXPECT_FALSE(loaded[1] == scene.end_effectors[1]);
+  EXPECT_EQ("gripper_b", scene.end_effectors[1]->getID());
+  EXPECT_FLOAT_EQ(0.12, scene.end_effectors[1]->gripper_stroke);
+  EXPECT_TRUE(scene.stale_end_effectors.empty());
+
+  // A rejected parameter does not mark anything stale
+  EXPECT_FALSE(
+    node->set_parameter(
+      rclcpp::Parameter("end_effectors.gripper_a.finger_thickness", 0.0)).successful);
+  EXPECT_FALSE(
+    node->set_parameter(
+      rclcpp::Parameter("end_effectors.gripper_a.gripper_stroke", "wide")).successful);
+  EXPECT_FALSE(
+    node->set_parameter(
+      rclcpp::Parameter("point_cloud_params.cloud_normal_radius", "small")).successful);
+  EXPECT_FALSE(scene.all_end_effectors_stale);
+  EXPECT_TRUE(scene.stale_end_effectors.empty());
+  EXPECT_FLOAT_EQ(
+    0.02, node->get_parameter("end_effectors.gripper_a.finger_thickness").as_double());
+}
+
 // // Uncomment once Visualizer is removed from the graspScene class
 // TEST_F(GraspSceneTest, PrintPoseTest)
 // {
@@ -26,6 +26,7 @@
 #include <iostream>
 #include <cmath>
 #include <memory>
+#include <set>
 #include <string>
 #include <vector>
 #include <limits>
@@ -44,6 +45,7 @@ public:
 
   GraspSceneTest();
   void GenerateSceneCloud(float length, float breadth, float height);
+  void DeclareFingerGripper(const std::string & end_effector, double gripper_stroke);
 
   void SetUp(void)
   {
@@ -21,6 +21,12 @@
 #include "fcl_functions_test.cpp"
 #include "grasp_object_test.cpp"
 #include "grasp_scene_test.cpp"
+#include "depth_projection_test.cpp"
+#include "world_model_test.cpp"
+#include "plane_tracker_test.cpp"
+#include "thread_pool_test.cpp"
+#include "occupancy_grid_test.cpp"
+#include "contact_raster_test.cpp"
 
 int
 main(int argc, char ** argv)
@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
 #include "emd/common/math_functions.hpp"
 
 TEST(MathFunctionTest, NormalizeTest)
@@ -139,3 +141,14 @@ TEST(MathFunctionTest, generateTaskIdTest)
   }
 
 }
+
+TEST(MathFunctionTest, getTopRankIndicesTest)
+{
+  const std::vector<float> ranks{0.5, -1.0, std::nanf(""), 2.0, 0.5, -3.0};
+  EXPECT_EQ(
+    std::vector<size_t>({3, 0, 4, 1, 5}), MathFunctions::getTopRankIndices(ranks, 0));
+  EXPECT_EQ(std::vector<size_t>({3, 0}), MathFunctions::getTopRankIndices(ranks, 2));
+  EXPECT_EQ(
+    std::vector<size_t>({3, 0, 4, 1, 5}), MathFunctions::getTopRankIndices(ranks, 10));
+  EXPECT_TRUE(MathFunctions::getTopRankIndices({}, 3).empty());
+}
@@ -66,6 +66,7 @@ void MultiFingerTest::LoadGripper()
     grasp_approach_direction);
   gripper_.generateGripperAttributes();
   gripper = std::make_shared<FingerGripper>(gripper_);
+  context = FingerPlanningContext();
 }
 
 void MultiFingerTest::GenerateObjectHorizontal()
@@ -392,18 +393,18 @@ TEST_F(MultiFingerTest, AddPlaneTestInside1)
   float dist = 0.01;
   Eigen::Vector4f centerpoint(0, 0, 0, 0);
   Eigen::Vector4f plane_vector(2, -8, 5, 18);
-  gripper->addPlane(dist, centerpoint, plane_vector, true, false);
-  EXPECT_EQ(1, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(0, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector, true, false);
+  EXPECT_EQ(1, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(1, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(0, static_cast<int>(context.plane_2_index.size()));
 
   Eigen::Vector4f plane_vector2(-12, 3, -18, 129);
-  gripper->addPlane(dist, centerpoint, plane_vector2, true, true);
-  EXPECT_EQ(2, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(2, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector2, true, true);
+  EXPECT_EQ(2, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(2, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_2_index.size()));
 }
 
 TEST_F(MultiFingerTest, AddPlaneTestInside2)
@@ -413,18 +414,18 @@ TEST_F(MultiFingerTest, AddPlaneTestInside2)
   float dist = 0.01;
   Eigen::Vector4f centerpoint(0, 0, 0, 0);
   Eigen::Vector4f plane_vector(2, -8, 5, 18);
-  gripper->addPlane(dist, centerpoint, plane_vector, false, true);
-  EXPECT_EQ(1, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(0, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector, false, true);
+  EXPECT_EQ(1, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(1, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(0, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_2_index.size()));
 
   Eigen::Vector4f plane_vector2(-12, 3, -18, 129);
-  gripper->addPlane(dist, centerpoint, plane_vector2, true, true);
-  EXPECT_EQ(2, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(2, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(2, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector2, true, true);
+  EXPECT_EQ(2, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(2, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(2, static_cast<int>(context.plane_2_index.size()));
 }
 
 TEST_F(MultiFingerTest, AddPlaneTestInsideBoth)
@@ -434,18 +435,18 @@ TEST_F(MultiFingerTest, AddPlaneTestInsideBoth)
   float dist = 0.01;
   Eigen::Vector4f centerpoint(0, 0, 0, 0);
   Eigen::Vector4f plane_vector(2, -8, 5, 18);
-  gripper->addPlane(dist, centerpoint, plane_vector, true, true);
-  EXPECT_EQ(1, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector, true, true);
+  EXPECT_EQ(1, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(1, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_2_index.size()));
 
   Eigen::Vector4f plane_vector2(-12, 3, -18, 129);
-  gripper->addPlane(dist, centerpoint, plane_vector2, false, false);
-  EXPECT_EQ(2, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(2, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_1_index.size()));
-  EXPECT_EQ(1, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->addPlane(context, dist, centerpoint, plane_vector2, false, false);
+  EXPECT_EQ(2, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(2, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_1_index.size()));
+  EXPECT_EQ(1, static_cast<int>(context.plane_2_index.size()));
 }
 
 
@@ -456,23 +457,23 @@ TEST_F(MultiFingerTest, CheckPlaneExistsTest)
   float dist = 0.01;
   Eigen::Vector4f centerpoint(0, 0, 0, 0);
   Eigen::Vector4f plane_vector(2, -8, 5, 18);
-  gripper->addPlane(dist, centerpoint, plane_vector, true, true);
+  gripper->addPlane(context, dist, centerpoint, plane_vector, true, true);
 
   float dist2 = 0.03;
   Eigen::Vector4f centerpoint2(0.01, 0.02, -0.03, 0);
   Eigen::Vector4f plane_vector2(2, -8, 5, 18);
-  gripper->addPlane(dist2, centerpoint2, plane_vector2, false, true);
+  gripper->addPlane(context, dist2, centerpoint2, plane_vector2, false, true);
 
   float dist3 = 0.05;
   Eigen::Vector4f centerpoint3(0, 0.02, -0.03, 0);
   Eigen::Vector4f plane_vector3(2, -8, 5, 1);
-  gripper->addPlane(dist3, centerpoint3, plane_vector3, false, false);
+  gripper->addPlane(context, dist3, centerpoint3, plane_vector3, false, false);
 
 
-  EXPECT_EQ(0, gripper->checkPlaneExists(0.01));
-  EXPECT_EQ(1, gripper->checkPlaneExists(0.03));
-  EXPECT_EQ(2, gripper->checkPlaneExists(0.05));
-  EXPECT_EQ(-1, gripper->checkPlaneExists(0.07));
+  EXPECT_EQ(0, gripper->checkPlaneExists(context, 0.01));
+  EXPECT_EQ(1, gripper->checkPlaneExists(context, 0.03));
+  EXPECT_EQ(2, gripper->checkPlaneExists(context, 0.05));
+  EXPECT_EQ(-1, gripper->checkPlaneExists(context, 0.07));
 }
 
 
@@ -481,7 +482,7 @@ TEST_F(MultiFingerTest, GetCenterCuttingPlaneCheck)
   GenerateObjectHorizontal();
   ResetVariables();
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
+  gripper->getCenterCuttingPlane(context, object);
   Eigen::Vector3f centerpoint(object->centerpoint(0),
     object->centerpoint(1),
     object->centerpoint(2));
@@ -489,9 +490,9 @@ TEST_F(MultiFingerTest, GetCenterCuttingPlaneCheck)
   Eigen::Vector3f vector_on_plane2 = object->grasp_axis - centerpoint;
   Eigen::Vector3f vector_on_plane3 = object->axis - centerpoint;
 
-  Eigen::Vector3f center_cutting_plane_normal(gripper->center_cutting_plane_normal(0),
-    gripper->center_cutting_plane_normal(1),
-    gripper->center_cutting_plane_normal(2));
+  Eigen::Vector3f center_cutting_plane_normal(context.center_cutting_plane_normal(0),
+    context.center_cutting_plane_normal(1),
+    context.center_cutting_plane_normal(2));
   float dot_pdt1 = vector_on_plane.dot(center_cutting_plane_normal);
   float dot_pdt2 = vector_on_plane2.dot(center_cutting_plane_normal);
   float dot_pdt3 = vector_on_plane3.dot(center_cutting_plane_normal);
@@ -500,9 +501,9 @@ TEST_F(MultiFingerTest, GetCenterCuttingPlaneCheck)
   ASSERT_GT(dot_pdt3, 0);
 
   // pcl::PointXYZ vector1(vector_on_plane(0), vector_on_plane(1), vector_on_plane(2));
-  // pcl::PointXYZ vector2(gripper->center_cutting_plane_normal(0),
-  //  gripper->center_cutting_plane_normal(1),
-  //  gripper->center_cutting_plane_normal(2));
+  // pcl::PointXYZ vector2(context.center_cutting_plane_normal(0),
+  //  context.center_cutting_plane_normal(1),
+  //  context.center_cutting_plane_normal(2));
   // pcl::PointXYZ origin(0,0,0);
   // pcl::PointXYZ centerpointp(0.025, 0.005, 0.01);
 
@@ -539,18 +540,19 @@ TEST_F(MultiFingerTest, addCuttingPlanesEqualAlignedOdd)
   num_fingers_side_2 = 1;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanesEqualAligned(object->centerpoint, gripper->center_cutting_plane, false);
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(1, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  ASSERT_EQ(3, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[2], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanesEqualAligned(
+    context, object->centerpoint, context.center_cutting_plane, false);
+  ASSERT_EQ(3, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(1, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  ASSERT_EQ(3, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[2], 0.00001);
 }
 
 
@@ -563,23 +565,24 @@ TEST_F(MultiFingerTest, addCuttingPlanesEqualAlignedEven)
   distance_between_fingers_1 = 0.03;
   distance_between_fingers_2 = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanesEqualAligned(object->centerpoint, gripper->center_cutting_plane, true);
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanesEqualAligned(
+    context, object->centerpoint, context.center_cutting_plane, true);
+  ASSERT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(4, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
 
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(1, gripper->plane_2_index[1]);
-  EXPECT_EQ(2, gripper->plane_2_index[2]);
-  EXPECT_EQ(3, gripper->plane_2_index[3]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(1, context.plane_2_index[1]);
+  EXPECT_EQ(2, context.plane_2_index[2]);
+  EXPECT_EQ(3, context.plane_2_index[3]);
 
-  ASSERT_EQ(4, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_NEAR(-0.015, gripper->cutting_plane_distances[0], 0.00001);
-  EXPECT_NEAR(0.015, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(-0.045, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(0.045, gripper->cutting_plane_distances[3], 0.00001);
+  ASSERT_EQ(4, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_NEAR(-0.015, context.cutting_plane_distances[0], 0.00001);
+  EXPECT_NEAR(0.015, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(-0.045, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(0.045, context.cutting_plane_distances[3], 0.00001);
 }
 
 
@@ -591,17 +594,18 @@ TEST_F(MultiFingerTest, addCuttingPlanesSameDistDiffFingersOddEven)
   num_fingers_side_2 = 2;
   distance_between_fingers_1 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 0, 1, 0, 0.01);
-  ASSERT_EQ(1, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_2_index[0]);
-  EXPECT_EQ(2, gripper->plane_2_index[1]);
-  ASSERT_EQ(3, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 0, 1, 0, 0.01);
+  ASSERT_EQ(1, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(2, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_2_index[0]);
+  EXPECT_EQ(2, context.plane_2_index[1]);
+  ASSERT_EQ(3, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesSameDistDiffFingersEvenOdd)
@@ -611,27 +615,28 @@ TEST_F(MultiFingerTest, addCuttingPlanesSameDistDiffFingersEvenOdd)
   num_fingers_side_1 = 2;
   num_fingers_side_2 = 5;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 1, 2, 0.01, 0.02);
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(1, gripper->plane_1_index[0]);
-  EXPECT_EQ(2, gripper->plane_1_index[1]);
-
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(3, gripper->plane_2_index[1]);
-  EXPECT_EQ(4, gripper->plane_2_index[2]);
-  EXPECT_EQ(5, gripper->plane_2_index[3]);
-  EXPECT_EQ(6, gripper->plane_2_index[4]);
-
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.04, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.04, gripper->cutting_plane_distances[6], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 1, 2, 0.01, 0.02);
+  ASSERT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(5, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(1, context.plane_1_index[0]);
+  EXPECT_EQ(2, context.plane_1_index[1]);
+
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(3, context.plane_2_index[1]);
+  EXPECT_EQ(4, context.plane_2_index[2]);
+  EXPECT_EQ(5, context.plane_2_index[3]);
+  EXPECT_EQ(6, context.plane_2_index[4]);
+
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.04, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.04, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesWithExisting)
@@ -643,19 +648,20 @@ TEST_F(MultiFingerTest, addCuttingPlanesWithExisting)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.01;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 1, 1, 0.01, 0.01);
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(1, gripper->plane_1_index[0]);
-  EXPECT_EQ(2, gripper->plane_1_index[1]);
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(1, gripper->plane_2_index[1]);
-  EXPECT_EQ(2, gripper->plane_2_index[2]);
-  ASSERT_EQ(3, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 1, 1, 0.01, 0.01);
+  ASSERT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(3, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(1, context.plane_1_index[0]);
+  EXPECT_EQ(2, context.plane_1_index[1]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(1, context.plane_2_index[1]);
+  EXPECT_EQ(2, context.plane_2_index[2]);
+  ASSERT_EQ(3, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesDiffDistDiffFingersOddEven)
@@ -667,24 +673,25 @@ TEST_F(MultiFingerTest, addCuttingPlanesDiffDistDiffFingersOddEven)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0.02;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 1, 2, 0.01, 0.01);
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(1, gripper->plane_2_index[0]);
-  EXPECT_EQ(2, gripper->plane_2_index[1]);
-  EXPECT_EQ(3, gripper->plane_2_index[2]);
-  EXPECT_EQ(4, gripper->plane_2_index[3]);
-
-  ASSERT_EQ(5, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[4], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 1, 2, 0.01, 0.01);
+  ASSERT_EQ(3, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(4, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(1, context.plane_2_index[0]);
+  EXPECT_EQ(2, context.plane_2_index[1]);
+  EXPECT_EQ(3, context.plane_2_index[2]);
+  EXPECT_EQ(4, context.plane_2_index[3]);
+
+  ASSERT_EQ(5, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[4], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesDiffDistDiffFingersEvenOdd)
@@ -696,29 +703,30 @@ TEST_F(MultiFingerTest, addCuttingPlanesDiffDistDiffFingersEvenOdd)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 2, 2, 0.01, 0.03);
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(1, gripper->plane_1_index[0]);
-  EXPECT_EQ(2, gripper->plane_1_index[1]);
-  EXPECT_EQ(3, gripper->plane_1_index[2]);
-  EXPECT_EQ(4, gripper->plane_1_index[3]);
-
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(3, gripper->plane_2_index[1]);
-  EXPECT_EQ(4, gripper->plane_2_index[2]);
-  EXPECT_EQ(5, gripper->plane_2_index[3]);
-  EXPECT_EQ(6, gripper->plane_2_index[4]);
-
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.06, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.06, gripper->cutting_plane_distances[6], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 2, 2, 0.01, 0.03);
+  ASSERT_EQ(4, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(5, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(1, context.plane_1_index[0]);
+  EXPECT_EQ(2, context.plane_1_index[1]);
+  EXPECT_EQ(3, context.plane_1_index[2]);
+  EXPECT_EQ(4, context.plane_1_index[3]);
+
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(3, context.plane_2_index[1]);
+  EXPECT_EQ(4, context.plane_2_index[2]);
+  EXPECT_EQ(5, context.plane_2_index[3]);
+  EXPECT_EQ(6, context.plane_2_index[4]);
+
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.06, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.06, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesDiffDistBothEven)
@@ -730,24 +738,25 @@ TEST_F(MultiFingerTest, addCuttingPlanesDiffDistBothEven)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0.02;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 2, 1, 0.005, 0.01);
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_2_index.size()));
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(3, gripper->plane_1_index[3]);
-  EXPECT_EQ(4, gripper->plane_2_index[0]);
-  EXPECT_EQ(5, gripper->plane_2_index[1]);
-
-  ASSERT_EQ(6, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_NEAR(-0.005, gripper->cutting_plane_distances[0], 0.00001);
-  EXPECT_NEAR(0.005, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(-0.015, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(0.015, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[5], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 2, 1, 0.005, 0.01);
+  ASSERT_EQ(4, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(2, static_cast<int>(context.plane_2_index.size()));
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(3, context.plane_1_index[3]);
+  EXPECT_EQ(4, context.plane_2_index[0]);
+  EXPECT_EQ(5, context.plane_2_index[1]);
+
+  ASSERT_EQ(6, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_NEAR(-0.005, context.cutting_plane_distances[0], 0.00001);
+  EXPECT_NEAR(0.005, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(-0.015, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(0.015, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[5], 0.00001);
 }
 
 TEST_F(MultiFingerTest, addCuttingPlanesDiffDistBothOdd)
@@ -759,29 +768,30 @@ TEST_F(MultiFingerTest, addCuttingPlanesDiffDistBothOdd)
   distance_between_fingers_1 = 0.03;
   distance_between_fingers_2 = 0.01;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->addCuttingPlanes(object->centerpoint, gripper->center_cutting_plane, 1, 2, 0.03, 0.01);
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_2_index.size()));
-
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(3, gripper->plane_2_index[1]);
-  EXPECT_EQ(4, gripper->plane_2_index[2]);
-  EXPECT_EQ(5, gripper->plane_2_index[3]);
-  EXPECT_EQ(6, gripper->plane_2_index[4]);
-
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[6], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->addCuttingPlanes(
+    context, object->centerpoint, context.center_cutting_plane, 1, 2, 0.03, 0.01);
+  ASSERT_EQ(3, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(5, static_cast<int>(context.plane_2_index.size()));
+
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(3, context.plane_2_index[1]);
+  EXPECT_EQ(4, context.plane_2_index[2]);
+  EXPECT_EQ(5, context.plane_2_index[3]);
+  EXPECT_EQ(6, context.plane_2_index[4]);
+
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneBothOdd)
@@ -791,27 +801,27 @@ TEST_F(MultiFingerTest, GetCuttingPlaneBothOdd)
   num_fingers_side_1 = 5;
   num_fingers_side_2 = 3;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_EQ(5, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(3, static_cast<int>(context.plane_2_index.size()));
 
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(3, gripper->plane_1_index[3]);
-  EXPECT_EQ(4, gripper->plane_1_index[4]);
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(3, context.plane_1_index[3]);
+  EXPECT_EQ(4, context.plane_1_index[4]);
 
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(1, gripper->plane_2_index[1]);
-  EXPECT_EQ(2, gripper->plane_2_index[2]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(1, context.plane_2_index[1]);
+  EXPECT_EQ(2, context.plane_2_index[2]);
 
-  ASSERT_EQ(5, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.04, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.04, gripper->cutting_plane_distances[4], 0.00001);
+  ASSERT_EQ(5, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.04, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.04, context.cutting_plane_distances[4], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneBothOddDiffDist)
@@ -823,31 +833,31 @@ TEST_F(MultiFingerTest, GetCuttingPlaneBothOddDiffDist)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
 
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_2_index.size()));
+  ASSERT_EQ(3, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(5, static_cast<int>(context.plane_2_index.size()));
 
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
 
 
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(3, gripper->plane_2_index[1]);
-  EXPECT_EQ(4, gripper->plane_2_index[2]);
-  EXPECT_EQ(5, gripper->plane_2_index[3]);
-  EXPECT_EQ(6, gripper->plane_2_index[4]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(3, context.plane_2_index[1]);
+  EXPECT_EQ(4, context.plane_2_index[2]);
+  EXPECT_EQ(5, context.plane_2_index[3]);
+  EXPECT_EQ(6, context.plane_2_index[4]);
 
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.06, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.06, gripper->cutting_plane_distances[6], 0.00001);
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.06, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.06, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneBothEven)
@@ -857,26 +867,26 @@ TEST_F(MultiFingerTest, GetCuttingPlaneBothEven)
   num_fingers_side_1 = 2;
   num_fingers_side_2 = 4;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
 
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_2_index.size()));
+  ASSERT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(4, static_cast<int>(context.plane_2_index.size()));
 
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
 
 
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(1, gripper->plane_2_index[1]);
-  EXPECT_EQ(2, gripper->plane_2_index[2]);
-  EXPECT_EQ(3, gripper->plane_2_index[3]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(1, context.plane_2_index[1]);
+  EXPECT_EQ(2, context.plane_2_index[2]);
+  EXPECT_EQ(3, context.plane_2_index[3]);
 
-  ASSERT_EQ(4, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[0], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[3], 0.00001);
+  ASSERT_EQ(4, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[0], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[3], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneBothEvenDiffDist)
@@ -888,35 +898,35 @@ TEST_F(MultiFingerTest, GetCuttingPlaneBothEvenDiffDist)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0.04;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(6, static_cast<int>(gripper->plane_2_index.size()));
-
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(3, gripper->plane_1_index[3]);
-
-  EXPECT_EQ(4, gripper->plane_2_index[0]);
-  EXPECT_EQ(5, gripper->plane_2_index[1]);
-  EXPECT_EQ(6, gripper->plane_2_index[2]);
-  EXPECT_EQ(7, gripper->plane_2_index[3]);
-  EXPECT_EQ(8, gripper->plane_2_index[4]);
-  EXPECT_EQ(9, gripper->plane_2_index[5]);
-
-  ASSERT_EQ(10, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_NEAR(-0.005, gripper->cutting_plane_distances[0], 0.00001);
-  EXPECT_NEAR(0.005, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(-0.015, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(0.015, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(-0.06, gripper->cutting_plane_distances[6], 0.00001);
-  EXPECT_NEAR(0.06, gripper->cutting_plane_distances[7], 0.00001);
-  EXPECT_NEAR(-0.10, gripper->cutting_plane_distances[8], 0.00001);
-  EXPECT_NEAR(0.10, gripper->cutting_plane_distances[9], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+
+  ASSERT_EQ(4, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(6, static_cast<int>(context.plane_2_index.size()));
+
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(3, context.plane_1_index[3]);
+
+  EXPECT_EQ(4, context.plane_2_index[0]);
+  EXPECT_EQ(5, context.plane_2_index[1]);
+  EXPECT_EQ(6, context.plane_2_index[2]);
+  EXPECT_EQ(7, context.plane_2_index[3]);
+  EXPECT_EQ(8, context.plane_2_index[4]);
+  EXPECT_EQ(9, context.plane_2_index[5]);
+
+  ASSERT_EQ(10, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_NEAR(-0.005, context.cutting_plane_distances[0], 0.00001);
+  EXPECT_NEAR(0.005, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(-0.015, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(0.015, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(-0.06, context.cutting_plane_distances[6], 0.00001);
+  EXPECT_NEAR(0.06, context.cutting_plane_distances[7], 0.00001);
+  EXPECT_NEAR(-0.10, context.cutting_plane_distances[8], 0.00001);
+  EXPECT_NEAR(0.10, context.cutting_plane_distances[9], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneOddEven)
@@ -926,24 +936,24 @@ TEST_F(MultiFingerTest, GetCuttingPlaneOddEven)
   num_fingers_side_1 = 3;
   num_fingers_side_2 = 2;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_EQ(3, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(2, static_cast<int>(context.plane_2_index.size()));
 
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
 
-  EXPECT_EQ(3, gripper->plane_2_index[0]);
-  EXPECT_EQ(4, gripper->plane_2_index[1]);
+  EXPECT_EQ(3, context.plane_2_index[0]);
+  EXPECT_EQ(4, context.plane_2_index[1]);
 
-  ASSERT_EQ(5, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[4], 0.00001);
+  ASSERT_EQ(5, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[4], 0.00001);
 }
 TEST_F(MultiFingerTest, GetCuttingPlaneOddEvenDiffDist)
 {
@@ -954,30 +964,30 @@ TEST_F(MultiFingerTest, GetCuttingPlaneOddEvenDiffDist)
   distance_between_fingers_1 = 0.03;
   distance_between_fingers_2 = 0.02;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_2_index.size()));
-
-  EXPECT_EQ(0, gripper->plane_1_index[0]);
-  EXPECT_EQ(1, gripper->plane_1_index[1]);
-  EXPECT_EQ(2, gripper->plane_1_index[2]);
-  EXPECT_EQ(3, gripper->plane_1_index[3]);
-  EXPECT_EQ(4, gripper->plane_1_index[4]);
-
-  EXPECT_EQ(5, gripper->plane_2_index[0]);
-  EXPECT_EQ(6, gripper->plane_2_index[1]);
-  EXPECT_EQ(1, gripper->plane_2_index[2]);
-  EXPECT_EQ(2, gripper->plane_2_index[3]);
-
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.03, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.03, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.06, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.06, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[6], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_EQ(5, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(4, static_cast<int>(context.plane_2_index.size()));
+
+  EXPECT_EQ(0, context.plane_1_index[0]);
+  EXPECT_EQ(1, context.plane_1_index[1]);
+  EXPECT_EQ(2, context.plane_1_index[2]);
+  EXPECT_EQ(3, context.plane_1_index[3]);
+  EXPECT_EQ(4, context.plane_1_index[4]);
+
+  EXPECT_EQ(5, context.plane_2_index[0]);
+  EXPECT_EQ(6, context.plane_2_index[1]);
+  EXPECT_EQ(1, context.plane_2_index[2]);
+  EXPECT_EQ(2, context.plane_2_index[3]);
+
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.03, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.03, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.06, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.06, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneEvenOdd)
@@ -988,28 +998,28 @@ TEST_F(MultiFingerTest, GetCuttingPlaneEvenOdd)
   num_fingers_side_2 = 5;
 
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_EQ(2, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(5, static_cast<int>(gripper->plane_2_index.size()));
-
-  EXPECT_EQ(1, gripper->plane_1_index[0]);
-  EXPECT_EQ(2, gripper->plane_1_index[1]);
-
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(3, gripper->plane_2_index[1]);
-  EXPECT_EQ(4, gripper->plane_2_index[2]);
-  EXPECT_EQ(5, gripper->plane_2_index[3]);
-  EXPECT_EQ(6, gripper->plane_2_index[4]);
-
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.01, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.01, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.04, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.04, gripper->cutting_plane_distances[6], 0.00001);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_EQ(2, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(5, static_cast<int>(context.plane_2_index.size()));
+
+  EXPECT_EQ(1, context.plane_1_index[0]);
+  EXPECT_EQ(2, context.plane_1_index[1]);
+
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(3, context.plane_2_index[1]);
+  EXPECT_EQ(4, context.plane_2_index[2]);
+  EXPECT_EQ(5, context.plane_2_index[3]);
+  EXPECT_EQ(6, context.plane_2_index[4]);
+
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.01, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.01, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.04, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.04, context.cutting_plane_distances[6], 0.00001);
 }
 
 TEST_F(MultiFingerTest, GetCuttingPlaneEvenOddDiffDist)
@@ -1022,29 +1032,29 @@ TEST_F(MultiFingerTest, GetCuttingPlaneEvenOddDiffDist)
   distance_between_fingers_2 = 0.02;
 
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_EQ(4, static_cast<int>(gripper->plane_1_index.size()));
-  ASSERT_EQ(3, static_cast<int>(gripper->plane_2_index.size()));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_EQ(4, static_cast<int>(context.plane_1_index.size()));
+  ASSERT_EQ(3, static_cast<int>(context.plane_2_index.size()));
 
-  EXPECT_EQ(1, gripper->plane_1_index[0]);
-  EXPECT_EQ(2, gripper->plane_1_index[1]);
-  EXPECT_EQ(3, gripper->plane_1_index[2]);
-  EXPECT_EQ(4, gripper->plane_1_index[3]);
+  EXPECT_EQ(1, context.plane_1_index[0]);
+  EXPECT_EQ(2, context.plane_1_index[1]);
+  EXPECT_EQ(3, context.plane_1_index[2]);
+  EXPECT_EQ(4, context.plane_1_index[3]);
 
-  EXPECT_EQ(0, gripper->plane_2_index[0]);
-  EXPECT_EQ(5, gripper->plane_2_index[1]);
-  EXPECT_EQ(6, gripper->plane_2_index[2]);
+  EXPECT_EQ(0, context.plane_2_index[0]);
+  EXPECT_EQ(5, context.plane_2_index[1]);
+  EXPECT_EQ(6, context.plane_2_index[2]);
 
 
-  ASSERT_EQ(7, static_cast<int>(gripper->cutting_plane_distances.size()));
-  EXPECT_EQ(0, gripper->cutting_plane_distances[0]);
-  EXPECT_NEAR(-0.025, gripper->cutting_plane_distances[1], 0.00001);
-  EXPECT_NEAR(0.025, gripper->cutting_plane_distances[2], 0.00001);
-  EXPECT_NEAR(-0.075, gripper->cutting_plane_distances[3], 0.00001);
-  EXPECT_NEAR(0.075, gripper->cutting_plane_distances[4], 0.00001);
-  EXPECT_NEAR(-0.02, gripper->cutting_plane_distances[5], 0.00001);
-  EXPECT_NEAR(0.02, gripper->cutting_plane_distances[6], 0.00001);
+  ASSERT_EQ(7, static_cast<int>(context.cutting_plane_distances.size()));
+  EXPECT_EQ(0, context.cutting_plane_distances[0]);
+  EXPECT_NEAR(-0.025, context.cutting_plane_distances[1], 0.00001);
+  EXPECT_NEAR(0.025, context.cutting_plane_distances[2], 0.00001);
+  EXPECT_NEAR(-0.075, context.cutting_plane_distances[3], 0.00001);
+  EXPECT_NEAR(0.075, context.cutting_plane_distances[4], 0.00001);
+  EXPECT_NEAR(-0.02, context.cutting_plane_distances[5], 0.00001);
+  EXPECT_NEAR(0.02, context.cutting_plane_distances[6], 0.00001);
 }
 
 // Disabled tests for CI/CD
@@ -1058,17 +1068,17 @@ TEST_F(MultiFingerTest, GetGraspCloudTest)
   distance_between_fingers_2 = 0.02;
 
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_TRUE(gripper->getGraspCloud(object));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_TRUE(gripper->getGraspCloud(context, object));
 
-  ASSERT_EQ(5, static_cast<int>(gripper->grasp_samples.size()));
-  EXPECT_TRUE(gripper->grasp_samples[0]->plane_intersects_object);
-  EXPECT_FALSE(static_cast<int>(gripper->grasp_samples[1]->plane_intersects_object));
-  EXPECT_FALSE(static_cast<int>(gripper->grasp_samples[2]->plane_intersects_object));
+  ASSERT_EQ(5, static_cast<int>(context.grasp_samples.size()));
+  EXPECT_TRUE(context.grasp_samples[0]->plane_intersects_object);
+  EXPECT_FALSE(static_cast<int>(context.grasp_samples[1]->plane_intersects_object));
+  EXPECT_FALSE(static_cast<int>(context.grasp_samples[2]->plane_intersects_object));
 
-  EXPECT_TRUE(static_cast<int>(gripper->grasp_samples[3]->plane_intersects_object));
-  EXPECT_TRUE(static_cast<int>(gripper->grasp_samples[4]->plane_intersects_object));
+  EXPECT_TRUE(static_cast<int>(context.grasp_samples[3]->plane_intersects_object));
+  EXPECT_TRUE(static_cast<int>(context.grasp_samples[4]->plane_intersects_object));
 }
 
 TEST_F(MultiFingerTest, GetGraspCloudTestFalse)
@@ -1082,11 +1092,11 @@ TEST_F(MultiFingerTest, GetGraspCloudTestFalse)
 
 
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  ASSERT_FALSE(gripper->getGraspCloud(object));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  ASSERT_FALSE(gripper->getGraspCloud(context, object));
 
-  for (auto & sample : gripper->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     ASSERT_FALSE(sample->plane_intersects_object);
   }
 
@@ -1102,25 +1112,25 @@ TEST_F(MultiFingerTest, InitialSamplePointsTestHorizontal)
   distance_between_fingers_1 = 0.06;
   distance_between_fingers_2 = 0.02;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
 
-  ASSERT_TRUE(gripper->getInitialSamplePoints(object));
-  EXPECT_GE(gripper->grasp_samples[0]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[0]->sample_side_2->start_index, 0);
+  ASSERT_TRUE(gripper->getInitialSamplePoints(context, object));
+  EXPECT_GE(context.grasp_samples[0]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[0]->sample_side_2->start_index, 0);
 
-  EXPECT_LT(gripper->grasp_samples[1]->sample_side_1->start_index, 0);
-  EXPECT_LT(gripper->grasp_samples[1]->sample_side_2->start_index, 0);
+  EXPECT_LT(context.grasp_samples[1]->sample_side_1->start_index, 0);
+  EXPECT_LT(context.grasp_samples[1]->sample_side_2->start_index, 0);
 
-  EXPECT_LT(gripper->grasp_samples[2]->sample_side_1->start_index, 0);
-  EXPECT_LT(gripper->grasp_samples[2]->sample_side_2->start_index, 0);
+  EXPECT_LT(context.grasp_samples[2]->sample_side_1->start_index, 0);
+  EXPECT_LT(context.grasp_samples[2]->sample_side_2->start_index, 0);
 
-  EXPECT_GE(gripper->grasp_samples[3]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[3]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[3]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[3]->sample_side_2->start_index, 0);
 
-  EXPECT_GE(gripper->grasp_samples[4]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[4]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[4]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[4]->sample_side_2->start_index, 0);
 }
 
 TEST_F(MultiFingerTest, InitialSamplePointsTestVertical)
@@ -1132,30 +1142,30 @@ TEST_F(MultiFingerTest, InitialSamplePointsTestVertical)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0.04;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
 
-  ASSERT_EQ(6, static_cast<int>(gripper->grasp_samples.size()));
+  ASSERT_EQ(6, static_cast<int>(context.grasp_samples.size()));
 
-  EXPECT_GE(gripper->grasp_samples[0]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[0]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[0]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[0]->sample_side_2->start_index, 0);
 
-  EXPECT_GE(gripper->grasp_samples[1]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[1]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[1]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[1]->sample_side_2->start_index, 0);
 
-  EXPECT_GE(gripper->grasp_samples[2]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[2]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[2]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[2]->sample_side_2->start_index, 0);
 
-  EXPECT_GE(gripper->grasp_samples[3]->sample_side_1->start_index, 0);
-  EXPECT_GE(gripper->grasp_samples[3]->sample_side_2->start_index, 0);
+  EXPECT_GE(context.grasp_samples[3]->sample_side_1->start_index, 0);
+  EXPECT_GE(context.grasp_samples[3]->sample_side_2->start_index, 0);
 
-  EXPECT_LT(gripper->grasp_samples[4]->sample_side_1->start_index, 0);
-  EXPECT_LT(gripper->grasp_samples[4]->sample_side_2->start_index, 0);
+  EXPECT_LT(context.grasp_samples[4]->sample_side_1->start_index, 0);
+  EXPECT_LT(context.grasp_samples[4]->sample_side_2->start_index, 0);
 
-  EXPECT_LT(gripper->grasp_samples[5]->sample_side_1->start_index, 0);
-  EXPECT_LT(gripper->grasp_samples[5]->sample_side_2->start_index, 0);
+  EXPECT_LT(context.grasp_samples[5]->sample_side_1->start_index, 0);
+  EXPECT_LT(context.grasp_samples[5]->sample_side_2->start_index, 0);
 }
 
 TEST_F(MultiFingerTest, GetInitialSampleCloudTest)
@@ -1167,50 +1177,50 @@ TEST_F(MultiFingerTest, GetInitialSampleCloudTest)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
 
-  ASSERT_EQ(3, static_cast<int>(gripper->grasp_samples.size()));
+  ASSERT_EQ(3, static_cast<int>(context.grasp_samples.size()));
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[0]->sample_side_1->
+    static_cast<int>(context.grasp_samples[0]->sample_side_1->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[0]->sample_side_2->
+    static_cast<int>(context.grasp_samples[0]->sample_side_2->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[0]->sample_side_1->
+    static_cast<int>(context.grasp_samples[0]->sample_side_1->
     finger_ncloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[0]->sample_side_2->
+    static_cast<int>(context.grasp_samples[0]->sample_side_2->
     finger_ncloud->points.size()), 0);
 
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[1]->sample_side_1->
+    static_cast<int>(context.grasp_samples[1]->sample_side_1->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[1]->sample_side_2->
+    static_cast<int>(context.grasp_samples[1]->sample_side_2->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[1]->sample_side_1->
+    static_cast<int>(context.grasp_samples[1]->sample_side_1->
     finger_ncloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[1]->sample_side_2->
+    static_cast<int>(context.grasp_samples[1]->sample_side_2->
     finger_ncloud->points.size()), 0);
 
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[2]->sample_side_1->
+    static_cast<int>(context.grasp_samples[2]->sample_side_1->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[2]->sample_side_2->
+    static_cast<int>(context.grasp_samples[2]->sample_side_2->
     finger_cloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[2]->sample_side_1->
+    static_cast<int>(context.grasp_samples[2]->sample_side_1->
     finger_ncloud->points.size()), 0);
   EXPECT_GT(
-    static_cast<int>(gripper->grasp_samples[2]->sample_side_2->
+    static_cast<int>(context.grasp_samples[2]->sample_side_2->
     finger_ncloud->points.size()), 0);
 }
 
@@ -1223,40 +1233,40 @@ TEST_F(MultiFingerTest, VoxelizeSampleCloudTest)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-
-  ASSERT_EQ(3, static_cast<int>(gripper->grasp_samples.size()));
-  int ncloud_side1_0 = static_cast<int>(gripper->grasp_samples[0]->sample_side_1->
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+
+  ASSERT_EQ(3, static_cast<int>(context.grasp_samples.size()));
+  int ncloud_side1_0 = static_cast<int>(context.grasp_samples[0]->sample_side_1->
     finger_cloud->points.size());
-  int ncloud_side1_1 = static_cast<int>(gripper->grasp_samples[1]->sample_side_1->
+  int ncloud_side1_1 = static_cast<int>(context.grasp_samples[1]->sample_side_1->
     finger_cloud->points.size());
-  int ncloud_side1_2 = static_cast<int>(gripper->grasp_samples[2]->sample_side_1->
+  int ncloud_side1_2 = static_cast<int>(context.grasp_samples[2]->sample_side_1->
     finger_cloud->points.size());
 
-  int ncloud_side2_0 = static_cast<int>(gripper->grasp_samples[0]->sample_side_2->
+  int ncloud_side2_0 = static_cast<int>(context.grasp_samples[0]->sample_side_2->
     finger_cloud->points.size());
-  int ncloud_side2_1 = static_cast<int>(gripper->grasp_samples[1]->sample_side_2->
+  int ncloud_side2_1 = static_cast<int>(context.grasp_samples[1]->sample_side_2->
     finger_cloud->points.size());
-  int ncloud_side2_2 = static_cast<int>(gripper->grasp_samples[2]->sample_side_2->
+  int ncloud_side2_2 = static_cast<int>(context.grasp_samples[2]->sample_side_2->
     finger_cloud->points.size());
 
-  int nvoxel_side1_0 = static_cast<int>(gripper->grasp_samples[0]->sample_side_1->
+  int nvoxel_side1_0 = static_cast<int>(context.grasp_samples[0]->sample_side_1->
     finger_nvoxel->points.size());
-  int nvoxel_side1_1 = static_cast<int>(gripper->grasp_samples[1]->sample_side_1->
+  int nvoxel_side1_1 = static_cast<int>(context.grasp_samples[1]->sample_side_1->
     finger_nvoxel->points.size());
-  int nvoxel_side1_2 = static_cast<int>(gripper->grasp_samples[2]->sample_side_1->
+  int nvoxel_side1_2 = static_cast<int>(context.grasp_samples[2]->sample_side_1->
     finger_nvoxel->points.size());
 
-  int nvoxel_side2_0 = static_cast<int>(gripper->grasp_samples[0]->sample_side_2->
+  int nvoxel_side2_0 = static_cast<int>(context.grasp_samples[0]->sample_side_2->
     finger_nvoxel->points.size());
-  int nvoxel_side2_1 = static_cast<int>(gripper->grasp_samples[1]->sample_side_2->
+  int nvoxel_side2_1 = static_cast<int>(context.grasp_samples[1]->sample_side_2->
     finger_nvoxel->points.size());
-  int nvoxel_side2_2 = static_cast<int>(gripper->grasp_samples[2]->sample_side_2->
+  int nvoxel_side2_2 = static_cast<int>(context.grasp_samples[2]->sample_side_2->
     finger_nvoxel->points.size());
 
 
@@ -1308,13 +1318,13 @@ TEST_F(MultiFingerTest, GetMaxMinValuesTest)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
 
   pcl::PointNormal centroid_point;
   centroid_point.x = object->centerpoint(0);
@@ -1328,7 +1338,7 @@ TEST_F(MultiFingerTest, GetMaxMinValuesTest)
   std::vector<float> curvature_vec_2;
   std::vector<float> grasp_plane_distance_vec_2;
   std::vector<float> centroid_distance_vec_2;
-  for (auto & sample : gripper->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     if (sample->plane_intersects_object) {
       for (auto & point : sample->sample_side_1->finger_nvoxel->points) {
         curvature_vec_1.push_back(point.curvature);
@@ -1477,25 +1487,43 @@ TEST_F(MultiFingerTest, GetFingerSamplesTest)
   distance_between_fingers_1 = 0.01;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
 
 
-  for (auto & sample : gripper->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     EXPECT_EQ(static_cast<int>(sample->sample_side_1->finger_samples.size()), 0);
     EXPECT_EQ(static_cast<int>(sample->sample_side_2->finger_samples.size()), 0);
   }
-  gripper->getFingerSamples(object);
+  gripper->getFingerSamples(context, object);
 
-  for (auto & sample : gripper->grasp_samples) {
+  for (auto & sample : context.grasp_samples) {
     EXPECT_GT(static_cast<int>(sample->sample_side_1->finger_samples.size()), 0);
     EXPECT_GT(static_cast<int>(sample->sample_side_2->finger_samples.size()), 0);
   }
+
+  // The finger sample arrays hold the attributes of the finger samples
+  for (auto & sample : context.grasp_samples) {
+    for (auto & sample_side : {sample->sample_side_1, sample->sample_side_2}) {
+      ASSERT_EQ(
+        static_cast<Eigen::Index>(sample_side->finger_samples.size()),
+        sample_side->finger_positions.cols());
+      ASSERT_EQ(sample_side->finger_positions.cols(), sample_side->finger_normals.cols());
+      ASSERT_EQ(sample_side->finger_positions.cols(), sample_side->finger_curvatures.size());
+      for (size_t i = 0; i < sample_side->finger_samples.size(); i++) {
+        const auto & finger = sample_side->finger_samples[i];
+        EXPECT_EQ(finger->finger_point.x, sample_side->finger_positions(0, i));
+        EXPECT_EQ(finger->finger_point.normal_z, sample_side->finger_normals(2, i));
+        EXPECT_EQ(finger->grasp_plane_dist, sample_side->finger_grasp_plane_dists(i));
+        EXPECT_EQ(finger->curvature, sample_side->finger_curvatures(i));
+      }
+    }
+  }
 }
 
 // Disabled tests for CI/CD
@@ -1508,17 +1536,17 @@ TEST_F(MultiFingerTest, GetGripperClustersTest1)
   // distance_between_fingers_1 = 0.02;
   // distance_between_fingers_2 = 0.03;
   // ASSERT_NO_THROW(LoadGripper());
-  // gripper->getCenterCuttingPlane(object);
-  // gripper->getCuttingPlanes(object);
-  // gripper->getGraspCloud(object);
-  // gripper->getInitialSamplePoints(object);
-  // gripper->getInitialSampleCloud(object);
-  // gripper->voxelizeSampleCloud();
-  // gripper->getMaxMinValues(object);
-  // gripper->getFingerSamples(object);
-  // EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 0);
-  // gripper->getGripperClusters();
-  // EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 7);
+  // gripper->getCenterCuttingPlane(context, object);
+  // gripper->getCuttingPlanes(context, object);
+  // gripper->getGraspCloud(context, object);
+  // gripper->getInitialSamplePoints(context, object);
+  // gripper->getInitialSampleCloud(context, object);
+  // gripper->voxelizeSampleCloud(context);
+  // gripper->getMaxMinValues(context, object);
+  // gripper->getFingerSamples(context, object);
+  // EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 0);
+  // gripper->getGripperClusters(context);
+  // EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 7);
 }
 
 TEST_F(MultiFingerTest, GetGripperClustersTest2)
@@ -1530,17 +1558,17 @@ TEST_F(MultiFingerTest, GetGripperClustersTest2)
   distance_between_fingers_1 = 0;
   distance_between_fingers_2 = 0;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 0);
-  gripper->getGripperClusters();
-  EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 2);
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 0);
+  gripper->getGripperClusters(context);
+  EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 2);
 }
 
 // Disabled tests for CI/CD
@@ -1553,17 +1581,17 @@ TEST_F(MultiFingerTest, GetGripperClustersTest3)
   // distance_between_fingers_1 = 0.02;
   // distance_between_fingers_2 = 0.01;
   // ASSERT_NO_THROW(LoadGripper());
-  // gripper->getCenterCuttingPlane(object);
-  // gripper->getCuttingPlanes(object);
-  // gripper->getGraspCloud(object);
-  // gripper->getInitialSamplePoints(object);
-  // gripper->getInitialSampleCloud(object);
-  // gripper->voxelizeSampleCloud();
-  // gripper->getMaxMinValues(object);
-  // gripper->getFingerSamples(object);
-  // EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 0);
-  // gripper->getGripperClusters();
-  // EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 6);
+  // gripper->getCenterCuttingPlane(context, object);
+  // gripper->getCuttingPlanes(context, object);
+  // gripper->getGraspCloud(context, object);
+  // gripper->getInitialSamplePoints(context, object);
+  // gripper->getInitialSampleCloud(context, object);
+  // gripper->voxelizeSampleCloud(context);
+  // gripper->getMaxMinValues(context, object);
+  // gripper->getFingerSamples(context, object);
+  // EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 0);
+  // gripper->getGripperClusters(context);
+  // EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 6);
 }
 
 TEST_F(MultiFingerTest, getGripperPlaneTest)
@@ -1655,21 +1683,21 @@ TEST_F(MultiFingerTest, getNearestPlaneIndexTest)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.01;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
-  EXPECT_EQ(0, gripper->getNearestPlaneIndex(0));
-  EXPECT_EQ(1, gripper->getNearestPlaneIndex(-0.03));
-  EXPECT_EQ(2, gripper->getNearestPlaneIndex(0.015));
-  EXPECT_EQ(3, gripper->getNearestPlaneIndex(-0.01));
-  EXPECT_EQ(3, gripper->getNearestPlaneIndex(-0.004));
-  EXPECT_EQ(4, gripper->getNearestPlaneIndex(0.003));
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
+  EXPECT_EQ(0, gripper->getNearestPlaneIndex(context, 0));
+  EXPECT_EQ(1, gripper->getNearestPlaneIndex(context, -0.03));
+  EXPECT_EQ(2, gripper->getNearestPlaneIndex(context, 0.015));
+  EXPECT_EQ(3, gripper->getNearestPlaneIndex(context, -0.01));
+  EXPECT_EQ(3, gripper->getNearestPlaneIndex(context, -0.004));
+  EXPECT_EQ(4, gripper->getNearestPlaneIndex(context, 0.003));
 }
 
 // Disabled tests for CI/CD
@@ -1682,16 +1710,16 @@ TEST_F(MultiFingerTest, getNearestPointIndexTest)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.01;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  EXPECT_EQ(static_cast<int>(gripper->gripper_clusters.size()), 0);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  EXPECT_EQ(static_cast<int>(context.gripper_clusters.size()), 0);
+  gripper->getGripperClusters(context);
   pcl::PointNormal midpoint;
   midpoint.x = 0.005;
   midpoint.y = 0.025;
@@ -1723,15 +1751,15 @@ TEST_F(MultiFingerTest, generateGripperOpenConfigTest)
   distance_between_fingers_1 = 0.02;
   distance_between_fingers_2 = 0.01;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
 
   Eigen::Vector3f closed_finger_point_1(0.005, 0.025, 0.025);
   Eigen::Vector3f closed_finger_point_2(0.005, 0.025, -0.005);
@@ -1770,9 +1798,9 @@ TEST_F(MultiFingerTest, generateGripperOpenConfigTest)
 
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::shared_ptr<multiFingerGripper> gripper_sample = gripper->generateGripperOpenConfig(
-    collision_object_ptr, finger_1, finger_2,
+    context, collision_object_ptr, finger_1, finger_2,
     open_coords[0], open_coords[1], perpendicular_grasp_direction,
-    grasp_direction, "camera_frame");
+    grasp_direction);
 
   EXPECT_FALSE(gripper_sample->collides_with_world);
   EXPECT_EQ(4, static_cast<int>(gripper_sample->closed_fingers_1.size()));
@@ -1800,15 +1828,15 @@ TEST_F(MultiFingerTest, generateGripperOpenConfigTestCollision)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
 
   Eigen::Vector3f closed_finger_point_1(0.005, 0.025, 0.025);
   Eigen::Vector3f closed_finger_point_2(0.005, 0.025, 0.0);
@@ -1847,9 +1875,9 @@ TEST_F(MultiFingerTest, generateGripperOpenConfigTestCollision)
 
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::shared_ptr<multiFingerGripper> gripper_sample = gripper->generateGripperOpenConfig(
-    collision_object_ptr, finger_1, finger_2,
+    context, collision_object_ptr, finger_1, finger_2,
     open_coords[0], open_coords[1], perpendicular_grasp_direction,
-    grasp_direction, "camera_frame");
+    grasp_direction);
 
   EXPECT_TRUE(gripper_sample->collides_with_world);
   EXPECT_EQ(4, static_cast<int>(gripper_sample->closed_fingers_1.size()));
@@ -1877,18 +1905,19 @@ TEST_F(MultiFingerTest, getAllGripperConfigsTest)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-  finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+  finger_samples = gripper->getAllGripperConfigs(
+    context, object, collision_object_ptr);
   EXPECT_GT(static_cast<int>(finger_samples.size()), 0);
 }
 
@@ -1902,21 +1931,131 @@ TEST_F(MultiFingerTest, getAllGripperConfigsTestCollide)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
   GenerateObjectCollision(0.05, 0.05, 0.05);
   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-  finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+  finger_samples = gripper->getAllGripperConfigs(
+    context, object, collision_object_ptr);
   EXPECT_EQ(static_cast<int>(finger_samples.size()), 0);
 }
 
+TEST_F(MultiFingerTest, getAllGripperConfigsAnytimeTest)
+{
+  GenerateObjectVertical();
+  ResetVariables();
+  num_fingers_side_1 = 4;
+  num_fingers_side_2 = 2;
+  distance_between_fingers_1 = 0.02;
+  distance_between_fingers_2 = 0.01;
+  gripper_stroke = 0.03;
+  ASSERT_NO_THROW(LoadGripper());
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
+  GenerateObjectCollision(0.01, 0.05, 0.02);
+
+  FingerPlanningContext full_context = context;
+  std::vector<std::shared_ptr<multiFingerGripper>> all_samples =
+    gripper->getAllGripperConfigs(full_context, object, collision_object_ptr);
+  ASSERT_GT(all_samples.size(), 1u);
+  EXPECT_TRUE(full_context.exhaustive);
+  float best_rank = std::numeric_limits<float>::lowest();
+  for (auto sample : all_samples) {
+    gripper->getGripperRank(sample);
+    best_rank = std::max(best_rank, sample->rank);
+  }
+
+  // The search stops at the first grasp, which is the best one if the search was exhaustive
+  FingerPlanningContext anytime_context = context;
+  anytime_context.anytime = true;
+  anytime_context.max_grasps = 1;
+  std::vector<std::shared_ptr<multiFingerGripper>> anytime_samples =
+    gripper->getAllGripperConfigs(anytime_context, object, collision_object_ptr);
+  ASSERT_EQ(anytime_samples.size(), 1u);
+  if (anytime_context.exhaustive) {
+    EXPECT_FLOAT_EQ(anytime_samples[0]->rank, best_rank);
+  }
+
+  // Without grasps of the minimum rank, only the rank bound stops the search, so the best
+  // grasp is always found
+  FingerPlanningContext min_rank_context = context;
+  min_rank_context.anytime = true;
+  min_rank_context.max_grasps = 1;
+  min_rank_context.min_rank = best_rank + 1;
+  std::vector<std::shared_ptr<multiFingerGripper>> min_rank_samples =
+    gripper->getAllGripperConfigs(min_rank_context, object, collision_object_ptr);
+  EXPECT_TRUE(min_rank_context.exhaustive);
+  float min_rank_best_rank = std::numeric_limits<float>::lowest();
+  for (auto sample : min_rank_samples) {
+    min_rank_best_rank = std::max(min_rank_best_rank, sample->rank);
+  }
+  EXPECT_FLOAT_EQ(min_rank_best_rank, best_rank);
+
+  FingerPlanningContext expired_context = context;
+  expired_context.anytime = true;
+  expired_context.deadline = std::chrono::steady_clock::time_point::min();
+  EXPECT_EQ(
+    gripper->getAllGripperConfigs(
+      expired_context, object, collision_object_ptr).size(), 0u);
+  EXPECT_TRUE(expired_context.timed_out);
+  EXPECT_FALSE(expired_context.exhaustive);
+}
+
+TEST_F(MultiFingerTest, getFingerPairsTest)
+{
+  GenerateObjectVertical();
+  ResetVariables();
+  num_fingers_side_1 = 1;
+  num_fingers_side_2 = 1;
+  distance_between_fingers_1 = 0.0;
+  distance_between_fingers_2 = 0.0;
+  gripper_stroke = 0.03;
+  ASSERT_NO_THROW(LoadGripper());
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  FingerPlanningContext sampled_context = context;
+  const auto & finger_samples_1 = sampled_context.grasp_samples[0]->sample_side_1->finger_samples;
+  const auto & finger_samples_2 = sampled_context.grasp_samples[0]->sample_side_2->finger_samples;
+
+  std::vector<fingerPair> pairs = gripper->getFingerPairs(sampled_context);
+  ASSERT_GT(pairs.size(), 0u);
+  for (size_t index = 1; index < pairs.size(); index++) {
+    EXPECT_GE(pairs[index - 1].rank_bound, pairs[index].rank_bound);
+  }
+
+  // Only pairs that fit in the stroke are kept
+  gripper_stroke = 0.012;
+  ASSERT_NO_THROW(LoadGripper());
+  std::vector<fingerPair> narrow_pairs = gripper->getFingerPairs(sampled_context);
+  EXPECT_LT(narrow_pairs.size(), pairs.size());
+  for (const auto & pair : narrow_pairs) {
+    EXPECT_LE(
+      pcl::geometry::distance(
+        finger_samples_1[pair.index_1]->finger_point,
+        finger_samples_2[pair.index_2]->finger_point), 0.012 + 1e-6);
+  }
+}
+
 TEST_F(MultiFingerTest, getGripperRankTest)
 {
   GenerateObjectVertical();
@@ -1927,18 +2066,19 @@ TEST_F(MultiFingerTest, getGripperRankTest)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-  finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+  finger_samples = gripper->getAllGripperConfigs(
+    context, object, collision_object_ptr);
   for (auto sample : finger_samples) {
     EXPECT_EQ(sample->rank, 0);
     gripper->getGripperRank(sample);
@@ -2051,18 +2191,19 @@ TEST_F(MultiFingerTest, getGraspPoseTest)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-  finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+  finger_samples = gripper->getAllGripperConfigs(
+    context, object, collision_object_ptr);
   for (auto & sample : finger_samples) {
     gripper->getGraspPose(sample, object);
     EXPECT_EQ(sample->gripper_palm_center.x, sample->pose.pose.position.x);
@@ -2087,34 +2228,178 @@ TEST_F(MultiFingerTest, getAllRanksTest)
   distance_between_fingers_2 = 0.01;
   gripper_stroke = 0.03;
   ASSERT_NO_THROW(LoadGripper());
-  gripper->getCenterCuttingPlane(object);
-  gripper->getCuttingPlanes(object);
-  gripper->getGraspCloud(object);
-  gripper->getInitialSamplePoints(object);
-  gripper->getInitialSampleCloud(object);
-  gripper->voxelizeSampleCloud();
-  gripper->getMaxMinValues(object);
-  gripper->getFingerSamples(object);
-  gripper->getGripperClusters();
+  gripper->getCenterCuttingPlane(context, object);
+  gripper->getCuttingPlanes(context, object);
+  gripper->getGraspCloud(context, object);
+  gripper->getInitialSamplePoints(context, object);
+  gripper->getInitialSampleCloud(context, object);
+  gripper->voxelizeSampleCloud(context);
+  gripper->getMaxMinValues(context, object);
+  gripper->getFingerSamples(context, object);
+  gripper->getGripperClusters(context);
   GenerateObjectCollision(0.01, 0.05, 0.02);
   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-  finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+  finger_samples = gripper->getAllGripperConfigs(
+    context, object, collision_object_ptr);
   for (auto & sample : finger_samples) {
     gripper->getGraspPose(sample, object);
   }
 
   emd_msgs::msg::GraspMethod grasp_method;
   grasp_method.ee_id = gripper->getID();
-  grasp_method.grasp_ranks.insert(
-    grasp_method.grasp_ranks.begin(), std::numeric_limits<float>::min());
-  gripper->getAllRanks(finger_samples, &grasp_method);
-  grasp_method.grasp_ranks.pop_back();
-
+  std::vector<std::shared_ptr<multiFingerGripper>> sorted_samples =
+    gripper->getAllRanks(finger_samples, &grasp_method);
+
+  // No grasp is dropped, and the grasps are in decreasing rank
+  ASSERT_EQ(finger_samples.size(), sorted_samples.size());
+  ASSERT_EQ(finger_samples.size(), grasp_method.grasp_ranks.size());
+  EXPECT_EQ(finger_samples.size(), grasp_method.grasp_poses.size());
+  EXPECT_EQ(finger_samples.size(), grasp_method.grasp_markers.size());
+  EXPECT_EQ(finger_samples.size(), grasp_method.grasp_options.size());
   for (size_t i = 0; i < grasp_method.grasp_ranks.size(); i++) {
+    EXPECT_EQ(sorted_samples[i]->rank, grasp_method.grasp_ranks[i]);
     if (i != 0) {
       EXPECT_GT(grasp_method.grasp_ranks[i - 1], grasp_method.grasp_ranks[i]);
     }
   }
+
+  // Only the best grasps are kept
+  emd_msgs::msg::GraspMethod top_grasp_method;
+  std::vector<std::shared_ptr<multiFingerGripper>> top_samples =
+    gripper->getAllRanks(finger_samples, &top_grasp_method, 2);
+  ASSERT_EQ(std::min<size_t>(2, finger_samples.size()), top_samples.size());
+  ASSERT_EQ(top_samples.size(), top_grasp_method.grasp_poses.size());
+  for (size_t i = 0; i < top_samples.size(); i++) {
+    EXPECT_EQ(sorted_samples[i], top_samples[i]);
+  }
+}
+
+TEST_F(MultiFingerTest, planGraspsConcurrentContextsTest)
+{
+  GenerateObjectVertical();
+  ResetVariables();
+  num_fingers_side_1 = 1;
+  num_fingers_side_2 = 2;
+  distance_between_fingers_1 = 0.0;
+  distance_between_fingers_2 = 0.01;
+  gripper_stroke = 0.03;
+  ASSERT_NO_THROW(LoadGripper());
+  GenerateObjectCollision(0.01, 0.05, 0.02);
+
+  emd_msgs::msg::GraspMethod expected_method;
+  std::vector<std::shared_ptr<multiFingerGripper>> expected = gripper->planGraspsWithFingerResult(
+    context, std::make_shared<GraspObject>(*object), &expected_method, collision_object_ptr,
+    camera_frame);
+
+  // The same gripper plans one shared object from several threads, each request with a
+  // context of its own
+  const int num_requests = 4;
+  std::shared_ptr<GraspObject> shared_object = std::make_shared<GraspObject>(*object);
+  std::vector<emd_msgs::msg::GraspMethod> methods(num_requests);
+  std::vector<std::vector<std::shared_ptr<multiFingerGripper>>> results(num_requests);
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < num_requests; i++) {
+    futures.push_back(
+      std::async(
+        std::launch::async, [this, i, shared_object, &methods, &results]() {
+          FingerPlanningContext request_context;
+          results[i] = gripper->planGraspsWithFingerResult(
+            request_context, shared_object, &methods[i], collision_object_ptr, camera_frame);
+        }));
+  }
+  for (auto & future : futures) {
+    future.get();
+  }
+  // Returned grasps are given a marker
+  for (const auto & gripper_config : expected) {
+    EXPECT_EQ(
+      gripper_config->open_fingers_1.size() + gripper_config->open_fingers_2.size(),
+      gripper_config->marker.points.size());
+  }
+  for (int i = 0; i < num_requests; i++) {
+    ASSERT_EQ(expected.size(), results[i].size());
+    ASSERT_EQ(expected_method.grasp_ranks.size(), methods[i].grasp_ranks.size());
+    for (size_t j = 0; j < expected_method.grasp_ranks.size(); j++) {
+      EXPECT_FLOAT_EQ(expected_method.grasp_ranks[j], methods[i].grasp_ranks[j]);
+    }
+  }
+}
+
+TEST_F(MultiFingerTest, planGraspsDeadlineTest)
+{
+  GenerateObjectVertical();
+  ResetVariables();
+  num_fingers_side_1 = 1;
+  num_fingers_side_2 = 2;
+  distance_between_fingers_1 = 0.0;
+  distance_between_fingers_2 = 0.01;
+  gripper_stroke = 0.03;
+  ASSERT_NO_THROW(LoadGripper());
+  GenerateObjectCollision(0.01, 0.05, 0.02);
+
+  emd_msgs::msg::GraspMethod grasp_method;
+  context.deadline = std::chrono::steady_clock::now();
+  std::vector<std::shared_ptr<multiFingerGripper>> result = gripper->planGraspsWithFingerResult(
+    context, object, &grasp_method, collision_object_ptr, camera_frame);
+  EXPECT_TRUE(context.timed_out);
+  EXPECT_TRUE(result.empty());
+  EXPECT_TRUE(grasp_method.grasp_ranks.empty());
+}
+
+TEST_F(MultiFingerTest, planGraspsCoarseToFineTest)
+{
+  GenerateObjectVertical();
+  ResetVariables();
+  num_fingers_side_1 = 1;
+  num_fingers_side_2 = 2;
+  distance_between_fingers_1 = 0.0;
+  distance_between_fingers_2 = 0.01;
+  gripper_stroke = 0.03;
+  GenerateObjectCollision(0.01, 0.05, 0.02);
+
+  // Coarse to fine search needs at least one coarse candidate
+  EXPECT_THROW(
+    FingerGripper(
+      id, num_fingers_side_1, num_fingers_side_2, distance_between_fingers_1,
+      distance_between_fingers_2, finger_thickness, gripper_stroke, voxel_size,
+      grasp_quality_weight1, grasp_quality_weight2, grasp_plane_dist_limit, cloud_normal_radius,
+      worldXAngleThreshold, worldYAngleThreshold, worldZAngleThreshold, grasp_stroke_direction,
+      grasp_stroke_normal_direction, grasp_approach_direction, 0.0, M_PI / 2, 0.005, 0),
+    std::invalid_argument);
+
+  std::shared_ptr<FingerGripper> coarse_to_fine_gripper = std::make_shared<FingerGripper>(
+    id, num_fingers_side_1, num_fingers_side_2, distance_between_fingers_1,
+    distance_between_fingers_2, finger_thickness, gripper_stroke, voxel_size,
+    grasp_quality_weight1, grasp_quality_weight2, grasp_plane_dist_limit, cloud_normal_radius,
+    worldXAngleThreshold, worldYAngleThreshold, worldZAngleThreshold, grasp_stroke_direction,
+    grasp_stroke_normal_direction, grasp_approach_direction, 0.0, M_PI / 2, 0.005, 3);
+
+  emd_msgs::msg::GraspMethod grasp_method;
+  std::vector<std::shared_ptr<multiFingerGripper>> result =
+    coarse_to_fine_gripper->planGraspsWithFingerResult(
+    context, object, &grasp_method, collision_object_ptr, camera_frame);
+  EXPECT_FALSE(context.timed_out);
+  EXPECT_EQ(result.size(), grasp_method.grasp_ranks.size());
+  EXPECT_EQ(result.size(), grasp_method.grasp_poses.size());
+  for (size_t i = 1; i < result.size(); i++) {
+    EXPECT_GE(result[i - 1]->rank, result[i]->rank);
+  }
+  // Fingers of the fine level are taken from the full resolution object cloud
+  for (const auto & sample : context.grasp_samples) {
+    for (const auto & finger : sample->sample_side_1->finger_samples) {
+      EXPECT_EQ(sample->plane_index, finger->plane_index);
+    }
+    for (const auto & point : sample->sample_side_1->finger_ncloud->points) {
+      EXPECT_NE(
+        std::find_if(
+          object->cloud_normal->points.begin(), object->cloud_normal->points.end(),
+          [&point](const pcl::PointNormal & object_point) {
+            return object_point.x == point.x && object_point.y == point.y &&
+            object_point.z == point.z;
+          }),
+        object->cloud_normal->points.end());
+    }
+  }
 }
 
 // TEST_F(MultiFingerTest, planGraspsTest)
@@ -2127,18 +2412,19 @@ TEST_F(MultiFingerTest, getAllRanksTest)
 //   distance_between_fingers_2 = 0.01;
 //   gripper_stroke = 0.03;
 //   ASSERT_NO_THROW(LoadGripper());
-//   gripper->getCenterCuttingPlane(object);
-//   gripper->getCuttingPlanes(object);
-//   gripper->getGraspCloud(object);
-//   gripper->getInitialSamplePoints(object);
-//   gripper->getInitialSampleCloud(object);
-//   gripper->voxelizeSampleCloud();
-//   gripper->getMaxMinValues(object);
-//   gripper->getFingerSamples(object);
-//   gripper->getGripperClusters();
+//   gripper->getCenterCuttingPlane(context, object);
+//   gripper->getCuttingPlanes(context, object);
+//   gripper->getGraspCloud(context, object);
+//   gripper->getInitialSamplePoints(context, object);
+//   gripper->getInitialSampleCloud(context, object);
+//   gripper->voxelizeSampleCloud(context);
+//   gripper->getMaxMinValues(context, object);
+//   gripper->getFingerSamples(context, object);
+//   gripper->getGripperClusters(context);
 //   GenerateObjectCollision(0.01, 0.05, 0.02);
 //   std::vector<std::shared_ptr<multiFingerGripper>> finger_samples;
-//   finger_samples = gripper->getAllGripperConfigs(object, collision_object_ptr, camera_frame);
+//   finger_samples = gripper->getAllGripperConfigs(
+//     context, object, collision_object_ptr);
 //   emd_msgs::msg::GraspMethod grasp_method;
 //   grasp_method.ee_id = gripper->getID();
 //   grasp_method.grasp_ranks.insert(
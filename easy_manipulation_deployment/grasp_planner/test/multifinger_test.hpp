@@ -61,6 +61,7 @@ public:
   std::string camera_frame;
 
   std::shared_ptr<FingerGripper> gripper;
+  FingerPlanningContext context;
   std::shared_ptr<grasp_planner::collision::CollisionObject> collision_object_ptr;
 
   // pcl::visualization::PCLVisualizer::Ptr viewer;
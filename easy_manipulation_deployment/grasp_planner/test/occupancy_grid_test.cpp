@@ -0,0 +1,152 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include "emd/common/occupancy_grid.hpp"
+#include "emd/common/fcl_functions.hpp"
+
+namespace
+{
+std::shared_ptr<grasp_planner::collision::CollisionObject> generateGridTestWorld()
+{
+  pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZ>());
+  // Table surface with a box standing on it
+  for (float x = -0.05; x < 0.05; x += 0.0025) {
+    for (float y = -0.05; y < 0.05; y += 0.0025) {
+      cloud->points.push_back(pcl::PointXYZ(x, y, 0.0));
+    }
+  }
+  for (float x = 0.0; x < 0.02; x += 0.0025) {
+    for (float y = 0.0; y < 0.01; y += 0.0025) {
+      for (float z = 0.0; z < 0.03; z += 0.0025) {
+        cloud->points.push_back(pcl::PointXYZ(x, y, z));
+      }
+    }
+  }
+  return FCLFunctions::createCollisionObjectFromPointCloud(
+    cloud, octomap::point3d(0, 0, 0.5), 0.005, 1, FCLFunctions::IntegrationMode::OCCUPIED_ONLY);
+}
+
+bool fclSphereCollides(
+  const std::shared_ptr<grasp_planner::collision::CollisionObject> & world,
+  const Eigen::Vector3f & center, float radius)
+{
+  grasp_planner::collision::Transform sphere_transform;
+  sphere_transform.setIdentity();
+#if FCL_VERSION_0_6_OR_HIGHER == 1
+  sphere_transform.translation() << center(0), center(1), center(2);
+#else
+  sphere_transform.setTranslation(
+    grasp_planner::collision::Vector(center(0), center(1), center(2)));
+#endif
+  grasp_planner::collision::CollisionObject sphere_object(
+    std::make_shared<grasp_planner::collision::Sphere>(radius), sphere_transform);
+  grasp_planner::collision::CollisionRequest request;
+  grasp_planner::collision::CollisionResult result;
+  fcl::collide(world.get(), &sphere_object, request, result);
+  return result.isCollision();
+}
+}  // namespace
+
+TEST(OccupancyGridTest, MatchesFCL)
+{
+  std::shared_ptr<grasp_planner::collision::CollisionObject> world = generateGridTestWorld();
+  grasp_planner::collision::OccupancyGrid grid;
+  ASSERT_TRUE(grid.build(*world));
+  EXPECT_FALSE(grid.empty());
+  EXPECT_FLOAT_EQ(0.005, grid.getResolution());
+
+  /* Spheres around cell centers only reach into their own cell, and spheres around cell
+     corners overlap the eight cells sharing the corner, so no sphere just touches a cell */
+  int collisions = 0;
+  for (int x = -14; x < 14; x++) {
+    for (int y = -14; y < 14; y++) {
+      for (int z = -4; z < 10; z++) {
+        Eigen::Vector3f corner(x * 0.005, y * 0.005, z * 0.005);
+        Eigen::Vector3f center = corner + Eigen::Vector3f::Constant(0.0025);
+        bool expected_center = fclSphereCollides(world, center, 0.0024);
+        bool expected_corner = fclSphereCollides(world, corner, 0.001);
+        EXPECT_EQ(expected_center, grid.sphereCollides(center, 0.0024));
+        EXPECT_EQ(expected_corner, grid.sphereCollides(corner, 0.001));
+        collisions += expected_center;
+      }
+    }
+  }
+  EXPECT_GT(collisions, 0);
+
+  std::vector<Eigen::Vector3f> fingers{{0.0, 0.0, 0.2}, {0.01, 0.005, 0.04}};
+  EXPECT_FALSE(grid.anySphereCollides(fingers, 0.005));
+  fingers.push_back({0.01, 0.005, 0.02});
+  EXPECT_TRUE(grid.anySphereCollides(fingers, 0.005));
+}
+
+TEST(OccupancyGridTest, DistanceField)
+{
+  std::shared_ptr<grasp_planner::collision::CollisionObject> world = generateGridTestWorld();
+  grasp_planner::collision::OccupancyGrid grid;
+  ASSERT_TRUE(grid.build(*world));
+  grasp_planner::collision::OccupancyGrid grid_with_field(grid);
+  EXPECT_FALSE(grid.hasDistanceField());
+  ASSERT_TRUE(grid_with_field.computeDistanceField());
+  EXPECT_TRUE(grid_with_field.hasDistanceField());
+
+  // Inside the box, above the table next to the box, and above the box outside the grid
+  EXPECT_FLOAT_EQ(0, grid_with_field.clearance(Eigen::Vector3f(0.01, 0.005, 0.02)));
+  EXPECT_NEAR(
+    0.0225, grid_with_field.clearance(Eigen::Vector3f(-0.0375, -0.0375, 0.0275)),
+    std::sqrt(3.0) * 0.005);
+  EXPECT_NEAR(0.05, grid_with_field.clearance(Eigen::Vector3f(0.01, 0.005, 0.08)), 1e-4);
+
+  // Lookups in the distance field give the same answers as scanning the cells
+  for (int x = -14; x < 14; x++) {
+    for (int y = -14; y < 14; y++) {
+      for (int z = -4; z < 10; z++) {
+        Eigen::Vector3f center(x * 0.005 + 0.0013, y * 0.005 + 0.0031, z * 0.005 + 0.0007);
+        for (float radius : {0.0024f, 0.006f, 0.015f}) {
+          EXPECT_EQ(
+            grid.sphereCollides(center, radius), grid_with_field.sphereCollides(center, radius));
+        }
+      }
+    }
+  }
+}
+
+TEST(OccupancyGridTest, BuildFailure)
+{
+  std::shared_ptr<grasp_planner::collision::CollisionObject> world = generateGridTestWorld();
+  grasp_planner::collision::OccupancyGrid grid;
+  EXPECT_FALSE(grid.build(*world, 10));
+  EXPECT_TRUE(grid.empty());
+  EXPECT_FALSE(grid.computeDistanceField());
+  EXPECT_FALSE(grid.sphereCollides(Eigen::Vector3f(0.01, 0.005, 0.02), 0.005));
+
+  grasp_planner::collision::CollisionObject sphere(
+    std::make_shared<grasp_planner::collision::Sphere>(0.01));
+  EXPECT_FALSE(grid.build(sphere));
+}
+
+TEST(OccupancyGridTest, CollisionCheckMode)
+{
+  EXPECT_EQ(
+    grasp_planner::collision::CollisionCheckMode::FCL,
+    grasp_planner::collision::getCollisionCheckMode("fcl"));
+  EXPECT_EQ(
+    grasp_planner::collision::CollisionCheckMode::VOXEL,
+    grasp_planner::collision::getCollisionCheckMode("voxel"));
+  EXPECT_EQ(
+    grasp_planner::collision::CollisionCheckMode::VALIDATE,
+    grasp_planner::collision::getCollisionCheckMode("validate"));
+  EXPECT_THROW(grasp_planner::collision::getCollisionCheckMode("bitmap"), std::invalid_argument);
+}
@@ -14,6 +14,8 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <pcl/sample_consensus/sac_model_plane.h>
+#include <vector>
 #include "pcl_functions_test.hpp"
 
 PCLFunctionsTest::PCLFunctionsTest()
@@ -129,6 +131,217 @@ TEST_F(PCLFunctionsTest, passThroughTest)
   }
 }
 
+TEST_F(PCLFunctionsTest, SensorMsgtoFilteredPointCloudTest)
+{
+  GenerateCloud(0.05, 0.01, 0.02);
+  rectangle_cloud->points[3].x = std::numeric_limits<float>::quiet_NaN();
+  for (size_t i = 0; i < rectangle_cloud->points.size(); i++) {
+    rectangle_cloud->points[i].r = static_cast<uint8_t>(i % 256);
+    rectangle_cloud->points[i].g = 10;
+    rectangle_cloud->points[i].b = 20;
+  }
+
+  // PCL style layout with x, y, z, rgb fields and padding
+  sensor_msgs::msg::PointCloud2 pc2;
+  pc2.header.frame_id = "camera_frame";
+  pc2.height = 1;
+  pc2.width = rectangle_cloud->points.size();
+  pc2.is_bigendian = false;
+  pc2.is_dense = false;
+  pc2.point_step = 32;
+  pc2.row_step = pc2.point_step * pc2.width;
+  std::vector<std::string> names = {"x", "y", "z", "rgb"};
+  std::vector<uint32_t> offsets = {0, 4, 8, 16};
+  for (size_t i = 0; i < names.size(); i++) {
+    sensor_msgs::msg::PointField field;
+    field.name = names[i];
+    field.offset = offsets[i];
+    field.datatype = sensor_msgs::msg::PointField::FLOAT32;
+    field.count = 1;
+    pc2.fields.push_back(field);
+  }
+  pc2.data.resize(pc2.row_step * pc2.height);
+  for (size_t i = 0; i < rectangle_cloud->points.size(); i++) {
+    const auto & point = rectangle_cloud->points[i];
+    uint8_t * data = pc2.data.data() + i * pc2.point_step;
+    std::memcpy(data + 0, &point.x, sizeof(float));
+    std::memcpy(data + 4, &point.y, sizeof(float));
+    std::memcpy(data + 8, &point.z, sizeof(float));
+    std::memcpy(data + 16, &point.rgba, sizeof(uint32_t));
+  }
+
+  float ptFilter_Ulimit_x = 0.04;
+  float ptFilter_Llimit_x = 0.01;
+  float ptFilter_Ulimit_y = 0.008;
+  float ptFilter_Llimit_y = 0.001;
+  float ptFilter_Ulimit_z = 0.018;
+  float ptFilter_Llimit_z = 0.01;
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr direct_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_TRUE(
+    PCLFunctions::SensorMsgtoFilteredPointCloud(
+      pc2, direct_cloud,
+      ptFilter_Ulimit_x, ptFilter_Llimit_x,
+      ptFilter_Ulimit_y, ptFilter_Llimit_y,
+      ptFilter_Ulimit_z, ptFilter_Llimit_z));
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr converted_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PCLPointCloud2 pcl_pc2;
+  PCLFunctions::SensorMsgtoPCLPointCloud2(pc2, pcl_pc2);
+  pcl::fromPCLPointCloud2(pcl_pc2, *converted_cloud);
+  PCLFunctions::passthroughFilter(
+    converted_cloud,
+    ptFilter_Ulimit_x, ptFilter_Llimit_x,
+    ptFilter_Ulimit_y, ptFilter_Llimit_y,
+    ptFilter_Ulimit_z, ptFilter_Llimit_z);
+
+  ASSERT_GT(direct_cloud->points.size(), 0u);
+  ASSERT_EQ(direct_cloud->points.size(), converted_cloud->points.size());
+  for (size_t i = 0; i < direct_cloud->points.size(); i++) {
+    EXPECT_FLOAT_EQ(direct_cloud->points[i].x, converted_cloud->points[i].x);
+    EXPECT_FLOAT_EQ(direct_cloud->points[i].y, converted_cloud->points[i].y);
+    EXPECT_FLOAT_EQ(direct_cloud->points[i].z, converted_cloud->points[i].z);
+    EXPECT_EQ(direct_cloud->points[i].rgba, converted_cloud->points[i].rgba);
+  }
+
+  // The same points read as a two row image, with an organized copy
+  pc2.height = 2;
+  pc2.width = rectangle_cloud->points.size() / 2;
+  pc2.row_step = pc2.point_step * pc2.width;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr organized_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  EXPECT_TRUE(
+    PCLFunctions::SensorMsgtoFilteredPointCloud(
+      pc2, direct_cloud,
+      ptFilter_Ulimit_x, ptFilter_Llimit_x,
+      ptFilter_Ulimit_y, ptFilter_Llimit_y,
+      ptFilter_Ulimit_z, ptFilter_Llimit_z, organized_cloud));
+  ASSERT_TRUE(organized_cloud->isOrganized());
+  EXPECT_EQ(pc2.width, organized_cloud->width);
+  EXPECT_EQ(2u, organized_cloud->height);
+  size_t kept_points = 0;
+  for (size_t i = 0; i < organized_cloud->points.size(); i++) {
+    const pcl::PointXYZRGB & point = organized_cloud->points[i];
+    if (!pcl::isFinite(point)) {
+      continue;
+    }
+    ASSERT_LT(kept_points, direct_cloud->points.size());
+    EXPECT_FLOAT_EQ(rectangle_cloud->points[i].x, point.x);
+    EXPECT_FLOAT_EQ(rectangle_cloud->points[i].y, point.y);
+    EXPECT_FLOAT_EQ(rectangle_cloud->points[i].z, point.z);
+    EXPECT_FLOAT_EQ(direct_cloud->points[kept_points].x, point.x);
+    EXPECT_EQ(direct_cloud->points[kept_points].rgba, point.rgba);
+    kept_points++;
+  }
+  EXPECT_GT(kept_points, 0u);
+  EXPECT_EQ(direct_cloud->points.size(), kept_points);
+
+  // Unsupported layouts are left to the PCLPointCloud2 conversion
+  pc2.fields[0].datatype = sensor_msgs::msg::PointField::FLOAT64;
+  EXPECT_FALSE(
+    PCLFunctions::SensorMsgtoFilteredPointCloud(
+      pc2, direct_cloud,
+      ptFilter_Ulimit_x, ptFilter_Llimit_x,
+      ptFilter_Ulimit_y, ptFilter_Llimit_y,
+      ptFilter_Ulimit_z, ptFilter_Llimit_z));
+}
+
+TEST_F(PCLFunctionsTest, preprocessCloudTest)
+{
+  // Large enough for four worker chunks of at least 16384 points each, so that the chunks
+  // of the 4 thread run are merged, and their boundaries fall inside the crop limits
+  GenerateCloud(0.2, 0.2, 0.05);
+  ASSERT_GE(rectangle_cloud->points.size(), 4u * 16384u);
+  for (size_t i = 0; i < rectangle_cloud->points.size(); i++) {
+    rectangle_cloud->points[i].r = static_cast<uint8_t>(i % 256);
+    rectangle_cloud->points[i].g = static_cast<uint8_t>((i * 7) % 256);
+    rectangle_cloud->points[i].b = 20;
+  }
+  rectangle_cloud->points[5].z = std::numeric_limits<float>::quiet_NaN();
+  rectangle_cloud->points[100].y = std::numeric_limits<float>::infinity();
+  rectangle_cloud->width = rectangle_cloud->points.size();
+  rectangle_cloud->height = 1;
+
+  float ptFilter_Ulimit_x = 0.18;
+  float ptFilter_Llimit_x = 0.01;
+  float ptFilter_Ulimit_y = 0.09;
+  float ptFilter_Llimit_y = 0.0;
+  float ptFilter_Ulimit_z = 0.04;
+  float ptFilter_Llimit_z = 0.005;
+  float leaf_size = 0.01;
+
+  // Reference chain using the PCL filters
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr reference_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr reference_voxels(new pcl::PointCloud<pcl::PointXYZRGB>);
+  std::vector<int> nan_indices;
+  pcl::removeNaNFromPointCloud(*rectangle_cloud, *reference_cloud, nan_indices);
+  pcl::PassThrough<pcl::PointXYZRGB> pt_filter;
+  pt_filter.setInputCloud(reference_cloud);
+  pt_filter.setFilterFieldName("z");
+  pt_filter.setFilterLimits(ptFilter_Llimit_z, ptFilter_Ulimit_z);
+  pt_filter.filter(*reference_cloud);
+  pt_filter.setInputCloud(reference_cloud);
+  pt_filter.setFilterFieldName("y");
+  pt_filter.setFilterLimits(ptFilter_Llimit_y, ptFilter_Ulimit_y);
+  pt_filter.filter(*reference_cloud);
+  pt_filter.setInputCloud(reference_cloud);
+  pt_filter.setFilterFieldName("x");
+  pt_filter.setFilterLimits(ptFilter_Llimit_x, ptFilter_Ulimit_x);
+  pt_filter.filter(*reference_cloud);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr reference_cropped(
+    new pcl::PointCloud<pcl::PointXYZRGB>(*reference_cloud));
+  PCLFunctions::removeStatisticalOutlier(reference_cloud, 1.0);
+  PCLFunctions::voxelizeCloud<pcl::PointCloud<pcl::PointXYZRGB>::Ptr,
+    pcl::VoxelGrid<pcl::PointXYZRGB>>(reference_cloud, leaf_size, reference_voxels);
+
+  for (int num_threads : {1, 4}) {
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr filtered_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr voxelized_cloud(
+      new pcl::PointCloud<pcl::PointXYZRGB>);
+    EXPECT_TRUE(
+      PCLFunctions::preprocessCloud(
+        rectangle_cloud,
+        ptFilter_Ulimit_x, ptFilter_Llimit_x,
+        ptFilter_Ulimit_y, ptFilter_Llimit_y,
+        ptFilter_Ulimit_z, ptFilter_Llimit_z,
+        1.0, leaf_size, filtered_cloud, voxelized_cloud, num_threads));
+
+    ASSERT_EQ(filtered_cloud->points.size(), reference_cloud->points.size());
+    for (size_t i = 0; i < filtered_cloud->points.size(); i++) {
+      EXPECT_FLOAT_EQ(filtered_cloud->points[i].x, reference_cloud->points[i].x);
+      EXPECT_FLOAT_EQ(filtered_cloud->points[i].y, reference_cloud->points[i].y);
+      EXPECT_FLOAT_EQ(filtered_cloud->points[i].z, reference_cloud->points[i].z);
+    }
+    ASSERT_EQ(voxelized_cloud->points.size(), reference_voxels->points.size());
+    for (size_t i = 0; i < voxelized_cloud->points.size(); i++) {
+      EXPECT_NEAR(voxelized_cloud->points[i].x, reference_voxels->points[i].x, 1e-5);
+      EXPECT_NEAR(voxelized_cloud->points[i].y, reference_voxels->points[i].y, 1e-5);
+      EXPECT_NEAR(voxelized_cloud->points[i].z, reference_voxels->points[i].z, 1e-5);
+      EXPECT_NEAR(voxelized_cloud->points[i].r, reference_voxels->points[i].r, 1);
+      EXPECT_NEAR(voxelized_cloud->points[i].g, reference_voxels->points[i].g, 1);
+      EXPECT_NEAR(voxelized_cloud->points[i].b, reference_voxels->points[i].b, 1);
+    }
+
+    // The same chain on a cloud that was already cropped
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr downsampled_cloud(
+      new pcl::PointCloud<pcl::PointXYZRGB>);
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr downsampled_voxels(
+      new pcl::PointCloud<pcl::PointXYZRGB>);
+    EXPECT_TRUE(
+      PCLFunctions::downsampleCloud(
+        reference_cropped, 1.0, leaf_size, downsampled_cloud, downsampled_voxels, num_threads));
+    ASSERT_EQ(downsampled_cloud->points.size(), reference_cloud->points.size());
+    ASSERT_EQ(downsampled_voxels->points.size(), reference_voxels->points.size());
+    for (size_t i = 0; i < downsampled_voxels->points.size(); i++) {
+      EXPECT_NEAR(downsampled_voxels->points[i].x, reference_voxels->points[i].x, 1e-5);
+      EXPECT_NEAR(downsampled_voxels->points[i].y, reference_voxels->points[i].y, 1e-5);
+      EXPECT_NEAR(downsampled_voxels->points[i].z, reference_voxels->points[i].z, 1e-5);
+    }
+  }
+  EXPECT_FALSE(
+    PCLFunctions::downsampleCloud(
+      reference_cropped, 1.0, 0, reference_cropped, reference_voxels, 1));
+}
+
 TEST_F(PCLFunctionsTest, planeSegmentationTest)
 {
 
@@ -290,6 +503,84 @@ TEST_F(PCLFunctionsTest, computeCloudNormalTest)
   EXPECT_GT(static_cast<int>(rectNormalCloud->points.size()), 0);
 }
 
+TEST_F(PCLFunctionsTest, computeCloudNormalMatchesNormalEstimationTest)
+{
+  GenerateCloud(0.05, 0.01, 0.02);
+  pcl::PointCloud<pcl::PointNormal> expected_cloud;
+  pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>());
+  pcl::NormalEstimationOMP<pcl::PointXYZRGB, pcl::PointNormal> normal_estimation;
+  normal_estimation.setNumberOfThreads(1);
+  normal_estimation.setInputCloud(rectangle_cloud);
+  normal_estimation.setSearchMethod(tree);
+  normal_estimation.setRadiusSearch(0.01);
+  normal_estimation.compute(expected_cloud);
+
+  for (int num_threads : {1, 4}) {
+    pcl::PointCloud<pcl::PointNormal>::Ptr rectNormalCloud(
+      new pcl::PointCloud<pcl::PointNormal>());
+    pcl::search::KdTree<pcl::PointXYZRGB>::Ptr search(
+      new pcl::search::KdTree<pcl::PointXYZRGB>());
+    search->setInputCloud(rectangle_cloud);
+    PCLFunctions::computeCloudNormal(
+      rectangle_cloud, rectNormalCloud, 0.01, search, num_threads);
+
+    ASSERT_EQ(expected_cloud.points.size(), rectNormalCloud->points.size());
+    for (size_t i = 0; i < rectNormalCloud->points.size(); i++) {
+      EXPECT_FLOAT_EQ(rectangle_cloud->points[i].x, rectNormalCloud->points[i].x);
+      EXPECT_FLOAT_EQ(rectangle_cloud->points[i].z, rectNormalCloud->points[i].z);
+      EXPECT_NEAR(expected_cloud.points[i].normal_x, rectNormalCloud->points[i].normal_x, 1e-4);
+      EXPECT_NEAR(expected_cloud.points[i].normal_y, rectNormalCloud->points[i].normal_y, 1e-4);
+      EXPECT_NEAR(expected_cloud.points[i].normal_z, rectNormalCloud->points[i].normal_z, 1e-4);
+    }
+  }
+}
+
+TEST_F(PCLFunctionsTest, computeClusterNormalTest)
+{
+  GenerateCloud(0.05, 0.01, 0.02);
+  // Second box, separate from the first but within the normal radius of it
+  for (float length_ = 0.06; length_ < 0.08; length_ += 0.0025) {
+    for (float breadth_ = 0.0; breadth_ < 0.01; breadth_ += 0.0025) {
+      for (float height_ = 0.0; height_ < 0.02; height_ += 0.0025) {
+        pcl::PointXYZRGB temp_point;
+        temp_point.x = length_;
+        temp_point.y = breadth_;
+        temp_point.z = height_;
+        rectangle_cloud->points.push_back(temp_point);
+      }
+    }
+  }
+  pcl::search::KdTree<pcl::PointXYZRGB>::Ptr tree(new pcl::search::KdTree<pcl::PointXYZRGB>());
+  tree->setInputCloud(rectangle_cloud);
+  std::vector<pcl::PointIndices> clusters =
+    PCLFunctions::extractPointCloudClusters(rectangle_cloud, 0.005, 10, tree);
+  ASSERT_EQ(2, static_cast<int>(clusters.size()));
+
+  for (const auto & cluster : clusters) {
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr cluster_cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
+    for (int index : cluster.indices) {
+      cluster_cloud->points.push_back(rectangle_cloud->points[index]);
+    }
+    pcl::PointCloud<pcl::PointNormal>::Ptr expected_normal(
+      new pcl::PointCloud<pcl::PointNormal>());
+    PCLFunctions::computeCloudNormal(cluster_cloud, expected_normal, 0.03);
+
+    pcl::PointCloud<pcl::PointNormal>::Ptr cluster_normal(
+      new pcl::PointCloud<pcl::PointNormal>());
+    PCLFunctions::computeClusterNormal(
+      rectangle_cloud, tree, cluster, cluster_normal, 0.03, 2);
+
+    ASSERT_EQ(expected_normal->points.size(), cluster_normal->points.size());
+    for (size_t i = 0; i < cluster_normal->points.size(); i++) {
+      EXPECT_FLOAT_EQ(expected_normal->points[i].x, cluster_normal->points[i].x);
+      EXPECT_NEAR(expected_normal->points[i].normal_x, cluster_normal->points[i].normal_x, 1e-4);
+      EXPECT_NEAR(expected_normal->points[i].normal_y, cluster_normal->points[i].normal_y, 1e-4);
+      EXPECT_NEAR(expected_normal->points[i].normal_z, cluster_normal->points[i].normal_z, 1e-4);
+      EXPECT_NEAR(expected_normal->points[i].curvature, cluster_normal->points[i].curvature, 1e-4);
+    }
+  }
+}
+
 TEST_F(PCLFunctionsTest, extractPointCloudClustersTest)
 {
   GenerateCloud(0.05, 0.01, 0.02);
@@ -322,3 +613,80 @@ TEST_F(PCLFunctionsTest, extractPointCloudClustersTestEmpty)
     PCLFunctions::extractPointCloudClusters(rectangle_cloud, 0.005, 50);
   EXPECT_TRUE(indices.empty());
 }
+
+TEST_F(PCLFunctionsTest, extractOrganizedClustersTest)
+{
+  // 60 x 40 depth image of a table at z = 0.5 with two boxes raised 5cm above it
+  const int width = 60;
+  const int height = 40;
+  const float step = 0.005;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr organized_cloud(
+    new pcl::PointCloud<pcl::PointXYZRGB>(width, height));
+  for (int v = 0; v < height; v++) {
+    for (int u = 0; u < width; u++) {
+      pcl::PointXYZRGB & point = organized_cloud->at(u, v);
+      point.x = u * step;
+      point.y = v * step;
+      point.z = 0.5;
+      if (v >= 10 && v < 30 && ((u >= 5 && u < 20) || (u >= 35 && u < 55))) {
+        point.z = 0.45;
+      }
+      if (u == 0 && v % 2 == 0) {
+        point.x = point.y = point.z = std::numeric_limits<float>::quiet_NaN();
+      }
+    }
+  }
+  organized_cloud->is_dense = false;
+  const std::vector<float> plane = {0.0, 0.0, 1.0, -0.5};
+
+  std::vector<pcl::PointIndices> clusters = PCLFunctions::extractOrganizedClusters(
+    organized_cloud, plane, 0.01, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, 0.01, 50, 0.0);
+  ASSERT_EQ(2, static_cast<int>(clusters.size()));
+  EXPECT_EQ(20 * 20, static_cast<int>(clusters[0].indices.size()));
+  EXPECT_EQ(15 * 20, static_cast<int>(clusters[1].indices.size()));
+  for (const auto & cluster : clusters) {
+    for (int index : cluster.indices) {
+      EXPECT_FLOAT_EQ(0.45, organized_cloud->points[index].z);
+    }
+  }
+
+  // Without the plane the table joins both boxes into a single component
+  clusters = PCLFunctions::extractOrganizedClusters(
+    organized_cloud, std::vector<float>(), 0.01, 1.0, -1.0, 1.0, -1.0, 1.0, 0.0, 0.1, 50, 0.0);
+  EXPECT_EQ(1, static_cast<int>(clusters.size()));
+}
+
+TEST_F(PCLFunctionsTest, extractOrganizedClustersTestUnorganized)
+{
+  GenerateCloud(0.05, 0.01, 0.02);
+  std::vector<pcl::PointIndices> clusters = PCLFunctions::extractOrganizedClusters(
+    rectangle_cloud, {0.0, 0.0, 1.0, 0.0}, 0.01, 1.0, -1.0, 1.0, -1.0, 1.0, -1.0, 0.005, 10, 0.0);
+  EXPECT_TRUE(clusters.empty());
+}
+
+TEST_F(PCLFunctionsTest, selectWithinDistanceOfPlanesTest)
+{
+  GenerateCloud(0.05, 0.01, 0.02);
+  pcl::PointCloud<pcl::PointNormal>::Ptr rectNormalCloud(
+    new pcl::PointCloud<pcl::PointNormal>());
+  pcl::copyPointCloud(*rectangle_cloud, *rectNormalCloud);
+
+  // Parallel planes with an unnormalized normal, and one plane with another normal
+  const Eigen::Vector3f normal(0.4, 0.1, 0.2);
+  std::vector<Eigen::Vector4f> planes;
+  for (int i = -3; i <= 3; i++) {
+    planes.emplace_back(normal(0), normal(1), normal(2), -0.01 + 0.0037 * i);
+  }
+  planes.emplace_back(0.0, 0.0, 1.0, -0.01);
+
+  const float threshold = 0.002;
+  std::vector<std::vector<int>> plane_indices = PCLFunctions::selectWithinDistanceOfPlanes(
+    rectNormalCloud, planes, threshold);
+  ASSERT_EQ(planes.size(), plane_indices.size());
+  pcl::SampleConsensusModelPlane<pcl::PointNormal> plane_model(rectNormalCloud);
+  for (size_t i = 0; i < planes.size(); i++) {
+    std::vector<int> expected_indices;
+    plane_model.selectWithinDistance(planes[i], threshold, expected_indices);
+    EXPECT_EQ(expected_indices, plane_indices[i]);
+  }
+}
@@ -0,0 +1,113 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include "emd/common/plane_tracker.hpp"
+
+namespace
+{
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr generatePlaneTrackerCloud(float table_height)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
+  // Table surface
+  for (float x = -0.1; x < 0.1; x += 0.005) {
+    for (float y = -0.1; y < 0.1; y += 0.005) {
+      pcl::PointXYZRGB point;
+      point.x = x;
+      point.y = y;
+      point.z = table_height;
+      cloud->points.push_back(point);
+    }
+  }
+  // Box standing on the table
+  for (float x = 0.0; x < 0.04; x += 0.005) {
+    for (float y = 0.0; y < 0.04; y += 0.005) {
+      for (float z = 0.01; z < 0.05; z += 0.005) {
+        pcl::PointXYZRGB point;
+        point.x = x;
+        point.y = y;
+        point.z = table_height - z;
+        cloud->points.push_back(point);
+      }
+    }
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+  return cloud;
+}
+}  // namespace
+
+TEST(PlaneTrackerTest, TrackStaticPlane)
+{
+  grasp_planner::PlaneTracker tracker;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud = generatePlaneTrackerCloud(0.5);
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed(
+    new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table(new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::ModelCoefficients coefficients;
+
+  EXPECT_FALSE(tracker.hasPlane());
+  ASSERT_TRUE(tracker.segment(cloud, cloud_plane_removed, cloud_table, coefficients, 50, 0.002));
+  EXPECT_TRUE(tracker.hasPlane());
+  EXPECT_FALSE(tracker.lastPlaneTracked());
+  ASSERT_EQ(4u, coefficients.values.size());
+  EXPECT_NEAR(1.0, std::abs(coefficients.values[2]), 0.001);
+  EXPECT_NEAR(0.5, std::abs(coefficients.values[3]), 0.001);
+  size_t table_size = cloud_table->points.size();
+  size_t removed_size = cloud_plane_removed->points.size();
+  EXPECT_EQ(cloud->points.size(), table_size + removed_size);
+
+  // The same scene keeps the plane and gives the same split
+  ASSERT_TRUE(tracker.segment(cloud, cloud_plane_removed, cloud_table, coefficients, 50, 0.002));
+  EXPECT_TRUE(tracker.lastPlaneTracked());
+  EXPECT_NEAR(0.5, std::abs(coefficients.values[3]), 0.001);
+  EXPECT_EQ(table_size, cloud_table->points.size());
+  EXPECT_EQ(removed_size, cloud_plane_removed->points.size());
+}
+
+TEST(PlaneTrackerTest, RefitMovedPlane)
+{
+  grasp_planner::PlaneTracker tracker;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed(
+    new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table(new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::ModelCoefficients coefficients;
+
+  ASSERT_TRUE(
+    tracker.segment(
+      generatePlaneTrackerCloud(0.5), cloud_plane_removed, cloud_table, coefficients, 50, 0.002));
+
+  // The table is now further away, so the tracked plane fails validation
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr moved_cloud = generatePlaneTrackerCloud(0.6);
+  ASSERT_TRUE(
+    tracker.segment(moved_cloud, cloud_plane_removed, cloud_table, coefficients, 50, 0.002));
+  EXPECT_FALSE(tracker.lastPlaneTracked());
+  EXPECT_NEAR(0.6, std::abs(coefficients.values[3]), 0.001);
+  for (const auto & point : cloud_table->points) {
+    EXPECT_NEAR(0.6, point.z, 0.002);
+  }
+}
+
+TEST(PlaneTrackerTest, EmptyCloud)
+{
+  grasp_planner::PlaneTracker tracker;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_plane_removed(
+    new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_table(new pcl::PointCloud<pcl::PointXYZRGB>());
+  pcl::ModelCoefficients coefficients;
+  EXPECT_FALSE(tracker.segment(cloud, cloud_plane_removed, cloud_table, coefficients, 50, 0.002));
+  EXPECT_FALSE(tracker.hasPlane());
+}
@@ -37,6 +37,7 @@ void SuctionGripperTest::ResetVariables()
   curvature_weight = 1.0;
   grasp_center_distance_weight = 1.0;
   num_contact_points_weight = 1.0;
+  contact_raster_resolution = 0.0;
   length_direction = "x";
   breadth_direction = "y";
   grasp_approach_direction = "z";
@@ -61,7 +62,9 @@ void SuctionGripperTest::LoadGripperWithWeights()
     num_contact_points_weight,
     length_direction,
     breadth_direction,
-    grasp_approach_direction);
+    grasp_approach_direction,
+    0.0,
+    contact_raster_resolution);
   gripper = std::make_shared<SuctionGripper>(gripper_);
 }
 
@@ -224,6 +227,10 @@ TEST_F(SuctionGripperTest, NegAttributes)
   ResetVariables();
   search_angle_resolution = -1;
   EXPECT_THROW(LoadGripperWithWeights(), std::invalid_argument);
+
+  ResetVariables();
+  contact_raster_resolution = -1;
+  EXPECT_THROW(LoadGripperWithWeights(), std::invalid_argument);
 }
 
 TEST_F(SuctionGripperTest, InvalidWeights)
@@ -426,6 +433,65 @@ TEST_F(SuctionGripperTest, getSlicedCloudTest)
     (0.05 / 0.0025) * (0.03 / 0.0025 + 1),
     static_cast<int>(sliced_cloud_normal->points.size()));
 }
+TEST_F(SuctionGripperTest, getHeightSortedCloudTest)
+{
+  float radius = 0.05;
+  Eigen::Vector3f centerpoint{0.025, 0.0125, 0.05};
+  ResetVariables();
+  CreateSphereCloud(centerpoint, radius, 50, 0.5, 0.25, 1.0);
+  ASSERT_NO_THROW(LoadGripperWithWeights());
+  gripper->generateGripperAttributes();
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr sorted_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PointCloud<pcl::PointNormal>::Ptr sorted_cloud_normal(
+    new pcl::PointCloud<pcl::PointNormal>);
+  std::vector<float> sorted_heights = gripper->getHeightSortedCloud(
+    object->cloud, object->cloud_normal, 0, sorted_cloud, sorted_cloud_normal, 'z');
+  ASSERT_EQ(sorted_heights.size(), sorted_cloud->points.size());
+  ASSERT_EQ(sorted_heights.size(), sorted_cloud_normal->points.size());
+  for (size_t i = 0; i < sorted_heights.size(); i++) {
+    EXPECT_EQ(sorted_heights[i], sorted_cloud->points[i].z);
+    EXPECT_EQ(sorted_heights[i], sorted_cloud_normal->points[i].z);
+    if (i > 0) {
+      EXPECT_LE(sorted_heights[i - 1], sorted_heights[i]);
+    }
+  }
+
+  // A slice is the prefix of the sorted points up to its top limit
+  for (float top_limit : {0.0f, 0.03f, 0.05f, 0.08f, 0.2f}) {
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr sliced_cloud(
+      new pcl::PointCloud<pcl::PointXYZRGB>);
+    pcl::PointCloud<pcl::PointNormal>::Ptr sliced_cloud_normal(
+      new pcl::PointCloud<pcl::PointNormal>);
+    gripper->getSlicedCloud(
+      object->cloud, object->cloud_normal, top_limit, 0, sliced_cloud,
+      sliced_cloud_normal, 'z');
+    const size_t slice_size = std::upper_bound(
+      sorted_heights.begin(), sorted_heights.end(), top_limit) - sorted_heights.begin();
+    EXPECT_EQ(sliced_cloud->points.size(), slice_size);
+    EXPECT_EQ(sliced_cloud_normal->points.size(), slice_size);
+
+    // Searching the first slice_size sorted points matches searching a copy of them
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr prefix_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+    pcl::PointCloud<pcl::PointNormal>::Ptr prefix_cloud_normal(
+      new pcl::PointCloud<pcl::PointNormal>);
+    prefix_cloud->points.assign(
+      sorted_cloud->points.begin(), sorted_cloud->points.begin() + slice_size);
+    prefix_cloud_normal->points.assign(
+      sorted_cloud_normal->points.begin(), sorted_cloud_normal->points.begin() + slice_size);
+    EXPECT_EQ(
+      gripper->getCentroidIndex(prefix_cloud),
+      gripper->getCentroidIndex(sorted_cloud, slice_size));
+    pcl::PointXYZ cup_point(centerpoint(0), centerpoint(1), top_limit);
+    float prefix_curvature_sum = 0;
+    float curvature_sum = 0;
+    EXPECT_EQ(
+      gripper->getContactPoints(
+        prefix_cloud, prefix_cloud_normal, cup_point, prefix_curvature_sum),
+      gripper->getContactPoints(
+        sorted_cloud, sorted_cloud_normal, cup_point, curvature_sum, slice_size));
+    EXPECT_FLOAT_EQ(prefix_curvature_sum, curvature_sum);
+  }
+}
 TEST_F(SuctionGripperTest, projectCloudToPlaneTest)
 {
   float radius = 0.05;
@@ -795,6 +861,63 @@ TEST_F(SuctionGripperTest, generateSuctionCupTest) {
   EXPECT_EQ(cup_none.contact_points, 0);
 }
 
+TEST_F(SuctionGripperTest, generateSuctionCupRasterTest) {
+  ResetVariables();
+  contact_raster_resolution = 0.0005;
+  GenerateObjectHorizontal();
+  ASSERT_NO_THROW(LoadGripperWithWeights());
+  gripper->generateGripperAttributes();
+  pcl::PointXYZRGB object_top_point = gripper->findHighestPoint(object->cloud, 'z', true);
+  pcl::ModelCoefficients::Ptr plane(new pcl::ModelCoefficients);
+  gripper->getStartingPlane(
+    plane, object->minor_axis,
+    object->centerpoint, object_top_point, 'z');
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr sliced_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::PointCloud<pcl::PointNormal>::Ptr sliced_cloud_normal(
+    new pcl::PointCloud<pcl::PointNormal>);
+  gripper->getSlicedCloud(
+    object->cloud, object->cloud_normal, 0, 0, sliced_cloud,
+    sliced_cloud_normal, 'z');
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr projected_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  gripper->projectCloudToPlane(sliced_cloud, plane, projected_cloud);
+
+  std::shared_ptr<const grasp_planner::ContactRaster> contact_raster =
+    gripper->getContactRaster(projected_cloud, sliced_cloud_normal);
+  ASSERT_TRUE(contact_raster != nullptr);
+  EXPECT_FLOAT_EQ(cup_radius, contact_raster->getRadius());
+
+  pcl::PointXYZ object_center;
+  object_center.x = object->centerpoint(0);
+  object_center.y = object->centerpoint(1);
+  object_center.z = object->centerpoint(2);
+  float object_max_dim =
+    *std::max_element(std::begin(object->dimensions), std::end(object->dimensions));
+
+  Eigen::Vector3f full_cup_point{0.025, 0.015, 0.01};
+  Eigen::Vector3f half_cup_point{0.025, 0.03, 0.01};
+  Eigen::Vector3f no_cup_point{0.06, 0.05, 0.04};
+
+  singleSuctionCup cup_full = gripper->generateSuctionCup(
+    projected_cloud, sliced_cloud_normal,
+    full_cup_point, object_center, object_max_dim, contact_raster);
+  singleSuctionCup cup_half = gripper->generateSuctionCup(
+    projected_cloud, sliced_cloud_normal,
+    half_cup_point, object_center, object_max_dim, contact_raster);
+  singleSuctionCup cup_none = gripper->generateSuctionCup(
+    projected_cloud, sliced_cloud_normal,
+    no_cup_point, object_center, object_max_dim, contact_raster);
+
+  EXPECT_GT(cup_full.contact_points, cup_half.contact_points);
+  EXPECT_GT(cup_half.contact_points, 0);
+  EXPECT_EQ(cup_none.contact_points, 0);
+
+  // The raster only moves points on the rim of a cup in or out of it
+  singleSuctionCup cup_full_points = gripper->generateSuctionCup(
+    projected_cloud, sliced_cloud_normal,
+    full_cup_point, object_center, object_max_dim);
+  EXPECT_NEAR(cup_full_points.contact_points, cup_full.contact_points, 4);
+}
+
 // Temporary comment for testing of suction gripper
 // TEST_F(SuctionGripperTest, generateGraspSampleTest) {
 //   ResetVariables();
@@ -917,6 +1040,49 @@ TEST_F(SuctionGripperTest, updateMaxMinValuesTest) {
   EXPECT_NEAR(15, gripper->min_contact_points, 0.00001);
 }
 
+TEST_F(SuctionGripperTest, mergeSampleBuffersTest) {
+
+  ResetVariables();
+  Eigen::Vector3f centerpoint{0.0125, 0.08, 0.04};
+  CreateSphereCloud(centerpoint, 0.08, 50, 0.25, 1, 0.5);
+  ASSERT_NO_THROW(LoadGripperWithWeights());
+  gripper->generateGripperAttributes();
+
+  auto make_sample = [](int contact_points, float average_curvature, float center_dist) {
+      pcl::PointXYZ center;
+      std::shared_ptr<suctionCupArray> sample = std::make_shared<suctionCupArray>(
+        center, Eigen::Vector3f::UnitX(), Eigen::Vector3f::UnitY());
+      sample->total_contact_points = contact_points;
+      sample->average_curvature = average_curvature;
+      sample->center_dist = center_dist;
+      return sample;
+    };
+  std::vector<suctionSampleBuffer> buffers(3);
+  buffers[0].add(make_sample(45, 0.004, 0.002));
+  buffers[0].add(make_sample(15, 0.001, 0.0005));
+  buffers[2].add(make_sample(55, 0.007, 0.006));
+  buffers[2].exhaustive = false;
+  std::vector<std::shared_ptr<suctionCupArray>> expected{
+    buffers[0].samples[0], buffers[0].samples[1], buffers[2].samples[0]};
+
+  gripper->mergeSampleBuffers(buffers);
+  // Samples are appended in the order of the buffers
+  ASSERT_EQ(expected.size(), gripper->cup_array_samples.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i], gripper->cup_array_samples[i]);
+  }
+  for (const auto & buffer : buffers) {
+    EXPECT_TRUE(buffer.samples.empty());
+  }
+  EXPECT_NEAR(0.006, gripper->max_center_dist, 0.00001);
+  EXPECT_NEAR(0.0005, gripper->min_center_dist, 0.00001);
+  EXPECT_NEAR(0.007, gripper->max_curvature, 0.00001);
+  EXPECT_NEAR(0.001, gripper->min_curvature, 0.00001);
+  EXPECT_EQ(55, gripper->max_contact_points);
+  EXPECT_EQ(15, gripper->min_contact_points);
+  EXPECT_FALSE(gripper->exhaustive);
+}
+
 TEST_F(SuctionGripperTest, getAllPossibleGraspsTest) {
 
   ResetVariables();
@@ -941,6 +1107,11 @@ TEST_F(SuctionGripperTest, getAllPossibleGraspsTest) {
   EXPECT_GT(static_cast<int>(gripper->cup_array_samples.size()), 0);
   for (auto grasp_sample : gripper->cup_array_samples) {
     EXPECT_NEAR(0, grasp_sample->rank, 0.0001);
+    // The attribute ranges merged from all slices cover every sample
+    EXPECT_LE(gripper->min_contact_points, grasp_sample->total_contact_points);
+    EXPECT_GE(gripper->max_contact_points, grasp_sample->total_contact_points);
+    EXPECT_LE(gripper->min_center_dist, grasp_sample->center_dist);
+    EXPECT_GE(gripper->max_center_dist, grasp_sample->center_dist);
   }
 }
 
@@ -967,9 +1138,14 @@ TEST_F(SuctionGripperTest, getAllRanksTest) {
   for (auto grasp_sample : gripper->cup_array_samples) {
     EXPECT_NEAR(0, grasp_sample->rank, 0.0001);
   }
+  const size_t num_samples = gripper->cup_array_samples.size();
   emd_msgs::msg::GraspMethod grasp_method;
   gripper->getAllGraspRanks(&grasp_method, object);
 
+  // No grasp sample is dropped
+  EXPECT_EQ(num_samples, gripper->cup_array_samples.size());
+  EXPECT_EQ(num_samples, grasp_method.grasp_ranks.size());
+  EXPECT_EQ(num_samples, grasp_method.grasp_poses.size());
   for (auto grasp_sample : gripper->cup_array_samples) {
     EXPECT_GT(grasp_sample->rank, 0);
   }
@@ -1142,14 +1318,11 @@ TEST_F(SuctionGripperTest, planGraspsTest)
 
   emd_msgs::msg::GraspMethod grasp_method;
   grasp_method.ee_id = gripper->getID();
-  grasp_method.grasp_ranks.insert(
-    grasp_method.grasp_ranks.begin(), std::numeric_limits<float>::min());
   EXPECT_EQ(0, static_cast<int>(grasp_method.grasp_poses.size()));
-  EXPECT_EQ(1, static_cast<int>(grasp_method.grasp_ranks.size()));
+  EXPECT_EQ(0, static_cast<int>(grasp_method.grasp_ranks.size()));
   gripper->planGrasps(
     object, &grasp_method, collision_object_ptr,
     "camera_frame");
-  grasp_method.grasp_ranks.pop_back();
   object->grasp_target.grasp_methods.push_back(grasp_method);
 
   EXPECT_GT(static_cast<int>(grasp_method.grasp_poses.size()), 0);
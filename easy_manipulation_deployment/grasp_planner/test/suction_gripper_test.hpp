@@ -55,6 +55,7 @@ public:
   float curvature_weight;
   float grasp_center_distance_weight;
   float num_contact_points_weight;
+  float contact_raster_resolution;
   std::string length_direction;
   std::string breadth_direction;
   std::string grasp_approach_direction;
@@ -0,0 +1,67 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include "emd/common/thread_pool.hpp"
+
+TEST(ThreadPoolTest, ParallelForCoversRange)
+{
+  grasp_planner::ThreadPool pool(4);
+  EXPECT_EQ(4u, pool.size());
+  std::vector<int> visits(1000, 0);
+  pool.parallelFor(10, 1000, [&visits](std::size_t i) {visits[i]++;});
+  for (std::size_t i = 0; i < visits.size(); i++) {
+    EXPECT_EQ(i < 10 ? 0 : 1, visits[i]);
+  }
+}
+
+TEST(ThreadPoolTest, NestedParallelFor)
+{
+  grasp_planner::ThreadPool pool(3);
+  std::vector<std::vector<std::size_t>> products(20);
+  pool.parallelFor(
+    0, products.size(), [&pool, &products](std::size_t i) {
+      products[i].resize(50);
+      pool.parallelFor(
+        0, products[i].size(), [&products, i](std::size_t j) {products[i][j] = i * j;});
+    });
+  for (std::size_t i = 0; i < products.size(); i++) {
+    for (std::size_t j = 0; j < products[i].size(); j++) {
+      EXPECT_EQ(i * j, products[i][j]);
+    }
+  }
+}
+
+TEST(ThreadPoolTest, ExceptionRethrown)
+{
+  grasp_planner::ThreadPool pool(2);
+  EXPECT_THROW(
+    pool.parallelFor(
+      0, 8, [](std::size_t i) {
+        if (i == 5) {
+          throw std::runtime_error("iteration failed");
+        }
+      }),
+    std::runtime_error);
+}
+
+TEST(ThreadPoolTest, GlobalThreads)
+{
+  grasp_planner::ThreadPool::setGlobalThreads(2);
+  EXPECT_EQ(2u, grasp_planner::ThreadPool::global()->size());
+  grasp_planner::ThreadPool::setGlobalThreads(0);
+  EXPECT_LE(1u, grasp_planner::ThreadPool::global()->size());
+}
@@ -0,0 +1,121 @@
+// Copyright 2020 Advanced Remanufacturing and Technology Centre
+// Copyright 2020 ROS-Industrial Consortium Asia Pacific Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+#include "emd/common/world_model.hpp"
+
+namespace
+{
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr generateWorldModelCloud(
+  float x_offset, bool with_box)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>());
+  // Table surface, minus the part hidden by the box from a sensor at the origin
+  for (float x = -0.1; x < 0.1; x += 0.0025) {
+    for (float y = -0.1; y < 0.1; y += 0.0025) {
+      float hidden_x = x * 0.45 / 0.5 - x_offset;
+      float hidden_y = y * 0.45 / 0.5;
+      if (with_box && hidden_x >= 0 && hidden_x < 0.02 && hidden_y >= 0 && hidden_y < 0.02) {
+        continue;
+      }
+      pcl::PointXYZRGB point;
+      point.x = x;
+      point.y = y;
+      point.z = 0.5;
+      cloud->points.push_back(point);
+    }
+  }
+  // Top of a box standing on the table
+  if (with_box) {
+    for (float x = 0.0; x < 0.02; x += 0.0025) {
+      for (float y = 0.0; y < 0.02; y += 0.0025) {
+        pcl::PointXYZRGB point;
+        point.x = x + x_offset;
+        point.y = y;
+        point.z = 0.45;
+        cloud->points.push_back(point);
+      }
+    }
+  }
+  return cloud;
+}
+
+bool collidesWithSphere(
+  const std::shared_ptr<grasp_planner::collision::CollisionObject> & world,
+  float x, float y, float z)
+{
+  grasp_planner::collision::Transform sphere_transform;
+  sphere_transform.setIdentity();
+#if FCL_VERSION_0_6_OR_HIGHER == 1
+  sphere_transform.translation() << x, y, z;
+#else
+  sphere_transform.setTranslation(grasp_planner::collision::Vector(x, y, z));
+#endif
+  grasp_planner::collision::CollisionObject sphere_object(
+    std::make_shared<grasp_planner::collision::Sphere>(0.004), sphere_transform);
+  grasp_planner::collision::CollisionRequest request;
+  grasp_planner::collision::CollisionResult result;
+  fcl::collide(world.get(), &sphere_object, request, result);
+  return result.isCollision();
+}
+}  // namespace
+
+TEST(WorldModelTest, IntegrateStaticScene)
+{
+  grasp_planner::collision::WorldModel world_model(0.005);
+  octomap::point3d sensor_origin(0, 0, 0);
+
+  EXPECT_GT(world_model.integratePointCloud(generateWorldModelCloud(0, true), sensor_origin), 0u);
+  auto collision_object = world_model.getCollisionObject();
+  EXPECT_TRUE(collidesWithSphere(collision_object, 0.01, 0.01, 0.45));
+
+  // An unchanged scene does not change the map or the collision object
+  EXPECT_EQ(world_model.integratePointCloud(generateWorldModelCloud(0, true), sensor_origin), 0u);
+  EXPECT_EQ(world_model.getCollisionObject(), collision_object);
+}
+
+TEST(WorldModelTest, IntegrateMovedObject)
+{
+  grasp_planner::collision::WorldModel world_model(0.005);
+  octomap::point3d sensor_origin(0, 0, 0);
+
+  world_model.integratePointCloud(generateWorldModelCloud(0, true), sensor_origin);
+  for (int i = 0; i < 5; i++) {
+    world_model.integratePointCloud(generateWorldModelCloud(-0.06, true), sensor_origin);
+  }
+  auto collision_object = world_model.getCollisionObject();
+  // Box is seen at its new position and the table revealed behind its old position clears it
+  EXPECT_TRUE(collidesWithSphere(collision_object, -0.05, 0.01, 0.45));
+  EXPECT_FALSE(collidesWithSphere(collision_object, 0.01, 0.01, 0.45));
+}
+
+TEST(WorldModelTest, UpdateRegion)
+{
+  grasp_planner::collision::WorldModel world_model(0.005);
+  world_model.setUpdateRegion(octomap::point3d(-0.1, -0.1, 0.47), octomap::point3d(0.1, 0.1, 0.6));
+  world_model.integratePointCloud(generateWorldModelCloud(0, true), octomap::point3d(0, 0, 0));
+
+  // Box top lies outside of the update region
+  EXPECT_FALSE(collidesWithSphere(world_model.getCollisionObject(), 0.01, 0.01, 0.45));
+  EXPECT_TRUE(collidesWithSphere(world_model.getCollisionObject(), 0.05, 0.05, 0.5));
+}
+
+TEST(WorldModelTest, ResetOnSensorMotion)
+{
+  grasp_planner::collision::WorldModel world_model(0.005);
+  world_model.integratePointCloud(generateWorldModelCloud(0, true), octomap::point3d(0, 0, 0));
+  world_model.integratePointCloud(generateWorldModelCloud(0, false), octomap::point3d(0.1, 0, 0));
+  EXPECT_FALSE(collidesWithSphere(world_model.getCollisionObject(), 0.01, 0.01, 0.45));
+}